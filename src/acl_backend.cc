@@ -28,7 +28,14 @@
 #include "instance_state.h"
 #include "model_state.h"
 #include "acl_utils.h"
+#include "acl_metrics.h"
 #include "acl_engine/log.h"
+#include "acl_engine/device_scheduler.h"
+#include "acl_engine/device_allocator.h"
+#include "acl_engine/pinned_allocator.h"
+#include "acl_engine/model_residency.h"
+#include "acl_engine/engine_releaser.h"
+#include "acl_engine/load_scheduler.h"
 
 namespace triton::backend::acl
 {
@@ -83,6 +90,11 @@ namespace triton::backend::acl
             // add cmdline parse for acl backend
             std::string backend_log_file = "./triton-acl.log";
             int backend_log_level = ACL_LOG_LEVEL_INFO;
+            ACL_ENGINE::DeviceSchedConfig device_sched_config;
+            ACL_ENGINE::DeviceAllocatorConfig device_allocator_config;
+            size_t pinned_pool_bytes = 0;
+            ACL_ENGINE::ModelResidencyConfig model_residency_config;
+            ACL_ENGINE::ModelLoadConfig model_load_config;
             triton::common::TritonJson::Value cmdline;
             if (backend_config.Find("cmdline", &cmdline))
             {
@@ -112,11 +124,187 @@ namespace triton::backend::acl
                         return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, ia.what());
                     }
                 }
+
+                // device execute arbitration policy shared by all models, default is fifo
+                triton::common::TritonJson::Value sched_policy_value;
+                std::string sched_policy_value_str;
+                if (cmdline.Find("device_sched_policy", &sched_policy_value))
+                {
+                    LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("parse device_sched_policy from backend configuration")).c_str());
+                    RETURN_IF_ERROR(sched_policy_value.AsString(&sched_policy_value_str));
+                    if (0 != ACL_ENGINE::parseDeviceSchedPolicy(sched_policy_value_str, device_sched_config.policy))
+                    {
+                        return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, 
+                            (std::string("unsupported device_sched_policy ") + sched_policy_value_str + 
+                            ", expect fifo/fair_share/priority").c_str());
+                    }
+                }
+
+                // max executes in flight per device, default 0 means unlimited
+                triton::common::TritonJson::Value max_concurrency_value;
+                std::string max_concurrency_value_str;
+                if (cmdline.Find("device_max_concurrency", &max_concurrency_value))
+                {
+                    LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("parse device_max_concurrency from backend configuration")).c_str());
+                    try
+                    {
+                        RETURN_IF_ERROR(max_concurrency_value.AsString(&max_concurrency_value_str));
+                        device_sched_config.max_concurrent = std::stoi(max_concurrency_value_str);
+                    }
+                    catch (const std::invalid_argument& ia)
+                    {
+                        return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, ia.what());
+                    }
+                }
+
+                // cache device memory of engine buffers, default is true
+                triton::common::TritonJson::Value memory_cache_value;
+                std::string memory_cache_value_str;
+                if (cmdline.Find("device_memory_cache", &memory_cache_value))
+                {
+                    LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("parse device_memory_cache from backend configuration")).c_str());
+                    RETURN_IF_ERROR(memory_cache_value.AsString(&memory_cache_value_str));
+                    bool enable_cache = true;
+                    RETURN_IF_ERROR(ParseBoolValue(memory_cache_value_str, &enable_cache));
+                    device_allocator_config.enable_cache = enable_cache;
+                }
+
+                // device memory cached on every device at backend init, default 0 means no reserve
+                triton::common::TritonJson::Value memory_reserve_value;
+                std::string memory_reserve_value_str;
+                if (cmdline.Find("device_memory_reserve_mb", &memory_reserve_value))
+                {
+                    LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("parse device_memory_reserve_mb from backend configuration")).c_str());
+                    try
+                    {
+                        RETURN_IF_ERROR(memory_reserve_value.AsString(&memory_reserve_value_str));
+                        device_allocator_config.reserve_bytes = std::stoul(memory_reserve_value_str) << 20;
+                    }
+                    catch (const std::invalid_argument& ia)
+                    {
+                        return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, ia.what());
+                    }
+                }
+
+                // release cached device memory after device idle, default 0 means never
+                triton::common::TritonJson::Value memory_trim_value;
+                std::string memory_trim_value_str;
+                if (cmdline.Find("device_memory_trim_idle_ms", &memory_trim_value))
+                {
+                    LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("parse device_memory_trim_idle_ms from backend configuration")).c_str());
+                    try
+                    {
+                        RETURN_IF_ERROR(memory_trim_value.AsString(&memory_trim_value_str));
+                        device_allocator_config.trim_idle_ms = std::stoi(memory_trim_value_str);
+                    }
+                    catch (const std::invalid_argument& ia)
+                    {
+                        return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, ia.what());
+                    }
+                }
+
+                // pinned host buffers cached for input staging and output copy back, default 0 means disabled
+                triton::common::TritonJson::Value pinned_pool_value;
+                std::string pinned_pool_value_str;
+                if (cmdline.Find("pinned_memory_pool_mb", &pinned_pool_value))
+                {
+                    LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("parse pinned_memory_pool_mb from backend configuration")).c_str());
+                    try
+                    {
+                        RETURN_IF_ERROR(pinned_pool_value.AsString(&pinned_pool_value_str));
+                        pinned_pool_bytes = std::stoul(pinned_pool_value_str) << 20;
+                    }
+                    catch (const std::invalid_argument& ia)
+                    {
+                        return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, ia.what());
+                    }
+                }
+
+                // model memory budget per device, idle models over budget are evicted and reloaded on
+                // next execute, default 0 means no budget
+                triton::common::TritonJson::Value memory_budget_value;
+                std::string memory_budget_value_str;
+                if (cmdline.Find("device_memory_budget_mb", &memory_budget_value))
+                {
+                    LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("parse device_memory_budget_mb from backend configuration")).c_str());
+                    try
+                    {
+                        RETURN_IF_ERROR(memory_budget_value.AsString(&memory_budget_value_str));
+                        model_residency_config.device_budget_bytes = std::stoul(memory_budget_value_str) << 20;
+                    }
+                    catch (const std::invalid_argument& ia)
+                    {
+                        return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, ia.what());
+                    }
+                }
+
+                // model files read at same time by model loads, default 0 means unlimited
+                triton::common::TritonJson::Value io_concurrency_value;
+                std::string io_concurrency_value_str;
+                if (cmdline.Find("model_io_concurrency", &io_concurrency_value))
+                {
+                    LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("parse model_io_concurrency from backend configuration")).c_str());
+                    try
+                    {
+                        RETURN_IF_ERROR(io_concurrency_value.AsString(&io_concurrency_value_str));
+                        model_load_config.io_concurrency = std::stoi(io_concurrency_value_str);
+                    }
+                    catch (const std::invalid_argument& ia)
+                    {
+                        return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, ia.what());
+                    }
+                }
+
+                // models loaded to one device at same time, default 0 means unlimited
+                triton::common::TritonJson::Value load_concurrency_value;
+                std::string load_concurrency_value_str;
+                if (cmdline.Find("model_load_concurrency", &load_concurrency_value))
+                {
+                    LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("parse model_load_concurrency from backend configuration")).c_str());
+                    try
+                    {
+                        RETURN_IF_ERROR(load_concurrency_value.AsString(&load_concurrency_value_str));
+                        model_load_config.device_load_concurrency = std::stoi(load_concurrency_value_str);
+                    }
+                    catch (const std::invalid_argument& ia)
+                    {
+                        return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, ia.what());
+                    }
+                }
+
+                // model files waiting for io slot read ahead into page cache, default 2
+                triton::common::TritonJson::Value prefetch_count_value;
+                std::string prefetch_count_value_str;
+                if (cmdline.Find("model_prefetch_count", &prefetch_count_value))
+                {
+                    LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("parse model_prefetch_count from backend configuration")).c_str());
+                    try
+                    {
+                        RETURN_IF_ERROR(prefetch_count_value.AsString(&prefetch_count_value_str));
+                        model_load_config.prefetch_count = std::stoi(prefetch_count_value_str);
+                    }
+                    catch (const std::invalid_argument& ia)
+                    {
+                        return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, ia.what());
+                    }
+                }
             }
 
             // init backend logger
             ACL_ENGINE::AclLog::Instance().initAclLog(backend_log_file, backend_log_level);
 
+            // init device scheduler and backend metrics
+            ACL_ENGINE::DeviceScheduler::Instance().setDefaultConfig(device_sched_config);
+            ACL_ENGINE::DeviceAllocatorManager::Instance().setConfig(device_allocator_config);
+            if (0 != ACL_ENGINE::DeviceAllocatorManager::Instance().reserveAllDevices())
+            {
+                return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INTERNAL, "reserve device memory for caching allocator failed");
+            }
+            ACL_ENGINE::PinnedHostPool::Instance().setMaxCachedBytes(pinned_pool_bytes);
+            ACL_ENGINE::ModelResidencyManager::Instance().setConfig(model_residency_config);
+            ACL_ENGINE::ModelLoadScheduler::Instance().setConfig(model_load_config);
+            RETURN_IF_ERROR(AclMetrics::Instance().Initialize());
+
             return nullptr;  // success
         }
 
@@ -125,6 +313,11 @@ namespace triton::backend::acl
         //
         TRITONSERVER_Error* TRITONBACKEND_Finalize(TRITONBACKEND_Backend* backend)
         {
+            RETURN_IF_ERROR(AclMetrics::Instance().Finalize());
+            // engines released by instances are unloaded before device memory is freed
+            ACL_ENGINE::EngineReleaser::Instance().shutdown();
+            ACL_ENGINE::PinnedHostPool::Instance().shutdown();
+            ACL_ENGINE::DeviceAllocatorManager::Instance().shutdown();
             return nullptr;  // success
         }
 
@@ -192,6 +385,7 @@ namespace triton::backend::acl
             ModelInstanceState* instance_state;
             RETURN_IF_ERROR(ModelInstanceState::Create(model_state, instance, &instance_state));
             RETURN_IF_ERROR(TRITONBACKEND_ModelInstanceSetState(instance, reinterpret_cast<void*>(instance_state)));
+            model_state->InstanceLoaded();
 
             return nullptr;
         }
@@ -230,14 +424,15 @@ namespace triton::backend::acl
             RETURN_IF_ERROR(TRITONBACKEND_ModelInstanceState(instance, reinterpret_cast<void**>(&instance_state)));
             ModelState* model_state = instance_state->StateForModel();
 
-            LOG_MESSAGE(TRITONSERVER_LOG_VERBOSE, (std::string("model ") + model_state->Name() + ", instance " +
-                instance_state->Name() + ", executing " + std::to_string(request_count) + " requests").c_str());
+            LOG_VERBOSE_MESSAGE(std::string("model ") + model_state->Name() + ", instance " +
+                instance_state->Name() + ", executing " + std::to_string(request_count) + " requests");
 
             // At this point we accept ownership of 'requests', which means that
             // even if something goes wrong we must still return success from
             // this function. If something does go wrong in processing a
             // particular request then we send an error response just for the
             // specific request.
+            model_state->ReleaseModelFile();
             instance_state->ProcessRequests(requests, request_count);
 
             return nullptr;  // success
@@ -6,12 +6,33 @@
  ********************************************/
 #include <mutex>
 #include <numeric>
+#include <thread>
+#include <chrono>
+#include <pthread.h>
+#include <sched.h>
 #include "acl_engine/file_stream.h"
+#include "acl_engine/zstd_decoder.h"
+#include "acl_engine/device_scheduler.h"
+#include "acl_engine/device_allocator.h"
+#include "acl_engine/model_residency.h"
+#include "acl_engine/device_manager.h"
+#include "acl_engine/pinned_allocator.h"
 #include "acl_engine/acl_engine.h"
 
 namespace ACL_ENGINE
 {
 
+    // yield mode polls with yield before sleep backoff
+    #define ENGINE_SYNC_YIELD_POLLS            64
+    // max sleep between two polls in yield mode
+    #define ENGINE_SYNC_MAX_BACKOFF_US         50
+
+    static uint64_t getSteadyTimeNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
     static std::once_flag s_flag;
     void initAclResource()
     {
@@ -257,6 +278,8 @@ namespace ACL_ENGINE
             return;
         }
         m_status = true;
+        if (m_engine_config.warmup)
+            warmupEngine();
     }
 
     AscendCLEngine::AscendCLEngine(const EngineConfig& config, const std::vector<const char*>& model_datas, 
@@ -269,17 +292,42 @@ namespace ACL_ENGINE
             return;
         }
         m_status = true;
+        if (ModelResidencyManager::Instance().enabled())
+        {
+            // caller's buffer may be released after engine created, keep a copy for reload
+            m_model_data.assign(model_datas[0], model_datas[0] + data_lens[0]);
+        }
+        if (m_engine_config.warmup)
+            warmupEngine();
     }
 
     AscendCLEngine::~AscendCLEngine()
     {
+        // not evicted any more, model unloaded below, residency of inputs bound but never executed dropped
+        releaseResidency();
+        if (ModelResidencyManager::Instance().enabled())
+            ModelResidencyManager::Instance().unregisterEngine(m_engine_config.device_id, this);
 
-        auto ret = aclmdlUnload(m_model_id);
-        if (ACL_ERROR_NONE != ret)
+        // engine may be destroyed on a thread never run it, model and buffers are released in its context
+        if (nullptr != m_context)
+            DeviceManager::Instance().setCurrentContext(m_context);
+
+        // captured graphs reference model, destroy them before unload
+        destroyCapturedGraphs();
+
+        aclError ret = ACL_ERROR_NONE;
+        if (m_model_resident)
         {
-            ACL_LOG(ACL_LOG_LEVEL_ERROR, "unload model failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
-            assert(0);
+            ret = aclmdlUnload(m_model_id);
+            if (ACL_ERROR_NONE != ret)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "unload model failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
+                assert(0);
+            }
+            m_model_resident = false;
         }
+        // model memory is released after unload
+        releaseModelMemory();
 
         if (m_model_desc != nullptr)
         {
@@ -294,6 +342,27 @@ namespace ACL_ENGINE
         destroyInputsBuffer();
         destroyOutputsBuffer();
 
+        // log wait stream stats, compare with other sync mode to trade cpu for latency
+        if (0 < m_sync_stats.wait_count)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_INFO, "model {} sync mode {}, wait count:{}, avg wait:{}us, max wait:{}us, "
+                "avg wakeup latency:{}us, avg polls:{}", m_engine_config.model_name, m_engine_config.sync_mode, 
+                m_sync_stats.wait_count, m_sync_stats.wait_time_ns / m_sync_stats.wait_count / 1000.0, 
+                m_sync_stats.max_wait_time_ns / 1000.0, m_sync_stats.wakeup_latency_ns / m_sync_stats.wait_count / 1000.0, 
+                m_sync_stats.poll_count / m_sync_stats.wait_count);
+        }
+
+        // destroy sync event
+        if (nullptr != m_sync_event)
+        {
+            ret = aclrtDestroyEvent(m_sync_event);
+            if (ACL_ERROR_NONE != ret)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "destroy event failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
+            }
+            m_sync_event = nullptr;
+        }
+
         // destroy stream
         if (nullptr != m_stream)
         {
@@ -306,27 +375,13 @@ namespace ACL_ENGINE
             m_stream = nullptr;
         }
 
-        // destroy context
+        // release context and device, device is reset when no other engine uses it
         if (nullptr != m_context)
         {
-            ret = aclrtDestroyContext(m_context);
-            if (ACL_ERROR_NONE != ret)
-            {
-                ACL_LOG(ACL_LOG_LEVEL_ERROR, "destroy context failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
-                assert(0);
-            }
+            DeviceManager::Instance().closeDevice(m_engine_config.device_id, m_context);
             m_context = nullptr;
         }
 
-        // reset device
-        rt_ret = aclrtResetDevice(m_engine_config.device_id);
-        if (ACL_ERROR_NONE != rt_ret)
-        {
-            ACL_LOG(ACL_LOG_LEVEL_ERROR, "reset device {} failed, ret:{}, msg:{}", m_engine_config.device_id, int(ret), 
-                aclGetRecentErrMsg());
-            assert(0);
-        }
-
         // delete dynamic dims
         if (nullptr != m_dynamic_dims)
         {
@@ -343,6 +398,20 @@ namespace ACL_ENGINE
         auto& config = m_engine_config;
         ACL_LOG(ACL_LOG_LEVEL_INFO, "device_id                      : {}", config.device_id);
         ACL_LOG(ACL_LOG_LEVEL_INFO, "config file                    : {}", config.config_file);
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "model name                     : {}", config.model_name);
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "sched priority                 : {}", config.sched_priority);
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "sched weight                   : {}", config.sched_weight);
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "execute timeout ms             : {}", config.execute_timeout_ms);
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "enable graph capture           : {}", config.enable_graph_capture);
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "sync mode                      : {}", config.sync_mode);
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "sync cpu core                  : {}", config.sync_cpu_core);
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "pinned output                  : {}", config.pinned_output);
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "host numa nodes                : {}", spdlog::fmt_lib::join(config.host_numa_nodes, ","));
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "host huge pages                : {}", config.host_huge_pages);
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "workspace group                : {}", config.workspace_group);
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "share device context           : {}", config.share_device_context);
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "warmup                         : {}", config.warmup);
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "warmup iterations              : {}", config.warmup_iterations);
 
         // log input tensor infos
         for (size_t index = 0; index < m_input_infos.size(); index++)
@@ -384,6 +453,39 @@ namespace ACL_ENGINE
             return -1;
         }
 
+        // check sync mode valid
+        static const std::map<std::string, EngineSyncMode> sync_mode_map = {
+            {"blocking",     ENGINE_SYNC_MODE_BLOCKING},
+            {"spin",         ENGINE_SYNC_MODE_SPIN},
+            {"yield",        ENGINE_SYNC_MODE_YIELD}};
+        auto sync_iter = sync_mode_map.find(config.sync_mode);
+        if (sync_mode_map.end() == sync_iter)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "invalid sync mode:{}, expect blocking/spin/yield", config.sync_mode);
+            return -1;
+        }
+        m_sync_mode = sync_iter->second;
+
+        // check model load mode valid
+        if ("mmap" != config.model_load_mode && "file" != config.model_load_mode)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "invalid model load mode:{}, expect mmap/file", config.model_load_mode);
+            return -1;
+        }
+        if (0 > config.model_decompress_threads)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "invalid model decompress threads:{}, expect not negative", 
+                config.model_decompress_threads);
+            return -1;
+        }
+
+        // check warmup iterations valid
+        if (config.warmup && 0 >= config.warmup_iterations)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "invalid warmup iterations:{}, expect positive", config.warmup_iterations);
+            return -1;
+        }
+
         return 0;
     }
 
@@ -688,14 +790,7 @@ namespace ACL_ENGINE
     {
         aclError ret;
         auto free_data_buffer = [this](void *dataMemBuffer) {
-            if (!m_is_run_on_device)
-            {
-                (void)aclrtFree(dataMemBuffer);
-            }
-            else
-            {
-                (void)aclrtFreeHost(dataMemBuffer);
-            }
+            freeDeviceBuffer(dataMemBuffer);
         };
         // The model with dynamic input do not need to malloc the memory of output
         if (0 != buffer_size)
@@ -705,25 +800,10 @@ namespace ACL_ENGINE
                 ACL_LOG(ACL_LOG_LEVEL_ERROR, "data mem buffer is nullptr");
                 return false;
             }
-            if (!m_is_run_on_device)
-            {
-                ret = aclrtMalloc(data_mem_buffer, buffer_size, ACL_MEM_MALLOC_HUGE_FIRST);
-                if (ACL_ERROR_NONE != ret)
-                {
-                    ACL_LOG(ACL_LOG_LEVEL_ERROR, "malloc device buffer failed, buffer size {}, ret:{}", buffer_size, 
-                        int(ret));
-                    return false;
-                }
-            }
-            else
+            *data_mem_buffer = mallocDeviceBuffer(buffer_size);
+            if (nullptr == *data_mem_buffer)
             {
-                ret = aclrtMallocHost(data_mem_buffer, buffer_size);
-                if (ACL_ERROR_NONE != ret)
-                {
-                    ACL_LOG(ACL_LOG_LEVEL_ERROR, "malloc host buffer failed, buffer size {}, ret:{}", buffer_size, 
-                        int(ret));
-                    return false;
-                }
+                return false;
             }
         }
         auto data_buffer = aclCreateDataBuffer(*data_mem_buffer, buffer_size);
@@ -904,20 +984,274 @@ namespace ACL_ENGINE
         return true;
     }
 
-    void AscendCLEngine::destroyInputsBuffer()
+    void* AscendCLEngine::mallocDeviceBuffer(size_t buffer_size)
     {
-        for (const auto &item : m_input_infos)
+        void* buffer = nullptr;
+        if (m_is_run_on_device)
         {
-            if (item.device_data != nullptr)
+            aclError ret = aclrtMallocHost(&buffer, buffer_size);
+            if (ACL_ERROR_NONE != ret)
             {
-                if (!m_is_run_on_device)
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "malloc host buffer failed, buffer size {}, ret:{}", buffer_size, int(ret));
+                return nullptr;
+            }
+        }
+        else
+        {
+            // device buffers are cached by backend allocator, reused by next engine of the device
+            buffer = DeviceAllocatorManager::Instance().malloc(m_engine_config.device_id, buffer_size, m_stream);
+            if (nullptr == buffer)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "malloc device buffer failed, buffer size {}", buffer_size);
+                return nullptr;
+            }
+        }
+        m_device_buffer_sizes[buffer] = buffer_size;
+        accountDeviceMemory(buffer_size, true);
+        return buffer;
+    }
+
+    void AscendCLEngine::freeDeviceBuffer(void* buffer)
+    {
+        if (nullptr == buffer)
+            return;
+        auto iter = m_device_buffer_sizes.find(buffer);
+        if (m_device_buffer_sizes.end() != iter)
+        {
+            accountDeviceMemory(iter->second, false);
+            m_device_buffer_sizes.erase(iter);
+        }
+        if (m_is_run_on_device)
+        {
+            (void)aclrtFreeHost(buffer);
+            return;
+        }
+        DeviceAllocatorManager::Instance().free(m_engine_config.device_id, buffer);
+    }
+
+    void AscendCLEngine::accountDeviceMemory(size_t buffer_size, bool alloc)
+    {
+        auto& stats = m_memory_stats;
+        if (alloc)
+        {
+            stats.device_bytes += buffer_size;
+            stats.peak_device_bytes = std::max(stats.peak_device_bytes, stats.device_bytes);
+        }
+        else
+        {
+            stats.device_bytes -= std::min(stats.device_bytes, buffer_size);
+        }
+    }
+
+    void AscendCLEngine::updateHostMemoryStats()
+    {
+        auto& stats = m_memory_stats;
+        size_t host_bytes = 0;
+        for (auto& it : m_output_tensors_map)
+        {
+            if (nullptr != it.second)
+                host_bytes += it.second->capacity();
+        }
+        stats.host_bytes = host_bytes;
+        stats.peak_host_bytes = std::max(stats.peak_host_bytes, stats.host_bytes);
+    }
+
+    bool AscendCLEngine::getWarmupGears(std::vector<std::vector<std::vector<int64_t>>>& gears)
+    {
+        gears.clear();
+        // shapes of dynamic input/shape range model can't be enumerated
+        if (m_is_dynamic_input || m_is_dynamic_shape_range)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_WARN, "model {} has no compiled gears to warmup", m_engine_config.model_name);
+            return false;
+        }
+
+        std::vector<std::vector<int64_t>> input_shapes;
+        getInputShape(input_shapes);
+        auto& input_formats = m_dynamic_shape_options.input_format;
+        if (isDynamicBatchSize())
+        {
+            // batch dim of inputs is -1
+            for (auto batch_size : m_dynamic_shape_options.batch_size)
+            {
+                auto shapes = input_shapes;
+                for (auto& shape : shapes)
                 {
-                    aclrtFree(item.device_data);
+                    if (0 < shape.size() && 0 > shape[0])
+                        shape[0] = batch_size;
                 }
-                else
+                gears.push_back(shapes);
+            }
+        }
+        else if (isDynamicImageSize())
+        {
+            // height and width dims of 4 dims inputs are -1
+            for (auto& image_size : m_dynamic_shape_options.image_size)
+            {
+                auto shapes = input_shapes;
+                for (size_t index = 0; index < shapes.size(); index++)
                 {
-                    aclrtFreeHost(item.device_data);
+                    auto& shape = shapes[index];
+                    if (4 != shape.size())
+                        continue;
+                    bool is_nhwc = (index < input_formats.size() && EngineTensor::TENSOR_FORMAT_TYPE_NHWC == input_formats[index]);
+                    size_t height_index = is_nhwc ? 1 : 2;
+                    if (0 > shape[height_index])
+                        shape[height_index] = image_size.first;
+                    if (0 > shape[height_index + 1])
+                        shape[height_index + 1] = image_size.second;
+                }
+                gears.push_back(shapes);
+            }
+        }
+        else if (isDynamicDims())
+        {
+            // gear dims are all inputs dims in order, or only the unknown dims of them
+            size_t total_dim_num = 0;
+            for (auto& shape : input_shapes)
+                total_dim_num += shape.size();
+            auto& dynamic_dims = m_dynamic_shape_options.dynamic_dims;
+            for (size_t gear = 0; gear < dynamic_dims.second; gear++)
+            {
+                auto& gear_dims = dynamic_dims.first[gear];
+                bool all_dims = (total_dim_num == gear_dims.dimCount);
+                auto shapes = input_shapes;
+                size_t dim_index = 0;
+                for (auto& shape : shapes)
+                {
+                    for (auto& dim : shape)
+                    {
+                        if ((all_dims || 0 > dim) && dim_index < gear_dims.dimCount)
+                            dim = gear_dims.dims[dim_index++];
+                    }
                 }
+                gears.push_back(shapes);
+            }
+        }
+        else
+            gears.push_back(input_shapes);
+
+        // drop gears still having unknown dims
+        auto iter = std::remove_if(gears.begin(), gears.end(), [](const std::vector<std::vector<int64_t>>& shapes) {
+            return std::any_of(shapes.begin(), shapes.end(), [](const std::vector<int64_t>& shape) {
+                return std::any_of(shape.begin(), shape.end(), [](int64_t dim) { return 0 > dim; });
+            });
+        });
+        if (gears.end() != iter)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_WARN, "model {} skip {} gears with unknown dims when warmup", 
+                m_engine_config.model_name, std::distance(iter, gears.end()));
+            gears.erase(iter, gears.end());
+        }
+        return 0 != gears.size();
+    }
+
+    void AscendCLEngine::warmupEngine()
+    {
+        // first execute of each gear creates descriptors and runtime resources, do it before requests arrive
+        std::vector<std::vector<std::vector<int64_t>>> gears;
+        if (!getWarmupGears(gears))
+            return;
+
+        auto& input_formats = m_dynamic_shape_options.input_format;
+        int iterations = m_engine_config.warmup_iterations;
+        size_t warmup_gears = 0;
+        uint64_t warmup_start_ns = getSteadyTimeNs();
+        for (auto& shapes : gears)
+        {
+            std::string shapes_str;
+            for (auto& shape : shapes)
+                shapes_str += ("" == shapes_str ? "" : ";") + spdlog::fmt_lib::format("{}", spdlog::fmt_lib::join(shape, "x"));
+
+            // zero filled synthetic inputs of model input data types
+            std::vector<std::shared_ptr<EngineTensor>> inputs;
+            std::map<std::string, EngineTensor*> input_tensors_map;
+            for (size_t index = 0; index < m_data_input_num; index++)
+            {
+                auto& input_info = m_input_infos[index];
+                auto dtype = convertAscendCLTypeToTensorType(input_info.data_type);
+                auto format = (index < input_formats.size()) ? input_formats[index] : EngineTensor::TENSOR_FORMAT_TYPE_NCHW;
+                std::shared_ptr<EngineTensor> input(EngineTensor::create(shapes[index], dtype, format));
+                if (nullptr == input || nullptr == input->host<void>() || 0 > input->size())
+                {
+                    ACL_LOG(ACL_LOG_LEVEL_WARN, "model {} create warmup input {} fail", m_engine_config.model_name, 
+                        input_info.name);
+                    inputs.clear();
+                    break;
+                }
+                memset(input->host<void>(), 0, input->size());
+                input_tensors_map[input_info.name] = input.get();
+                inputs.push_back(input);
+            }
+            if (0 == inputs.size() || 0 != setEngineInputTensors(input_tensors_map))
+            {
+                ACL_LOG(ACL_LOG_LEVEL_WARN, "model {} set warmup inputs of gear {} fail", m_engine_config.model_name, 
+                    shapes_str);
+                continue;
+            }
+
+            // executes fill shape plan caches, captured graphs and output buffers of this gear
+            uint64_t first_ns = 0;
+            uint64_t total_ns = 0;
+            int run_count = 0;
+            for (; run_count < iterations; run_count++)
+            {
+                uint64_t start_ns = getSteadyTimeNs();
+                if (0 != runEngine())
+                    break;
+                uint64_t run_ns = getSteadyTimeNs() - start_ns;
+                if (0 == run_count)
+                    first_ns = run_ns;
+                total_ns += run_ns;
+            }
+            if (run_count < iterations)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_WARN, "model {} warmup gear {} execute fail", m_engine_config.model_name, shapes_str);
+                continue;
+            }
+            warmup_gears++;
+            ACL_LOG(ACL_LOG_LEVEL_INFO, "model {} warmup gear {}, first execute:{}us, avg execute:{}us", 
+                m_engine_config.model_name, shapes_str, first_ns / 1000.0, total_ns / run_count / 1000.0);
+        }
+
+        // synthetic inputs are released, requests bind their own inputs before execute
+        m_input_tensors_map.clear();
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "model {} warmup {}/{} gears on device {} in {}ms", m_engine_config.model_name, 
+            warmup_gears, gears.size(), m_engine_config.device_id, (getSteadyTimeNs() - warmup_start_ns) / 1000000.0);
+    }
+
+    int AscendCLEngine::getDeviceMemoryInfo(std::map<int, DeviceMemoryInfo>& infos)
+    {
+        auto device_id = m_engine_config.device_id;
+        auto& info = infos[device_id];
+        if (!m_is_run_on_device)
+        {
+            if (0 != DeviceManager::Instance().setCurrentContext(m_context))
+                return -1;
+            auto ret = aclrtGetMemInfo(ACL_HBM_MEM, &info.free_bytes, &info.total_bytes);
+            if (ACL_ERROR_NONE != ret)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "get device {} memory info failed, ret:{}", device_id, int(ret));
+                return -1;
+            }
+        }
+        DeviceAllocatorStats allocator_stats;
+        if (0 == DeviceAllocatorManager::Instance().getStats(device_id, allocator_stats))
+        {
+            info.allocated_bytes = allocator_stats.allocated_bytes;
+            info.cached_bytes = allocator_stats.cached_bytes;
+            info.peak_allocated_bytes = allocator_stats.peak_allocated_bytes;
+        }
+        return 0;
+    }
+
+    void AscendCLEngine::destroyInputsBuffer()
+    {
+        for (const auto &item : m_input_infos)
+        {
+            if (item.device_data != nullptr)
+            {
+                freeDeviceBuffer(item.device_data);
             }
             if (nullptr != item.dynamic_acl_tensor_desc)
             {
@@ -947,14 +1281,7 @@ namespace ACL_ENGINE
             {
                 if (item.device_data != nullptr)
                 {
-                    if (!m_is_run_on_device)
-                    {
-                        aclrtFree(item.device_data);
-                    }
-                    else
-                    {
-                        aclrtFreeHost(item.device_data);
-                    }
+                    freeDeviceBuffer(item.device_data);
                 }
             }
         }
@@ -973,30 +1300,252 @@ namespace ACL_ENGINE
         m_output_dataset = nullptr;
     }
 
-    int AscendCLEngine::initAclModelFromBuffer(const char* model_data, const size_t& data_len, const EngineConfig& acl_config)
+    int AscendCLEngine::loadModelWithSharedWorkspace(const char* model_data, const size_t& data_len)
     {
-
-        // set device 
         auto device_id = m_engine_config.device_id;
-        aclError ret = aclrtSetDevice(device_id);
+        auto ret = aclmdlQuerySizeFromMem(model_data, data_len, &m_work_size, &m_weight_size);
+        if (ACL_ERROR_NONE != ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "query acl model memory size failed, ret:{}, msg:{}", int(ret), 
+                aclGetRecentErrMsg());
+            return -1;
+        }
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "model {} work size:{}, weight size:{}, workspace group:{}", 
+            m_engine_config.model_name, m_work_size, m_weight_size, m_engine_config.workspace_group);
+
+        m_workspace = WorkspaceManager::Instance().acquire(device_id, m_engine_config.workspace_group, m_work_size);
+        if (nullptr == m_workspace)
+            return -1;
+        m_memory_stats.model_bytes = m_weight_size;
+        m_memory_stats.workspace_bytes = m_workspace->size;
+        if (0 < m_weight_size)
+        {
+            m_weight_ptr = DeviceAllocatorManager::Instance().malloc(device_id, m_weight_size, nullptr);
+            if (nullptr == m_weight_ptr)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "malloc weight memory of {} bytes failed", m_weight_size);
+                return -1;
+            }
+        }
+
+        ret = aclmdlLoadFromMemWithMem(model_data, data_len, &m_model_id, m_workspace->ptr, m_workspace->size, 
+            m_weight_ptr, m_weight_size);
         if (ACL_ERROR_NONE != ret)
         {
-            ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl set device:{} failed, ret:{}, msg:{}", device_id, int(ret), 
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "load acl model with memory failed, ret:{}, msg:{}", int(ret), 
                 aclGetRecentErrMsg());
             return -1;
         }
+        return 0;
+    }
+
+    void AscendCLEngine::releaseModelMemory()
+    {
+        if (nullptr != m_weight_ptr)
+        {
+            DeviceAllocatorManager::Instance().free(m_engine_config.device_id, m_weight_ptr);
+            m_weight_ptr = nullptr;
+        }
+        if (nullptr != m_workspace)
+        {
+            WorkspaceManager::Instance().detach(m_workspace, m_work_size);
+            m_workspace.reset();
+        }
+    }
+
+    int AscendCLEngine::loadAclModel(const char* model_data, const size_t& data_len)
+    {
+        // models loaded to same device at same time are limited by load scheduler
+        ModelLoadGuard load_guard(m_engine_config.device_id);
+        // work memory is shared when model is in a workspace group
+        if ("" != m_engine_config.workspace_group)
+        {
+            if (0 != loadModelWithSharedWorkspace(model_data, data_len))
+                return -1;
+        }
+        else
+        {
+            auto ret = aclmdlLoadFromMem(model_data, data_len, &m_model_id);
+            if (ACL_ERROR_NONE != ret)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "load acl model failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
+                return -1;
+            }
+            // memory malloced by acl for the model, used for memory stats and device budget
+            size_t work_size = 0;
+            size_t weight_size = 0;
+            if (ACL_ERROR_NONE == aclmdlQuerySizeFromMem(model_data, data_len, &work_size, &weight_size))
+                m_memory_stats.model_bytes = work_size + weight_size;
+        }
+        m_model_resident = true;
+        m_load_stats.load_count++;
+        m_load_stats.device_queue_time_ns += load_guard.queueTimeNs();
+        m_load_stats.load_time_ns += load_guard.elapsedNs();
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "model {} loaded to device {}, device queue:{}us, load:{}us", 
+            m_engine_config.model_name, m_engine_config.device_id, load_guard.queueTimeNs() / 1000.0, 
+            load_guard.elapsedNs() / 1000.0);
+        return 0;
+    }
 
-        // create context
-        ret = aclrtCreateContext(&m_context, device_id);
+    int AscendCLEngine::loadAclModelFromFile(const std::string& model_file)
+    {
+        // acl reads om file itself, no host copy of model in this process,
+        // model of workspace group is loaded from mapped file for its memory size query,
+        // compressed om file is always decompressed by file stream
+        if ("file" == m_engine_config.model_load_mode && "" == m_engine_config.workspace_group && !isZstdFile(model_file))
+        {
+            // acl reads file during load, both io slot and device load slot are held
+            ModelReadGuard read_guard(model_file);
+            ModelLoadGuard load_guard(m_engine_config.device_id);
+            auto ret = aclmdlLoadFromFile(model_file.c_str(), &m_model_id);
+            if (ACL_ERROR_NONE != ret)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "load acl model from file {} failed, ret:{}, msg:{}", model_file, 
+                    int(ret), aclGetRecentErrMsg());
+                return -1;
+            }
+            size_t work_size = 0;
+            size_t weight_size = 0;
+            if (ACL_ERROR_NONE == aclmdlQuerySize(model_file.c_str(), &work_size, &weight_size))
+                m_memory_stats.model_bytes = work_size + weight_size;
+            m_model_resident = true;
+            FileStamp stamp;
+            if (0 == statFileStamp(model_file, stamp))
+                m_load_stats.file_bytes += stamp.size;
+            m_load_stats.load_count++;
+            m_load_stats.io_queue_time_ns += read_guard.queueTimeNs();
+            m_load_stats.device_queue_time_ns += load_guard.queueTimeNs();
+            m_load_stats.load_time_ns += load_guard.elapsedNs();
+            ACL_LOG(ACL_LOG_LEVEL_INFO, "model {} loaded from file {} to device {}, io queue:{}us, device queue:{}us, "
+                "load:{}us", m_engine_config.model_name, model_file, m_engine_config.device_id, 
+                read_guard.queueTimeNs() / 1000.0, load_guard.queueTimeNs() / 1000.0, load_guard.elapsedNs() / 1000.0);
+            return 0;
+        }
+
+        // mapping is shared with other engines loading same file, e.g. instances pinned it by model state
+        std::shared_ptr<FileInputStream> file_stream;
+        {
+            // with io throttled, mapped file is read in while holding io slot, acl loads it from memory then
+            ModelReadGuard read_guard(model_file);
+            FileMapConfig map_config;
+            map_config.populate = m_engine_config.model_map_populate || 
+                (ModelLoadScheduler::Instance().throttleIo() && 0 >= m_engine_config.model_prefault_threads);
+            map_config.prefault_threads = m_engine_config.model_prefault_threads;
+            map_config.decompress_threads = m_engine_config.model_decompress_threads;
+            file_stream = MappedFileCache::Instance().acquire(model_file, map_config);
+            if (nullptr == file_stream)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl engine open file {} fail", model_file);
+                return -1;
+            }
+            m_load_stats.file_bytes += file_stream->getFileSize();
+            m_load_stats.io_queue_time_ns += read_guard.queueTimeNs();
+            m_load_stats.read_time_ns += read_guard.elapsedNs();
+            ACL_LOG(ACL_LOG_LEVEL_INFO, "model {} file {} of {} bytes mapped, io queue:{}us, read:{}us", 
+                m_engine_config.model_name, model_file, file_stream->getFileSize(), read_guard.queueTimeNs() / 1000.0, 
+                read_guard.elapsedNs() / 1000.0);
+        }
+        int ret = loadAclModel(file_stream->getFileData(), file_stream->getFileSize());
+        // acl has copied model, drop mapping right now instead of keeping it during engine init,
+        // it is unmapped here unless other holders still use it
+        file_stream.reset();
+        return ret;
+    }
+
+    int AscendCLEngine::offloadModel()
+    {
+        if (!m_model_resident)
+            return 0;
+        auto start = std::chrono::steady_clock::now();
+        if (0 != DeviceManager::Instance().setCurrentContext(m_context))
+            return -1;
+
+        // captured graphs reference model, destroy them before unload, io buffers are kept
+        destroyCapturedGraphs();
+        auto ret = aclmdlUnload(m_model_id);
         if (ACL_ERROR_NONE != ret)
         {
-            ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl create context failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "unload model failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
+            return -1;
+        }
+        releaseModelMemory();
+        m_model_id = UINT32_MAX;
+        m_model_resident = false;
+
+        uint64_t cost_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        m_residency_stats.evict_count++;
+        m_residency_stats.evict_time_ns += cost_ns;
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "evict model {} from device {}, model bytes:{}, cost:{}us", 
+            m_engine_config.model_name, m_engine_config.device_id, m_memory_stats.model_bytes, cost_ns / 1000.0);
+        return 0;
+    }
+
+    int AscendCLEngine::reloadModel()
+    {
+        if (m_model_resident)
+            return 0;
+        auto start = std::chrono::steady_clock::now();
+        if (0 != DeviceManager::Instance().setCurrentContext(m_context))
+            return -1;
+
+        // model desc and io buffers are kept while evicted, only model itself is loaded again
+        if (m_model_files.empty() && m_model_data.empty())
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "model {} has no model data to reload", m_engine_config.model_name);
+            return -1;
+        }
+        int load_ret = m_model_files.empty() ? loadAclModel(m_model_data.data(), m_model_data.size()) : 
+            loadAclModelFromFile(m_model_files[0]);
+        if (0 != load_ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "reload model {} fail", m_engine_config.model_name);
+            return -1;
+        }
+
+        uint64_t cost_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        m_residency_stats.reload_count++;
+        m_residency_stats.reload_time_ns += cost_ns;
+        m_residency_stats.max_reload_time_ns = std::max(m_residency_stats.max_reload_time_ns, cost_ns);
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "reload model {} on device {}, model bytes:{}, cost:{}us", 
+            m_engine_config.model_name, m_engine_config.device_id, m_memory_stats.model_bytes, cost_ns / 1000.0);
+        return 0;
+    }
+
+    size_t AscendCLEngine::queryModelBytes(const char* model_data, const size_t& data_len, const std::string& model_file)
+    {
+        // compressed om file can not be queried before decompress, model bytes is known after load then
+        if ("" != model_file && isZstdFile(model_file))
+            return 0;
+        size_t work_size = 0;
+        size_t weight_size = 0;
+        auto ret = ("" != model_file) ? aclmdlQuerySize(model_file.c_str(), &work_size, &weight_size) : 
+            aclmdlQuerySizeFromMem(model_data, data_len, &work_size, &weight_size);
+        if (ACL_ERROR_NONE != ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_WARN, "query model {} memory size before load failed, ret:{}", 
+                m_engine_config.model_name, int(ret));
+            return 0;
+        }
+        // work memory of workspace group is shared and not counted as model memory
+        return ("" != m_engine_config.workspace_group) ? weight_size : work_size + weight_size;
+    }
+
+    int AscendCLEngine::initAclModel(const char* model_data, const size_t& data_len, const std::string& model_file)
+    {
+
+        // open device and get context, engines of a device share context unless configured not to
+        auto device_id = m_engine_config.device_id;
+        if (0 != DeviceManager::Instance().openDevice(device_id, m_engine_config.share_device_context, m_context))
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl open device:{} failed", device_id);
             return -1;
         }
 
         // get run mode stream
         aclrtRunMode run_mode;
-        ret = aclrtGetRunMode(&run_mode);
+        aclError ret = aclrtGetRunMode(&run_mode);
         if (ACL_ERROR_NONE != ret)
         {
             ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl get run mode failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
@@ -1014,20 +1563,21 @@ namespace ACL_ENGINE
         }
 
         // set context
-        ret = aclrtSetCurrentContext(m_context);
-        if (ACL_ERROR_NONE != ret)
-        {
-            ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl set context failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
+        if (0 != DeviceManager::Instance().setCurrentContext(m_context))
             return -1;
-        }
 
-        // load model from memory
-        ret = aclmdlLoadFromMem(model_data, data_len, &m_model_id);
-        if (ACL_ERROR_NONE != ret)
+        // load model from om file or memory, under device budget room is made for model before load
+        bool residency_enabled = ModelResidencyManager::Instance().enabled();
+        if (residency_enabled)
         {
-            ACL_LOG(ACL_LOG_LEVEL_ERROR, "load acl model failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
-            return -1;
+            ModelResidencyManager::Instance().beginLoad(device_id, this, 
+                queryModelBytes(model_data, data_len, model_file));
         }
+        int load_ret = ("" != model_file) ? loadAclModelFromFile(model_file) : loadAclModel(model_data, data_len);
+        if (residency_enabled)
+            ModelResidencyManager::Instance().endLoad(device_id, this, 0 == load_ret);
+        if (0 != load_ret)
+            return -1;
 
         // create model desc
         m_model_desc = aclmdlCreateDesc();
@@ -1136,35 +1686,22 @@ namespace ACL_ENGINE
             ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl engine expect 1 model files, but get {} files", model_files.size());
             return -1;
         }
+        if (ModelResidencyManager::Instance().enabled())
+            m_model_files = model_files;
 
-        std::vector<std::shared_ptr<FileInputStream>> file_streams;
-        std::vector<const char *> model_datas;
-        std::vector<size_t> data_lens;
-        for (size_t i = 0; i < model_files.size(); i++)
+        // om file is mapped only while acl loads model, or read by acl directly
+        if (0 != checkEngineConfig(config))
         {
-            std::shared_ptr<FileInputStream> file_stream(new FileInputStream(model_files[i]));
-            if (nullptr == file_stream.get() || !file_stream->isOpen())
-            {
-                ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl engine open file {} fail", model_files[i]);
-                return -1;
-            }
-            const char *file_data = file_stream->getFileData();
-            size_t file_len = file_stream->getFileSize();
-            if (nullptr == file_data)
-            {
-                ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl engine get file {} data fail", model_files[i]);
-                return -1;
-            }
-            model_datas.emplace_back(file_data);
-            data_lens.emplace_back(file_len);
-            file_streams.emplace_back(file_stream);
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "check acl engine config fail");
+            return -1;
         }
-
-        if (0 != loadModelFromBuffer(config, model_datas, data_lens))
+        m_engine_config = config;
+        if (0 != initAclModel(nullptr, 0, model_files[0]))
         {
             ACL_LOG(ACL_LOG_LEVEL_INFO, "acl engine init from file {} fail", model_files[0]);
             return -1;
         }
+        printEngineInfo();
         ACL_LOG(ACL_LOG_LEVEL_INFO, "acl engine init from file {} success", model_files[0]);
         return 0;
     }
@@ -1181,7 +1718,7 @@ namespace ACL_ENGINE
         if (0 == checkEngineConfig(config))
         {
             m_engine_config = config;
-            if (0 != initAclModelFromBuffer(model_datas[0], data_lens[0], m_engine_config))
+            if (0 != initAclModel(model_datas[0], data_lens[0], ""))
             {
                 ACL_LOG(ACL_LOG_LEVEL_ERROR, "init acl model fail");
                 return -1;
@@ -1213,19 +1750,54 @@ namespace ACL_ENGINE
             return -1;
         }
 
-        // construct new shapes map
-        std::map<std::string, std::vector<int64_t>> new_shapes;
+        // reload model if evicted before resize and binding, held until execute of these inputs finished
+        if (!acquireResidency())
+            return -1;
+        if (0 != bindInputTensors(input_tensors_map))
+        {
+            releaseResidency();
+            return -1;
+        }
+        return 0;
+    }
+
+    bool AscendCLEngine::acquireResidency()
+    {
+        if (m_residency_held || !ModelResidencyManager::Instance().enabled())
+            return true;
+        if (0 != ModelResidencyManager::Instance().acquire(m_engine_config.device_id, this))
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "model {} is not resident on device {}", m_engine_config.model_name, 
+                m_engine_config.device_id);
+            return false;
+        }
+        m_residency_held = true;
+        return true;
+    }
+
+    void AscendCLEngine::releaseResidency()
+    {
+        if (!m_residency_held)
+            return;
+        ModelResidencyManager::Instance().release(m_engine_config.device_id, this);
+        m_residency_held = false;
+    }
+
+    int AscendCLEngine::bindInputTensors(std::map<std::string, EngineTensor*>& input_tensors_map)
+    {
+        // construct new shapes map, nodes and shape vectors of last run are reused
+        auto& new_shapes = m_new_shapes;
         for (auto index = 0; index < m_data_input_num; index++)
         {
             auto& input = m_input_infos[index];
-            std::string input_name = input.name;
-            if (input_tensors_map.find(input_name) == input_tensors_map.end())
+            const std::string& input_name = input.name;
+            auto tensor_iter = input_tensors_map.find(input_name);
+            if (input_tensors_map.end() == tensor_iter)
             {
                 ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl engine input tensors map cannot find tensor: {}", input_name);
                 return -1;
             }
-            std::vector<int64_t>& input_shape = input_tensors_map[input_name]->shape();
-            new_shapes[input_name] = input_shape;
+            new_shapes[input_name] = tensor_iter->second->buffer().dim;
         }
 
         // if input tensor shape not equal to acl engine shape, need to resize acl engine
@@ -1238,15 +1810,35 @@ namespace ACL_ENGINE
         // set input tensors
         for (auto& it : input_tensors_map)
         {
-            std::string tensor_name = it.first;
+            const std::string& tensor_name = it.first;
             auto& input_tensor = it.second;
             auto tensor_dtype = input_tensor->getTensorDataType();
             auto tensor_format = input_tensor->getTensorFormatType();
-            auto tensor_shape = input_tensor->shape();
+            const auto& tensor_shape = input_tensor->buffer().dim;
             void* tensor_data = input_tensor->host<void>();
+            // device tensor from upstream acl model is bound to input dataset directly
+            void* tensor_device_data = (void*)input_tensor->devicePtr();
+            if (nullptr == tensor_data && nullptr == tensor_device_data)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl engine input tensor {} has no host or device data", tensor_name);
+                return -1;
+            }
+            // input slot keeps its wrapper tensor, only rebind data and shape of current request
+            auto slot_iter = m_input_tensors_map.find(tensor_name);
+            if (m_input_tensors_map.end() != slot_iter && false == slot_iter->second->buffer().own_flag)
+            {
+                auto& slot_buffer = slot_iter->second->buffer();
+                slot_buffer.host = tensor_data;
+                slot_buffer.device = (uint64_t)tensor_device_data;
+                slot_buffer.device_id = input_tensor->deviceId();
+                slot_buffer.dim = tensor_shape;
+                slot_buffer.type = tensor_dtype;
+                slot_buffer.format = tensor_format;
+                continue;
+            }
             std::shared_ptr<EngineTensor> temp_tensor;
-            temp_tensor.reset(EngineTensor::create(tensor_shape, tensor_dtype, tensor_format, tensor_data));
-            if (nullptr == temp_tensor.get() || nullptr == temp_tensor->host<void>())
+            temp_tensor.reset(EngineTensor::clone(input_tensor, false));
+            if (nullptr == temp_tensor.get())
             {
                 ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl engine create input engine tensor {} fail", tensor_name);
                 return -1;
@@ -1266,14 +1858,14 @@ namespace ACL_ENGINE
             return -1;
         }
 
-        // clear history
-        output_tensors_map.clear();
+        // clear history, map nodes are kept when outputs not changed, caller may reuse the map across runs
+        if (output_tensors_map.size() != m_output_tensors_map.size())
+            output_tensors_map.clear();
 
         // get output tensors from model
         for (auto& it : m_output_tensors_map)
         {
-            std::string tensor_name = it.first;
-            output_tensors_map[tensor_name] = m_output_tensors_map[tensor_name].get();
+            output_tensors_map[it.first] = it.second.get();
         }
         return 0;
     }
@@ -1288,26 +1880,22 @@ namespace ACL_ENGINE
         }
 
         // set current context
-        auto ret = aclrtSetCurrentContext(m_context);
-        if (ACL_ERROR_NONE != ret)
-        {
-            ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl set context failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
+        if (0 != DeviceManager::Instance().setCurrentContext(m_context))
             return -1;
-        }
 
-        // construct new shape list
-        std::vector<std::vector<int64_t>> new_shape_list;
+        // construct new shape list, shape vectors of last run keep their capacity
+        auto& new_shape_list = m_new_shape_list;
+        new_shape_list.resize(m_data_input_num);
         for (auto index = 0; index < m_data_input_num; index++)
         {
             auto& input = m_input_infos[index];
-            std::string input_name = input.name;
-            if (new_shapes.find(input_name) == new_shapes.end())
+            auto shape_iter = new_shapes.find(input.name);
+            if (new_shapes.end() == shape_iter)
             {
-                ACL_LOG(ACL_LOG_LEVEL_ERROR, "input tensor shapes map cannot find tensor: {}", input_name);
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "input tensor shapes map cannot find tensor: {}", input.name);
                 return -1;
             }
-            std::vector<int64_t> input_shape = new_shapes[input_name];
-            new_shape_list.emplace_back(input_shape);
+            new_shape_list[index] = shape_iter->second;
         }
 
         // acl model resize with shape list
@@ -1329,26 +1917,46 @@ namespace ACL_ENGINE
             return false;
         }
 
-        // set current context
-        auto ret = aclrtSetCurrentContext(m_context);
-        if (ACL_ERROR_NONE != ret)
+        // reload model if evicted by device memory budget, not evicted until execute finished, residency
+        // taken when inputs were bound is handed over to guard
+        ModelResidencyGuard residency_guard(m_engine_config.device_id, this);
+        releaseResidency();
+        if (!residency_guard.resident())
         {
-            ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl set context failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "model {} is not resident on device {}", m_engine_config.model_name, 
+                m_engine_config.device_id);
             return -1;
         }
 
-        // get input tensors
-        std::vector<EngineTensor*> input_tensors;
+        // set current context
+        if (0 != DeviceManager::Instance().setCurrentContext(m_context))
+            return -1;
+
+        // stream not recovered after last execute timeout, execute is rejected until it is recovered
+        if (m_stream_broken)
+        {
+            m_stream_broken = !recoverStream();
+            if (m_stream_broken)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "stream of model {} on device {} is broken, execute rejected", 
+                    m_engine_config.model_name, m_engine_config.device_id);
+                return -1;
+            }
+        }
+
+        // get input tensors, list of last run is reused
+        auto& input_tensors = m_run_input_tensors;
+        input_tensors.clear();
         for (auto index = 0; index < m_data_input_num; index++)
         {
             auto& input = m_input_infos[index];
-            std::string input_name = input.name;
-            if (m_input_tensors_map.find(input_name) == m_input_tensors_map.end())
+            auto tensor_iter = m_input_tensors_map.find(input.name);
+            if (m_input_tensors_map.end() == tensor_iter)
             {
-                ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl engine input tensors map cannot find tensor: {}", input_name);
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl engine input tensors map cannot find tensor: {}", input.name);
                 return -1;
             }
-            input_tensors.emplace_back(m_input_tensors_map[input_name].get());
+            input_tensors.emplace_back(tensor_iter->second.get());
         }
 
         // check and init input tensors
@@ -1358,19 +1966,20 @@ namespace ACL_ENGINE
             return false;
         }
 
-        // get output tensors
-        std::vector<std::shared_ptr<EngineTensor>> output_tensors;
+        // get output tensors, list of last run is reused
+        auto& output_tensors = m_run_output_tensors;
+        output_tensors.clear();
         for (auto index = 0; index < m_output_infos.size(); index++)
         {
             auto& output = m_output_infos[index];
-            std::string output_name = output.name;
-            if (m_output_tensors_map.find(output_name) == m_output_tensors_map.end())
+            auto tensor_iter = m_output_tensors_map.find(output.name);
+            if (m_output_tensors_map.end() == tensor_iter)
             {
-                // ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl engine output tensors map cannot find tensor: {}", output_name);
+                // ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl engine output tensors map cannot find tensor: {}", output.name);
                 // return -1;
                 continue;
             }
-            output_tensors.emplace_back(m_output_tensors_map[output_name]);
+            output_tensors.emplace_back(tensor_iter->second);
         }
 
         // check and init output tensors
@@ -1380,8 +1989,28 @@ namespace ACL_ENGINE
             return false;
         }
 
-        // model execute
-        auto ret = aclmdlExecute(m_model_id, m_input_dataset, m_output_dataset);
+        // model execute, submit to device scheduler and wait for our turn on the device,
+        // models of a workspace group also wait until no other member is executing
+        aclError ret = ACL_ERROR_NONE;
+        {
+            std::unique_lock<std::mutex> workspace_lock;
+            if (nullptr != m_workspace)
+                workspace_lock = std::unique_lock<std::mutex>(m_workspace->execute_mutex);
+            DeviceExecuteGuard execute_guard(m_engine_config.device_id, m_engine_config.model_name,
+                m_engine_config.sched_priority, m_engine_config.sched_weight);
+            m_last_queue_time_ns = execute_guard.queueTimeNs();
+            // acl malloc dynamic outputs every execute, cannot replay with captured buffers
+            if (m_engine_config.enable_graph_capture && m_graph_capture_supported && !m_is_dynamic_output)
+                ret = executeWithGraph();
+            else
+                ret = executeDirect();
+        }
+        if (ACL_ERROR_RT_STREAM_SYNC_TIMEOUT == ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "execute model {} timeout after {} ms, total timeout count:{}", 
+                m_engine_config.model_name, m_engine_config.execute_timeout_ms, m_execute_timeout_count);
+            return -1;
+        }
         if (ACL_ERROR_NONE != ret)
         {
             ACL_LOG(ACL_LOG_LEVEL_ERROR, "execute model failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
@@ -1391,7 +2020,6 @@ namespace ACL_ENGINE
         // reset dynamic output tensors
         if (m_is_dynamic_output)
         {
-            output_tensors.clear();
             bool ret = resetDynamicOutputTensor(output_tensors);
             if (!ret)
             {
@@ -1411,9 +2039,9 @@ namespace ACL_ENGINE
         for (auto index = 0; index < m_output_infos.size(); index++)
         {
             auto& output = m_output_infos[index];
-            std::string output_name = output.name;
-            m_output_tensors_map[output_name] = output_tensors[index];
+            m_output_tensors_map[output.name] = output_tensors[index];
         }
+        updateHostMemoryStats();
 
         // The device_data is malloced by acl, user need to free the addr
         if (m_is_dynamic_output)
@@ -1424,6 +2052,324 @@ namespace ACL_ENGINE
         return 0;
     }
 
+    aclError AscendCLEngine::executeDirect()
+    {
+        // execute async and wait stream in every sync mode, so wait stats of all modes can be compared,
+        // blocking mode waits by stream synchronize instead of blocking inside aclmdlExecute
+        return executeAsync();
+    }
+
+    aclError AscendCLEngine::executeAsync()
+    {
+        // async execute on engine stream, then wait stream with sync mode and timeout
+        auto ret = aclmdlExecuteAsync(m_model_id, m_input_dataset, m_output_dataset, m_stream);
+        if (ACL_ERROR_NONE != ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "async execute model failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
+            return ret;
+        }
+        return synchronizeStream();
+    }
+
+    aclError AscendCLEngine::synchronizeStream()
+    {
+        aclError ret;
+        uint64_t start_ns = getSteadyTimeNs();
+        if (ENGINE_SYNC_MODE_BLOCKING != m_sync_mode)
+            ret = pollStream();
+        else if (0 >= m_engine_config.execute_timeout_ms)
+            ret = aclrtSynchronizeStream(m_stream);
+        else
+            ret = aclrtSynchronizeStreamWithTimeout(m_stream, m_engine_config.execute_timeout_ms);
+        uint64_t wait_ns = getSteadyTimeNs() - start_ns;
+        m_sync_stats.wait_count++;
+        m_sync_stats.wait_time_ns += wait_ns;
+        m_sync_stats.max_wait_time_ns = std::max(m_sync_stats.max_wait_time_ns, wait_ns);
+        if (ACL_ERROR_RT_STREAM_SYNC_TIMEOUT != ret)
+            return ret;
+
+        // pending task still occupy the stream, recover it so following executes are not blocked,
+        // stream failed to recover is recovered again by next execute
+        m_execute_timeout_count++;
+        m_stream_broken = !recoverStream();
+        if (m_stream_broken)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "recover stream after execute timeout fail, retry on next execute");
+        }
+        return ret;
+    }
+
+    bool AscendCLEngine::pinSyncThread(cpu_set_t& saved_cpu_set)
+    {
+        // polling thread may be triton's instance thread, pipeline worker or shard pool thread,
+        // it is pinned during wait only, previous affinity is saved for unpinSyncThread
+        int cpu_core = m_engine_config.sync_cpu_core;
+        if (0 > cpu_core || m_sync_pin_failed)
+            return false;
+        int ret = pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &saved_cpu_set);
+        if (0 == ret)
+        {
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            CPU_SET(cpu_core, &cpu_set);
+            ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set);
+        }
+        if (0 != ret)
+        {
+            // do not retry on every execute
+            ACL_LOG(ACL_LOG_LEVEL_WARN, "pin sync thread to cpu core {} fail, ret:{}", cpu_core, ret);
+            m_sync_pin_failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    void AscendCLEngine::unpinSyncThread(const cpu_set_t& saved_cpu_set)
+    {
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &saved_cpu_set);
+        if (0 != ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_WARN, "restore sync thread cpu affinity fail, ret:{}", ret);
+        }
+    }
+
+    aclError AscendCLEngine::pollStream()
+    {
+        cpu_set_t saved_cpu_set;
+        bool pinned = pinSyncThread(saved_cpu_set);
+        aclError ret = pollSyncEvent();
+        if (pinned)
+            unpinSyncThread(saved_cpu_set);
+        return ret;
+    }
+
+    aclError AscendCLEngine::pollSyncEvent()
+    {
+        aclError ret;
+        if (nullptr == m_sync_event)
+        {
+            ret = aclrtCreateEvent(&m_sync_event);
+            if (ACL_ERROR_NONE != ret)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "create sync event failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
+                m_sync_event = nullptr;
+                return ret;
+            }
+        }
+        ret = aclrtRecordEvent(m_sync_event, m_stream);
+        if (ACL_ERROR_NONE != ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "record sync event failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
+            return ret;
+        }
+
+        uint64_t start_ns = getSteadyTimeNs();
+        uint64_t last_poll_ns = start_ns;
+        uint64_t timeout_ns = (uint64_t)m_engine_config.execute_timeout_ms * 1000000;
+        uint64_t backoff_us = 0;
+        uint64_t poll_count = 0;
+        while (true)
+        {
+            aclrtEventRecordedStatus status = ACL_EVENT_RECORDED_STATUS_NOT_READY;
+            ret = aclrtQueryEventStatus(m_sync_event, &status);
+            uint64_t now_ns = getSteadyTimeNs();
+            poll_count++;
+            if (ACL_ERROR_NONE != ret)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "query sync event failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
+                return ret;
+            }
+            if (ACL_EVENT_RECORDED_STATUS_COMPLETE == status)
+            {
+                // stream finished somewhere between last two polls
+                m_sync_stats.wakeup_latency_ns += now_ns - last_poll_ns;
+                m_sync_stats.poll_count += poll_count;
+                return ACL_ERROR_NONE;
+            }
+            last_poll_ns = now_ns;
+            if (0 < timeout_ns && now_ns - start_ns >= timeout_ns)
+                return ACL_ERROR_RT_STREAM_SYNC_TIMEOUT;
+            if (ENGINE_SYNC_MODE_YIELD == m_sync_mode)
+            {
+                // yield first, then sleep with exponential backoff
+                if (poll_count <= ENGINE_SYNC_YIELD_POLLS)
+                {
+                    std::this_thread::yield();
+                }
+                else
+                {
+                    backoff_us = std::min<uint64_t>(std::max<uint64_t>(1, backoff_us * 2), ENGINE_SYNC_MAX_BACKOFF_US);
+                    std::this_thread::sleep_for(std::chrono::microseconds(backoff_us));
+                }
+            }
+        }
+    }
+
+    bool AscendCLEngine::recoverStream()
+    {
+        // captured graphs may still be queued on the stream, capture again after recover
+        destroyCapturedGraphs();
+
+        // abort tasks on stream, try to recreate stream even abort fail,
+        // stream destroyed by a former failed recover is only created again
+        aclError ret = ACL_ERROR_NONE;
+        if (nullptr != m_stream)
+        {
+            ret = aclrtStreamAbort(m_stream);
+            if (ACL_ERROR_NONE != ret)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_WARN, "abort stream failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
+            }
+            ret = aclrtDestroyStreamForce(m_stream);
+            if (ACL_ERROR_NONE != ret)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "force destroy stream failed, ret:{}, msg:{}", int(ret), 
+                    aclGetRecentErrMsg());
+                return false;
+            }
+            m_stream = nullptr;
+        }
+        ret = aclrtCreateStream(&m_stream);
+        if (ACL_ERROR_NONE != ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "recreate stream failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
+            m_stream = nullptr;
+            return false;
+        }
+        ACL_LOG(ACL_LOG_LEVEL_WARN, "stream of model {} on device {} is recreated after execute timeout", 
+            m_engine_config.model_name, m_engine_config.device_id);
+        return true;
+    }
+
+    void AscendCLEngine::getShapePlanKey(std::vector<int64_t>& key)
+    {
+        // dims of data inputs in order, -1 ends dims of each input
+        key.clear();
+        for (auto index = 0; index < m_data_input_num; index++)
+        {
+            auto& input_tensor = m_input_tensors_map[m_input_infos[index].name];
+            const auto& dims = input_tensor->buffer().dim;
+            key.insert(key.end(), dims.begin(), dims.end());
+            key.push_back(-1);
+        }
+        return;
+    }
+
+    void AscendCLEngine::getDatasetBuffers(std::vector<void*>& buffers)
+    {
+        buffers.clear();
+        for (auto dataset : {m_input_dataset, m_output_dataset})
+        {
+            auto buffer_num = aclmdlGetDatasetNumBuffers(dataset);
+            for (size_t index = 0; index < buffer_num; index++)
+                buffers.push_back(aclGetDataBufferAddr(aclmdlGetDatasetBuffer(dataset, index)));
+        }
+        return;
+    }
+
+    void AscendCLEngine::destroyCapturedGraphs()
+    {
+#ifdef ENGINE_SUPPORT_MODEL_RI
+        for (auto& it : m_captured_graphs)
+        {
+            if (nullptr == it.second.model_ri)
+                continue;
+            auto ret = aclmdlRIDestroy(it.second.model_ri);
+            if (ACL_ERROR_NONE != ret)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "destroy captured graph {} failed, ret:{}, msg:{}", 
+                    spdlog::fmt_lib::join(it.first, ","), int(ret), aclGetRecentErrMsg());
+            }
+        }
+#endif
+        m_captured_graphs.clear();
+        return;
+    }
+
+    bool AscendCLEngine::captureGraph(AclCapturedGraph& graph)
+    {
+#ifdef ENGINE_SUPPORT_MODEL_RI
+        // record execute tasks on engine stream instead of running them
+        auto ret = aclmdlRICaptureBegin(m_stream, ACL_MODEL_RI_CAPTURE_MODE_RELAXED);
+        if (ACL_ERROR_NONE != ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_WARN, "begin capture model execute failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
+            return false;
+        }
+        auto exec_ret = aclmdlExecuteAsync(m_model_id, m_input_dataset, m_output_dataset, m_stream);
+        aclmdlRI model_ri = nullptr;
+        ret = aclmdlRICaptureEnd(m_stream, &model_ri);
+        if (ACL_ERROR_NONE != exec_ret || ACL_ERROR_NONE != ret || nullptr == model_ri)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_WARN, "capture model execute failed, execute ret:{}, capture end ret:{}, msg:{}", 
+                int(exec_ret), int(ret), aclGetRecentErrMsg());
+            if (nullptr != model_ri)
+                aclmdlRIDestroy(model_ri);
+            return false;
+        }
+        graph.model_ri = model_ri;
+        graph.buffers = m_dataset_buffers;
+        return true;
+#else
+        ACL_LOG(ACL_LOG_LEVEL_WARN, "graph capture need rebuild with ENGINE_SUPPORT_MODEL_RI");
+        return false;
+#endif
+    }
+
+    aclError AscendCLEngine::executeWithGraph()
+    {
+#ifdef ENGINE_SUPPORT_MODEL_RI
+        // inputs or outputs bound to caller buffers would need capture every request, run them directly
+        if (m_external_buffer_bound)
+            return executeDirect();
+
+        // replay graph captured with same shape plan, buffers changed after resize need capture again
+        // key and buffers are rebuilt in reused members, replay path does not allocate
+        auto& key = m_shape_plan_key;
+        getShapePlanKey(key);
+        getDatasetBuffers(m_dataset_buffers);
+        auto iter = m_captured_graphs.find(key);
+        if (m_captured_graphs.end() != iter && iter->second.buffers != m_dataset_buffers)
+        {
+            aclmdlRIDestroy(iter->second.model_ri);
+            m_captured_graphs.erase(iter);
+            iter = m_captured_graphs.end();
+        }
+        if (m_captured_graphs.end() == iter)
+        {
+            m_capture_miss_count++;
+            AclCapturedGraph graph;
+            if (!captureGraph(graph))
+            {
+                // runtime without capture support, fallback to normal execute from now on
+                ACL_LOG(ACL_LOG_LEVEL_WARN, "graph capture is disabled for model {}, fallback to normal execute", 
+                    m_engine_config.model_name);
+                m_graph_capture_supported = false;
+                return executeDirect();
+            }
+            ACL_LOG(ACL_LOG_LEVEL_INFO, "capture model {} execute with shape plan {}", m_engine_config.model_name, 
+                spdlog::fmt_lib::join(key, ","));
+            iter = m_captured_graphs.emplace(key, graph).first;
+        }
+        else
+        {
+            m_capture_hit_count++;
+        }
+
+        auto ret = aclmdlRIExecuteAsync(iter->second.model_ri, m_stream);
+        if (ACL_ERROR_NONE != ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "replay captured graph failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
+            return ret;
+        }
+        return synchronizeStream();
+#else
+        ACL_LOG(ACL_LOG_LEVEL_WARN, "graph capture need rebuild with ENGINE_SUPPORT_MODEL_RI, fallback to normal execute");
+        m_graph_capture_supported = false;
+        return executeDirect();
+#endif
+    }
+
     int AscendCLEngine::runEngine(std::map<std::string, EngineTensor*>& input_tensors_map, 
         std::map<std::string, EngineTensor*>& output_tensors_map)
     {
@@ -1844,8 +2790,9 @@ namespace ACL_ENGINE
                 return false;
             }
             auto host_data = tensor->host<void>();
+            auto device_data = (void*)tensor->devicePtr();
             auto host_size = (size_t)tensor->size();
-            if (nullptr != host_data)
+            if (nullptr != host_data || nullptr != device_data)
             {
                 if (!m_is_dynamic_input && !m_is_dynamic_shape_range && host_size != info.buffer_size)
                 {
@@ -1890,22 +2837,15 @@ namespace ACL_ENGINE
             // convertAscendCLFormatToTensorFormat()
             auto output_format = EngineTensor::TENSOR_FORMAT_TYPE_ND;
             if (index >= outputs.size())
+                outputs.emplace_back(nullptr);
+            // device buffer is malloced with max gear size, reserve the same for host to reshape in place
+            if (!prepareOutputTensor(outputs[index], output_shape, output_dtype, output_format, 
+                output_info.malloc_buffer_size))
             {
-                std::shared_ptr<EngineTensor> tmp_tensor(EngineTensor::create(output_shape, output_dtype, output_format));
-                if (nullptr == tmp_tensor.get())
-                {
-                    ACL_LOG(ACL_LOG_LEVEL_ERROR, "create engine tensor for output {} fail", index);
-                    return -1;
-                }
-                outputs.emplace_back(tmp_tensor);
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "create engine tensor for output {} fail", index);
+                return false;
             }
             auto& output_tensor = outputs[index];
-            if (output_tensor->shape() != output_info.dims)
-            {
-                ACL_LOG(ACL_LOG_LEVEL_ERROR, "note: output {} shape not match, required {}, but given {} "
-                    "please check output shape.", index, spdlog::fmt_lib::join(output_info.dims, ", "), 
-                    spdlog::fmt_lib::join(output_tensor->shape(), ", "));
-            }
             if (output_tensor->getTensorDataType() != output_dtype)
             {
                 ACL_LOG(ACL_LOG_LEVEL_ERROR, "note: output {} data type not match, required {}, but given {}", 
@@ -1916,10 +2856,10 @@ namespace ACL_ENGINE
             auto host_size = (size_t)output_tensor->size();
             if (nullptr != host_data)
             {
-                if (host_size != info.buffer_size)
+                if (host_size != output_info.buffer_size)
                 {
                     ACL_LOG(ACL_LOG_LEVEL_ERROR, "output {} host data size not match, required size {}, but given count {}", 
-                        index, info.buffer_size, output_tensor->size());
+                        index, output_info.buffer_size, output_tensor->size());
                     return false;
                 }
             }
@@ -1955,6 +2895,38 @@ namespace ACL_ENGINE
         }
     }
 
+    bool AscendCLEngine::copyDeviceInput(void* dst, size_t dst_size, const void* src, size_t size, int src_device_id)
+    {
+        // device copy within device, or from peer device when device can access its memory
+        if (m_is_run_on_device)
+            return ACL_ERROR_NONE == aclrtMemcpy(dst, dst_size, src, size, ACL_MEMCPY_DEVICE_TO_HOST);
+        if (src_device_id == m_engine_config.device_id || 
+            DeviceManager::Instance().enablePeerAccess(m_engine_config.device_id, src_device_id))
+            return ACL_ERROR_NONE == aclrtMemcpy(dst, dst_size, src, size, ACL_MEMCPY_DEVICE_TO_DEVICE);
+
+        // no peer access, stage through pinned host buffer, source is read in context of its device
+        std::shared_ptr<void> pinned_buffer;
+        void* staging = nullptr;
+        if (PinnedHostPool::Instance().enabled())
+            pinned_buffer = PinnedHostPool::Instance().allocate(size);
+        if (nullptr != pinned_buffer)
+        {
+            staging = pinned_buffer.get();
+        }
+        else
+        {
+            if (m_peer_staging_buffer.size() < size)
+                m_peer_staging_buffer.resize(size);
+            staging = m_peer_staging_buffer.data();
+        }
+        if (0 != DeviceManager::Instance().setCurrentDevice(src_device_id))
+            return false;
+        aclError ret = aclrtMemcpy(staging, size, src, size, ACL_MEMCPY_DEVICE_TO_HOST);
+        if (0 != DeviceManager::Instance().setCurrentContext(m_context) || ACL_ERROR_NONE != ret)
+            return false;
+        return ACL_ERROR_NONE == aclrtMemcpy(dst, dst_size, staging, size, ACL_MEMCPY_HOST_TO_DEVICE);
+    }
+
     bool AscendCLEngine::checkAndInitInput(const std::vector<EngineTensor*>& inputs)
     {
         // check inputs valid
@@ -1965,14 +2937,37 @@ namespace ACL_ENGINE
         }
         aclError ret;
         // copy inputs tensor data to input dataset
+        m_external_buffer_bound = false;
         for (size_t index = 0; index < inputs.size(); ++index)
         {
             auto &info = m_input_infos[index];
             auto input = inputs[index];
             void *input_buffer = nullptr;
             auto input_data = input->host<void>();
+            auto input_device_data = (void*)input->devicePtr();
             auto input_size = (size_t)input->size();
-            if (!m_is_run_on_device)
+            auto buffer_size = info.buffer_size;
+            bool same_device = (nullptr != input_device_data && (int)input->deviceId() == m_engine_config.device_id);
+            if (same_device && (input_size >= info.buffer_size || !isDynamicShape()))
+            {
+                // device buffer on same device, e.g. output of upstream acl model, no copy needed
+                input_buffer = input_device_data;
+                buffer_size = input_size;
+            }
+            else if (nullptr != input_device_data && (same_device || nullptr == input_data))
+            {
+                // gear model reads input buffer sized for its largest gear, smaller buffer is copied to engine's
+                // buffer, buffer of other device is copied by peer access or staged through host
+                if (!copyDeviceInput(info.device_data, info.buffer_size, input_device_data, input_size, 
+                    (int)input->deviceId()))
+                {
+                    ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl memcpy input {} data from device {} failed, src input size: {}"
+                        ", dst device buffer size: {}", index, input->deviceId(), input_size, info.buffer_size);
+                    return false;
+                }
+                input_buffer = info.device_data;
+            }
+            else if (!m_is_run_on_device)
             {
                 ret = aclrtMemcpy(info.device_data, info.buffer_size, input_data, input_size, ACL_MEMCPY_HOST_TO_DEVICE);
                 if (ACL_ERROR_NONE != ret)
@@ -1987,17 +2982,20 @@ namespace ACL_ENGINE
             {
                 input_buffer = input_data;
             }
+            // buffer owned by caller changes every request, captured graph of it is never replayed
+            if (input_buffer != info.device_data)
+                m_external_buffer_bound = true;
             auto data_buffer = aclmdlGetDatasetBuffer(m_input_dataset, index);
             if (nullptr == data_buffer)
             {
                 ACL_LOG(ACL_LOG_LEVEL_ERROR, "failed to get dataset buffer of input {}", index);
                 return false;
             }
-            ret = aclUpdateDataBuffer(data_buffer, input_buffer, info.buffer_size);
+            ret = aclUpdateDataBuffer(data_buffer, input_buffer, buffer_size);
             if (ACL_ERROR_NONE != ret)
             {
                 ACL_LOG(ACL_LOG_LEVEL_ERROR, "failed to update data buffer of input {}, buffer size: {}, input shape: {}", 
-                    index, info.buffer_size, spdlog::fmt_lib::join(input->shape(), ", "));
+                    index, buffer_size, spdlog::fmt_lib::join(input->shape(), ", "));
                 return false;
             }
         }
@@ -2032,6 +3030,7 @@ namespace ACL_ENGINE
                 if (m_is_run_on_device)
                 {
                     output_device_buffer = host_data;
+                    m_external_buffer_bound = true;
                 }
                 else
                 {
@@ -2068,14 +3067,7 @@ namespace ACL_ENGINE
             {
                 if (nullptr != item.device_data)
                 {
-                    if (!m_is_run_on_device)
-                    {
-                        aclrtFree(item.device_data);
-                    }
-                    else
-                    {
-                        aclrtFreeHost(item.device_data);
-                    }
+                    freeDeviceBuffer(item.device_data);
                 }
                 if (nullptr != item.dynamic_acl_data_buffer)
                 {
@@ -2099,6 +3091,7 @@ namespace ACL_ENGINE
             if (item.device_data != nullptr)
             {
                 ACL_LOG(ACL_LOG_LEVEL_DEBUG, "freeing device buffer at addr: 0x{:x}", (size_t)item.device_data);
+                accountDeviceMemory(item.malloc_buffer_size, false);
                 if (!m_is_run_on_device)
                 {
                     aclrtFree(item.device_data);
@@ -2122,6 +3115,8 @@ namespace ACL_ENGINE
 
     bool AscendCLEngine::resetDynamicOutputTensor(std::vector<std::shared_ptr<EngineTensor>>& outputs)
     {
+        // tensors of last execute are reused when new output fits in
+        outputs.resize(m_output_infos.size());
         for (size_t index = 0; index < m_output_infos.size(); ++index)
         {
             auto& output_info = m_output_infos[index];
@@ -2162,17 +3157,13 @@ namespace ACL_ENGINE
             }
             auto output_format = acl_format_map[acl_format];
 
-            // create output tensor
-            std::shared_ptr<EngineTensor> tmp_tensor(EngineTensor::create(output_shape, output_dtype, output_format));
-            if (nullptr == tmp_tensor.get())
+            // reshape or create output tensor
+            if (!prepareOutputTensor(outputs[index], output_shape, output_dtype, output_format, output_desc_size))
             {
                 ACL_LOG(ACL_LOG_LEVEL_ERROR, "create engine tensor for output {} fail", index);
                 return false;
             }
 
-            // push to output tensor vector
-            outputs.emplace_back(tmp_tensor);
-
             // update acl tensor info
             aclDataBuffer *data_buffer = aclmdlGetDatasetBuffer(m_output_dataset, index);
             void *acl_device_data = aclGetDataBufferAddr(data_buffer);
@@ -2181,10 +3172,57 @@ namespace ACL_ENGINE
             output_info.cur_device_data = acl_device_data;
             output_info.buffer_size = output_desc_size;
             output_info.malloc_buffer_size = output_desc_size;
+            accountDeviceMemory(output_desc_size, true);
         }
         return true;
     }
 
+    int AscendCLEngine::getHostNumaNode()
+    {
+        auto& numa_nodes = m_engine_config.host_numa_nodes;
+        if (1 == numa_nodes.size())
+            return numa_nodes[0];
+        if (0 <= m_engine_config.device_id && m_engine_config.device_id < (int)numa_nodes.size())
+            return numa_nodes[m_engine_config.device_id];
+        return -1;
+    }
+
+    EngineTensor* AscendCLEngine::createOutputTensor(const std::vector<int64_t>& shape, 
+        EngineTensor::TensorDataType dtype, EngineTensor::TensorFormatType format, size_t capacity)
+    {
+        // d2h copy into page locked buffer avoid staging by driver
+        if (m_engine_config.pinned_output && !m_is_run_on_device)
+            return EngineTensor::createWithCapacity(shape, dtype, format, capacity, EngineTensor::HOST_MEMORY_TYPE_PINNED);
+        // host buffers local to device's numa node avoid cross socket traffic
+        int numa_node = getHostNumaNode();
+        if (0 <= numa_node || m_engine_config.host_huge_pages)
+            return EngineTensor::createWithCapacity(shape, dtype, format, capacity, EngineTensor::HOST_MEMORY_TYPE_NUMA, 
+                numa_node, m_engine_config.host_huge_pages);
+        return EngineTensor::createWithCapacity(shape, dtype, format, capacity);
+    }
+
+    bool AscendCLEngine::prepareOutputTensor(std::shared_ptr<EngineTensor>& output, const std::vector<int64_t>& shape, 
+        EngineTensor::TensorDataType dtype, EngineTensor::TensorFormatType format, size_t capacity)
+    {
+        // reuse tensor of output slot when new shape fits in its capacity
+        if (nullptr != output.get() && output->getTensorDataType() == dtype)
+        {
+            int64_t need_size = std::accumulate(shape.begin(), shape.end(), (int64_t)1, std::multiplies<int64_t>());
+            need_size *= output->buffer().elementBytes();
+            if (need_size <= (int64_t)output->capacity() && 0 == output->reshape(shape))
+            {
+                output->buffer().format = format;
+                return true;
+            }
+        }
+        output.reset(createOutputTensor(shape, dtype, format, capacity));
+        if (nullptr == output.get())
+            return false;
+        ACL_LOG(ACL_LOG_LEVEL_DEBUG, "create output tensor with shape {}, capacity {}", 
+            spdlog::fmt_lib::join(shape, ", "), output->capacity());
+        return true;
+    }
+
     bool AscendCLEngine::getOutputs(const std::vector<std::shared_ptr<EngineTensor>>& outputs)
     {
         aclrtMemcpyKind kind = m_is_run_on_device ? ACL_MEMCPY_HOST_TO_HOST : ACL_MEMCPY_DEVICE_TO_HOST;
@@ -11,16 +11,58 @@
 #include <map>
 #include <cstring>
 #include <memory>
+#include <atomic>
+#include <sched.h>
 #include "acl_engine/non_copyable.h"
 #include "acl_engine/log.h"
 #include "acl_engine/engine_type.h"
 #include "acl_engine/engine_tensor.h"
 #include "acl_engine/dyn_shape_process.h"
+#include "acl_engine/workspace_manager.h"
+#include "acl_engine/model_residency.h"
+#include "acl_engine/load_scheduler.h"
 #include "acl/acl.h"
 
 namespace ACL_ENGINE
 {
 
+    void initAclResource();
+
+    /** model execute captured with one shape plan, valid while dataset buffers not changed */
+    typedef struct AclCapturedGraph
+    {
+        aclmdlRI                                        model_ri = nullptr;
+        std::vector<void*>                              buffers;
+    } AclCapturedGraph;
+
+    typedef struct SyncWaitStats
+    {
+        uint64_t                                        wait_count = 0;
+        uint64_t                                        wait_time_ns = 0;           // time from submit to host see stream finish
+        uint64_t                                        max_wait_time_ns = 0;
+        uint64_t                                        wakeup_latency_ns = 0;      // polling mode only, time between last two polls
+        uint64_t                                        poll_count = 0;
+    } SyncWaitStats;
+
+    typedef struct EngineMemoryStats
+    {
+        size_t                                          device_bytes = 0;           // io buffers and dynamic outputs held by engine
+        size_t                                          peak_device_bytes = 0;
+        size_t                                          model_bytes = 0;            // weight memory, and work memory when not shared
+        size_t                                          workspace_bytes = 0;        // work memory of workspace group, shared by members
+        size_t                                          host_bytes = 0;             // host data reserved by output tensors
+        size_t                                          peak_host_bytes = 0;
+    } EngineMemoryStats;
+
+    typedef struct DeviceMemoryInfo
+    {
+        size_t                                          free_bytes = 0;             // device free/total memory from acl
+        size_t                                          total_bytes = 0;
+        size_t                                          allocated_bytes = 0;        // caching allocator in use/cached memory
+        size_t                                          cached_bytes = 0;
+        size_t                                          peak_allocated_bytes = 0;
+    } DeviceMemoryInfo;
+
     typedef struct AclTensorInfo
     {
         void*                                           cur_device_data;
@@ -77,10 +119,34 @@ namespace ACL_ENGINE
         void printEngineInfo();
         int getInputTensorInfos(std::vector<EngineTensorInfo>& input_tensor_infos);
         int getOutputTensorInfos(std::vector<EngineTensorInfo>& output_tensor_infos);
+        uint64_t getLastQueueTimeNs() { return m_last_queue_time_ns; }
+        uint64_t getExecuteTimeoutCount() { return m_execute_timeout_count; }
+        // stream failed to recover after execute timeout, executes fail until next execute recovers it
+        bool isStreamBroken() { return m_stream_broken; }
+        uint64_t getCaptureHitCount() { return m_capture_hit_count; }
+        uint64_t getCaptureMissCount() { return m_capture_miss_count; }
+        const SyncWaitStats& getSyncWaitStats() { return m_sync_stats; }
+        const EngineMemoryStats& getMemoryStats() { return m_memory_stats; }
+        int getDeviceMemoryInfo(std::map<int, DeviceMemoryInfo>& infos);
+        // model memory can be offloaded from device and reloaded from kept model bytes
+        bool isModelResident() { return m_model_resident; }
+        size_t residentBytes() { return m_memory_stats.model_bytes; }
+        int offloadModel();
+        int reloadModel();
+        const ModelResidencyStats& getResidencyStats() { return m_residency_stats; }
+        const ModelLoadStats& getLoadStats() { return m_load_stats; }
+        const EngineConfig& getEngineConfig() { return m_engine_config; }
+        // compiled batch gears of dynamic batch model, empty for other models
+        const std::set<uint64_t>& getBatchGears() { return m_dynamic_shape_options.batch_size; }
 
     private:
         int checkEngineConfig(const EngineConfig& config);
-        int initAclModelFromBuffer(const char* model_data, const size_t& data_len, const EngineConfig& acl_config);
+        int loadAclModel(const char* model_data, const size_t& data_len);
+        int loadAclModelFromFile(const std::string& model_file);
+        int loadModelWithSharedWorkspace(const char* model_data, const size_t& data_len);
+        void releaseModelMemory();
+        size_t queryModelBytes(const char* model_data, const size_t& data_len, const std::string& model_file);
+        int initAclModel(const char* model_data, const size_t& data_len, const std::string& model_file);
         int loadModelFromFile(const EngineConfig& config, const std::vector<std::string>& model_files);
         int loadModelFromBuffer(const EngineConfig& config, const std::vector<const char*>& model_datas, 
             const std::vector<size_t>& data_lens);
@@ -94,12 +160,31 @@ namespace ACL_ENGINE
         int getOutputDataType(std::vector<EngineTensor::TensorDataType>& output_dtypes);
         int getInputShape(std::vector<std::vector<int64_t>>& input_shapes);
         int getInputDataType(std::vector<EngineTensor::TensorDataType>& input_dtypes);
+        aclError executeDirect();
+        aclError executeAsync();
+        aclError executeWithGraph();
+        aclError synchronizeStream();
+        aclError pollStream();
+        aclError pollSyncEvent();
+        bool pinSyncThread(cpu_set_t& saved_cpu_set);
+        void unpinSyncThread(const cpu_set_t& saved_cpu_set);
+        bool recoverStream();
+        bool captureGraph(AclCapturedGraph& graph);
+        void destroyCapturedGraphs();
+        void getShapePlanKey(std::vector<int64_t>& key);
+        void getDatasetBuffers(std::vector<void*>& buffers);
         int checkAndSetDynFlag();
         bool initInputsBuffer();
         bool initOutputsBuffer();
         void destroyInputsBuffer();
         void destroyOutputsBuffer();
         bool createDataBuffer(void** data_mem_buffer, size_t buffer_size, aclmdlDataset* dataset);
+        void* mallocDeviceBuffer(size_t buffer_size);
+        void freeDeviceBuffer(void* buffer);
+        void accountDeviceMemory(size_t buffer_size, bool alloc);
+        void updateHostMemoryStats();
+        bool getWarmupGears(std::vector<std::vector<std::vector<int64_t>>>& gears);
+        void warmupEngine();
         bool isDynamicShape();
         bool isDynamicBatchSize();
         bool isDynamicImageSize();
@@ -115,6 +200,7 @@ namespace ACL_ENGINE
 
         bool checkInputTensors(const std::vector<EngineTensor*>& inputs);
         bool checkOutputTensors(std::vector<std::shared_ptr<EngineTensor>>& outputs);
+        bool copyDeviceInput(void* dst, size_t dst_size, const void* src, size_t size, int src_device_id);
         bool checkAndInitInput(const std::vector<EngineTensor*>& inputs);
         bool checkAndInitOutput(std::vector<std::shared_ptr<EngineTensor>>& outputs);
         void checkAndInitDynOutputDeviceBuf(const EngineTensor* output, const AclTensorInfo& output_info,
@@ -122,7 +208,15 @@ namespace ACL_ENGINE
 
         void freeResourceInput(std::vector<AclTensorInfo>& acl_tensor_info);
         void freeResourceOutput(std::vector<AclTensorInfo>& acl_tensor_info);
+        int getHostNumaNode();
+        EngineTensor* createOutputTensor(const std::vector<int64_t>& shape, EngineTensor::TensorDataType dtype, 
+            EngineTensor::TensorFormatType format, size_t capacity = 0);
+        bool prepareOutputTensor(std::shared_ptr<EngineTensor>& output, const std::vector<int64_t>& shape, 
+            EngineTensor::TensorDataType dtype, EngineTensor::TensorFormatType format, size_t capacity);
         bool getOutputs(const std::vector<std::shared_ptr<EngineTensor>>& outputs);
+        int bindInputTensors(std::map<std::string, EngineTensor*>& input_tensors_map);
+        bool acquireResidency();
+        void releaseResidency();
 
     private:
         bool                                                               m_status = false;
@@ -133,6 +227,28 @@ namespace ACL_ENGINE
         aclmdlDataset*                                                     m_input_dataset = nullptr;
         aclmdlDataset*                                                     m_output_dataset = nullptr;
         uint32_t                                                           m_model_id = UINT32_MAX;
+        // read by residency manager of device while model reloaded outside its lock
+        std::atomic<bool>                                                  m_model_resident{false};
+        // residency taken when inputs bound, so resize and binding never run on evicted model
+        bool                                                               m_residency_held = false;
+        // containers of one run, kept across runs so steady state requests reuse their capacity
+        std::map<std::string, std::vector<int64_t>>                        m_new_shapes;
+        std::vector<std::vector<int64_t>>                                  m_new_shape_list;
+        std::vector<EngineTensor*>                                         m_run_input_tensors;
+        std::vector<std::shared_ptr<EngineTensor>>                         m_run_output_tensors;
+        // host staging of inputs from device without peer access, used when pinned pool disabled
+        std::vector<char>                                                  m_peer_staging_buffer;
+        // model bytes kept for reload after evicted, file is read again when model loaded from file
+        std::vector<std::string>                                           m_model_files;
+        std::vector<char>                                                  m_model_data;
+        ModelResidencyStats                                                m_residency_stats;
+        // queue, read and load time of model loads, reloads after eviction included
+        ModelLoadStats                                                     m_load_stats;
+        // work memory shared with models of same workspace group, weight memory of model itself
+        std::shared_ptr<SharedWorkspace>                                   m_workspace;
+        size_t                                                             m_work_size = 0;
+        void*                                                              m_weight_ptr = nullptr;
+        size_t                                                             m_weight_size = 0;
 
         // utils member var
         std::vector<AclTensorInfo>                                         m_input_infos;
@@ -149,6 +265,29 @@ namespace ACL_ENGINE
         DynShapeProcess                                                    m_dyn_shape_proc;
         // acl engine config
         EngineConfig                                                       m_engine_config;
+        // time last execute waited in device scheduler
+        uint64_t                                                           m_last_queue_time_ns = 0;
+        // executes failed with execute timeout
+        uint64_t                                                           m_execute_timeout_count = 0;
+        // captured model executes, key is input shapes, only built with ENGINE_SUPPORT_MODEL_RI
+        // captured graphs keyed by dims of data inputs, key and buffers of current execute are reused
+        std::map<std::vector<int64_t>, AclCapturedGraph>                   m_captured_graphs;
+        std::vector<int64_t>                                               m_shape_plan_key;
+        std::vector<void*>                                                 m_dataset_buffers;
+        bool                                                               m_graph_capture_supported = true;
+        // dataset of current execute references buffers owned by caller, not engine io buffers
+        bool                                                               m_external_buffer_bound = false;
+        uint64_t                                                           m_capture_hit_count = 0;
+        uint64_t                                                           m_capture_miss_count = 0;
+        // wait stream mode and stats
+        EngineSyncMode                                                     m_sync_mode = ENGINE_SYNC_MODE_BLOCKING;
+        aclrtEvent                                                         m_sync_event = nullptr;
+        SyncWaitStats                                                      m_sync_stats;
+        bool                                                               m_sync_pin_failed = false;
+        bool                                                               m_stream_broken = false;
+        // memory held by engine, size of device buffers malloced by engine
+        EngineMemoryStats                                                  m_memory_stats;
+        std::map<void*, size_t>                                            m_device_buffer_sizes;
 
         // acl model inputs/outputs
         std::map<std::string, std::shared_ptr<EngineTensor>>               m_input_tensors_map;
@@ -0,0 +1,234 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#include <algorithm>
+#include "acl/acl.h"
+#include "acl_engine/log.h"
+#include "acl_engine/acl_engine.h"
+#include "acl_engine/device_manager.h"
+#include "acl_engine/device_allocator.h"
+#include "acl_engine/workspace_manager.h"
+#include "acl_engine/capacity_planner.h"
+
+namespace ACL_ENGINE
+{
+
+    // instances counted per device for report, guard against model needs no memory
+    #define CAPACITY_PLAN_MAX_FIT_COUNT         1024
+
+    static std::string toMBString(size_t bytes)
+    {
+        return std::to_string(bytes >> 20) + "MB";
+    }
+
+    CapacityPlanner& CapacityPlanner::Instance()
+    {
+        static CapacityPlanner planner;
+        return planner;
+    }
+
+    int CapacityPlanner::queryModelMemory(const char* model_data, size_t data_len, const std::string& model_file, 
+        ModelMemoryRequirement& requirement)
+    {
+        initAclResource();
+        aclError ret = ACL_ERROR_NONE;
+        if (nullptr != model_data)
+            ret = aclmdlQuerySizeFromMem(model_data, data_len, &requirement.work_bytes, &requirement.weight_bytes);
+        else
+            ret = aclmdlQuerySize(model_file.c_str(), &requirement.work_bytes, &requirement.weight_bytes);
+        if (ACL_ERROR_NONE != ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "query memory size of model {} failed, ret:{}, msg:{}", model_file, 
+                int(ret), aclGetRecentErrMsg());
+            return -1;
+        }
+        return 0;
+    }
+
+    int CapacityPlanner::getDeviceIds(std::vector<int>& device_ids)
+    {
+        initAclResource();
+        uint32_t device_count = 0;
+        auto ret = aclrtGetDeviceCount(&device_count);
+        if (ACL_ERROR_NONE != ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl get device count fail, ret:{}", int(ret));
+            return -1;
+        }
+        device_ids.clear();
+        for (uint32_t device_id = 0; device_id < device_count; device_id++)
+            device_ids.push_back((int)device_id);
+        return 0;
+    }
+
+    int CapacityPlanner::getDeviceCapacity(int device_id, const std::string& workspace_group, DeviceCapacity& capacity)
+    {
+        // device is only opened for the query, it is reset here unless other users keep it open
+        aclrtContext context = nullptr;
+        if (0 != DeviceManager::Instance().openDevice(device_id, true, context))
+            return -1;
+        auto ret = aclrtGetMemInfo(ACL_HBM_MEM, &capacity.free_bytes, &capacity.total_bytes);
+        DeviceManager::Instance().closeDevice(device_id, context);
+        if (ACL_ERROR_NONE != ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "get device {} memory info failed, ret:{}", device_id, int(ret));
+            return -1;
+        }
+
+        // free blocks cached by allocator are served to engines before device malloc
+        DeviceAllocatorStats allocator_stats;
+        if (0 == DeviceAllocatorManager::Instance().getStats(device_id, allocator_stats))
+            capacity.free_bytes += allocator_stats.cached_bytes - allocator_stats.allocated_bytes;
+        WorkspaceGroupStats group_stats;
+        if ("" != workspace_group && 0 == WorkspaceManager::Instance().getGroupStats(device_id, workspace_group, group_stats))
+            capacity.group_work_bytes = group_stats.workspace_bytes;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        capacity.planned_bytes = m_planned_bytes[device_id];
+        return 0;
+    }
+
+    int CapacityPlanner::planInstances(const ModelMemoryRequirement& requirement, const std::vector<int>& device_ids, 
+        size_t instance_num, bool least_loaded, std::vector<int>& instance_device_ids, 
+        std::vector<size_t>& instance_bytes, std::string& report)
+    {
+        std::lock_guard<std::mutex> plan_lock(m_plan_mutex);
+        instance_device_ids.clear();
+        instance_bytes.clear();
+        report = "";
+        if (!least_loaded)
+            instance_num = device_ids.size();
+
+        // memory left on each device after instances planned so far
+        std::vector<int> devices;
+        std::map<int, DeviceCapacity> capacities;
+        std::map<int, size_t> available_bytes;
+        std::map<int, size_t> group_work_bytes;
+        for (auto device_id : device_ids)
+        {
+            if (capacities.end() != capacities.find(device_id))
+                continue;
+            auto& capacity = capacities[device_id];
+            if (0 != getDeviceCapacity(device_id, requirement.workspace_group, capacity))
+            {
+                report = "query memory of device " + std::to_string(device_id) + " fail";
+                return -1;
+            }
+            devices.push_back(device_id);
+            available_bytes[device_id] = (capacity.free_bytes > capacity.planned_bytes) ? 
+                capacity.free_bytes - capacity.planned_bytes : 0;
+            group_work_bytes[device_id] = capacity.group_work_bytes;
+        }
+
+        // work memory of workspace group is needed once per device, only grown part is counted
+        auto getNeedBytes = [&](int device_id) {
+            size_t work_bytes = requirement.work_bytes;
+            if ("" != requirement.workspace_group)
+                work_bytes = (work_bytes > group_work_bytes[device_id]) ? work_bytes - group_work_bytes[device_id] : 0;
+            return requirement.weight_bytes + requirement.extra_bytes + work_bytes;
+        };
+        auto placeOnDevice = [&](int device_id, size_t need_bytes) {
+            available_bytes[device_id] -= need_bytes;
+            if ("" != requirement.workspace_group)
+                group_work_bytes[device_id] = std::max(group_work_bytes[device_id], requirement.work_bytes);
+        };
+
+        // requested instances are placed first, then devices are filled up to count how many would fit
+        bool all_fit = true;
+        size_t fit_num = 0;
+        std::map<int, size_t> fit_counts;
+        if (least_loaded)
+        {
+            while (fit_num < CAPACITY_PLAN_MAX_FIT_COUNT)
+            {
+                int best_device_id = -1;
+                size_t best_need_bytes = 0;
+                size_t best_left_bytes = 0;
+                for (auto device_id : devices)
+                {
+                    size_t need_bytes = getNeedBytes(device_id);
+                    if (available_bytes[device_id] < need_bytes)
+                        continue;
+                    size_t left_bytes = available_bytes[device_id] - need_bytes;
+                    if (-1 == best_device_id || left_bytes > best_left_bytes)
+                    {
+                        best_device_id = device_id;
+                        best_need_bytes = need_bytes;
+                        best_left_bytes = left_bytes;
+                    }
+                }
+                if (-1 == best_device_id)
+                    break;
+                placeOnDevice(best_device_id, best_need_bytes);
+                if (instance_device_ids.size() < instance_num)
+                {
+                    instance_device_ids.push_back(best_device_id);
+                    instance_bytes.push_back(best_need_bytes);
+                }
+                fit_counts[best_device_id]++;
+                fit_num++;
+            }
+            all_fit = (instance_device_ids.size() == instance_num);
+        }
+        else
+        {
+            for (auto device_id : device_ids)
+            {
+                size_t need_bytes = getNeedBytes(device_id);
+                if (available_bytes[device_id] < need_bytes)
+                {
+                    all_fit = false;
+                    continue;
+                }
+                placeOnDevice(device_id, need_bytes);
+                instance_device_ids.push_back(device_id);
+                instance_bytes.push_back(need_bytes);
+                fit_counts[device_id]++;
+                fit_num++;
+            }
+            for (auto device_id : devices)
+            {
+                size_t need_bytes = getNeedBytes(device_id);
+                while (available_bytes[device_id] >= need_bytes && fit_counts[device_id] < CAPACITY_PLAN_MAX_FIT_COUNT)
+                {
+                    placeOnDevice(device_id, need_bytes);
+                    fit_counts[device_id]++;
+                    fit_num++;
+                }
+            }
+        }
+
+        report = "instance needs " + toMBString(requirement.weight_bytes + requirement.work_bytes + requirement.extra_bytes) + 
+            " (weight " + toMBString(requirement.weight_bytes) + ", work " + toMBString(requirement.work_bytes) + 
+            ", extra " + toMBString(requirement.extra_bytes) + "), " + std::to_string(instance_num) + 
+            " instances requested, " + std::to_string(fit_num) + " fit";
+        for (auto device_id : devices)
+        {
+            const auto& capacity = capacities[device_id];
+            report += "; device " + std::to_string(device_id) + " free " + toMBString(capacity.free_bytes) + " of " + 
+                toMBString(capacity.total_bytes) + ", planned " + toMBString(capacity.planned_bytes) + ", " + 
+                std::to_string(fit_counts[device_id]) + " fit";
+        }
+        if (!all_fit)
+        {
+            instance_device_ids.clear();
+            instance_bytes.clear();
+            return -1;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t index = 0; index < instance_device_ids.size(); index++)
+            m_planned_bytes[instance_device_ids[index]] += instance_bytes[index];
+        return 0;
+    }
+
+    void CapacityPlanner::releasePlanned(int device_id, size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& planned_bytes = m_planned_bytes[device_id];
+        planned_bytes = (planned_bytes > bytes) ? planned_bytes - bytes : 0;
+    }
+
+} // namespace ACL_ENGINE
\ No newline at end of file
@@ -0,0 +1,84 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include <mutex>
+#include "acl_engine/non_copyable.h"
+
+namespace ACL_ENGINE
+{
+
+    typedef struct ModelMemoryRequirement
+    {
+        size_t                                  work_bytes = 0;             // work memory, shared by models of workspace group
+        size_t                                  weight_bytes = 0;
+        size_t                                  extra_bytes = 0;            // device memory of instance besides model, such as io buffers
+        std::string                             workspace_group = "";
+    } ModelMemoryRequirement;
+
+    typedef struct DeviceCapacity
+    {
+        size_t                                  total_bytes = 0;
+        size_t                                  free_bytes = 0;             // free memory from acl and free memory cached by allocator
+        size_t                                  planned_bytes = 0;          // reserved by planned instances not loaded yet
+        size_t                                  group_work_bytes = 0;       // workspace of model's group already on device
+    } DeviceCapacity;
+
+    /**
+     * backend global planner of instance placement by device memory, model memory is queried from om file
+     * before load and instances are placed where it fits, memory of planned instances is reserved until
+     * they are loaded, so models planned at same time do not count the same free memory twice
+     */
+    class CapacityPlanner : public NonCopyable
+    {
+    public:
+        static CapacityPlanner& Instance();
+
+        /**
+         * @brief query work and weight memory of model
+         * @param model_data, om data, nullptr means query by om file
+         * @param data_len, om data bytes
+         * @param model_file, om file queried when no om data
+         * @param requirement, work and weight bytes filled
+         * @return 0 if success, -1 if fail
+         */
+        int queryModelMemory(const char* model_data, size_t data_len, const std::string& model_file, 
+            ModelMemoryRequirement& requirement);
+        int getDeviceIds(std::vector<int>& device_ids);
+
+        /**
+         * @brief plan device of each instance and reserve its memory until released
+         * @param requirement, memory of one instance
+         * @param device_ids, with least_loaded devices instances may be placed on, else device of each instance
+         * @param instance_num, instances placed with least_loaded, ignored otherwise
+         * @param least_loaded, instance is placed on device with most memory left, or kept on its given device
+         * @param instance_device_ids, device of each instance
+         * @param instance_bytes, memory reserved for each instance
+         * @param report, device memory and how many instances fit, filled whether plan success or not
+         * @return 0 if all instances fit, -1 if not or query fail, nothing is reserved when fail
+         */
+        int planInstances(const ModelMemoryRequirement& requirement, const std::vector<int>& device_ids, 
+            size_t instance_num, bool least_loaded, std::vector<int>& instance_device_ids, 
+            std::vector<size_t>& instance_bytes, std::string& report);
+        // instance loaded or given up, its memory is seen by device free memory now
+        void releasePlanned(int device_id, size_t bytes);
+
+    private:
+        CapacityPlanner() = default;
+        ~CapacityPlanner() = default;
+        int getDeviceCapacity(int device_id, const std::string& workspace_group, DeviceCapacity& capacity);
+
+    private:
+        // plans are made one at a time, each sees memory reserved by plans before it
+        std::mutex                                                  m_plan_mutex;
+        std::mutex                                                  m_mutex;
+        std::map<int, size_t>                                       m_planned_bytes;
+    };
+
+} // namespace ACL_ENGINE
\ No newline at end of file
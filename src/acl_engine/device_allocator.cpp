@@ -0,0 +1,515 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#include <chrono>
+#include <algorithm>
+#include <vector>
+#include "acl_engine/log.h"
+#include "acl_engine/acl_engine.h"
+#include "acl_engine/device_allocator.h"
+#include "acl_engine/device_manager.h"
+
+namespace ACL_ENGINE
+{
+
+    // all block sizes are rounded to this size
+    #define DEVICE_ALLOC_MIN_BLOCK_SIZE        512
+    // blocks not larger than this size are allocated from small pool
+    #define DEVICE_ALLOC_SMALL_SIZE            (1UL << 20)
+    // segment size of small pool
+    #define DEVICE_ALLOC_SMALL_SEGMENT_SIZE    (2UL << 20)
+    // segment size of large pool is rounded to this size
+    #define DEVICE_ALLOC_LARGE_ROUND_SIZE      (2UL << 20)
+    // large block is split only when remaining is larger than this size
+    #define DEVICE_ALLOC_LARGE_SPLIT_SIZE      (1UL << 20)
+    // min interval of trim thread check idle devices
+    #define DEVICE_ALLOC_MIN_TRIM_CHECK_MS     100
+
+    static uint64_t getSteadyTimeNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    bool DeviceCachingAllocator::compareBlock(const DeviceBlock* a, const DeviceBlock* b)
+    {
+        // blocks of same stream are adjacent, then ordered by size to find best fit
+        if (a->stream != b->stream)
+            return (uintptr_t)a->stream < (uintptr_t)b->stream;
+        if (a->size != b->size)
+            return a->size < b->size;
+        return (uintptr_t)a->ptr < (uintptr_t)b->ptr;
+    }
+
+    DeviceCachingAllocator::DeviceCachingAllocator(int device_id) 
+        : m_device_id(device_id), m_small_pool(compareBlock), m_large_pool(compareBlock)
+    {
+    }
+
+    DeviceCachingAllocator::~DeviceCachingAllocator()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (0 != m_allocated_blocks.size())
+        {
+            ACL_LOG(ACL_LOG_LEVEL_WARN, "device {} allocator destroyed with {} blocks still in use", 
+                m_device_id, m_allocated_blocks.size());
+        }
+        for (auto pool : {&m_small_pool, &m_large_pool})
+        {
+            for (auto block : *pool)
+                block->reserved = false;
+            releaseFreeSegments(*pool);
+        }
+    }
+
+    size_t DeviceCachingAllocator::roundSize(size_t size)
+    {
+        if (size < DEVICE_ALLOC_MIN_BLOCK_SIZE)
+            return DEVICE_ALLOC_MIN_BLOCK_SIZE;
+        return (size + DEVICE_ALLOC_MIN_BLOCK_SIZE - 1) / DEVICE_ALLOC_MIN_BLOCK_SIZE * DEVICE_ALLOC_MIN_BLOCK_SIZE;
+    }
+
+    size_t DeviceCachingAllocator::segmentSize(size_t size)
+    {
+        if (size <= DEVICE_ALLOC_SMALL_SIZE)
+            return DEVICE_ALLOC_SMALL_SEGMENT_SIZE;
+        return (size + DEVICE_ALLOC_LARGE_ROUND_SIZE - 1) / DEVICE_ALLOC_LARGE_ROUND_SIZE * DEVICE_ALLOC_LARGE_ROUND_SIZE;
+    }
+
+    DeviceCachingAllocator::BlockPool& DeviceCachingAllocator::getPool(size_t size)
+    {
+        return (size <= DEVICE_ALLOC_SMALL_SIZE) ? m_small_pool : m_large_pool;
+    }
+
+    DeviceCachingAllocator::DeviceBlock* DeviceCachingAllocator::findFreeBlock(BlockPool& pool, size_t size, 
+        aclrtStream stream)
+    {
+        // blocks last used on same stream first, then blocks not bound to any stream
+        DeviceBlock key;
+        key.size = size;
+        for (auto search_stream : {stream, (aclrtStream)nullptr})
+        {
+            key.stream = search_stream;
+            auto iter = pool.lower_bound(&key);
+            if (pool.end() != iter && (*iter)->stream == search_stream)
+            {
+                DeviceBlock* block = *iter;
+                pool.erase(iter);
+                return block;
+            }
+            if (nullptr == stream)
+                break;
+        }
+        return nullptr;
+    }
+
+    DeviceCachingAllocator::DeviceBlock* DeviceCachingAllocator::mallocSegment(size_t size, aclrtStream stream)
+    {
+        void* ptr = nullptr;
+        auto ret = aclrtMalloc(&ptr, size, ACL_MEM_MALLOC_HUGE_FIRST);
+        if (ACL_ERROR_NONE != ret || nullptr == ptr)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_WARN, "device {} malloc segment of {} bytes failed, ret:{}, cached bytes:{}", 
+                m_device_id, size, int(ret), m_stats.cached_bytes);
+            return nullptr;
+        }
+        DeviceBlock* block = new DeviceBlock();
+        block->ptr = ptr;
+        block->size = size;
+        block->stream = stream;
+        m_stats.device_malloc_count++;
+        m_stats.cached_bytes += size;
+        m_stats.peak_cached_bytes = std::max(m_stats.peak_cached_bytes, m_stats.cached_bytes);
+        return block;
+    }
+
+    bool DeviceCachingAllocator::shouldSplit(const DeviceBlock* block, size_t size)
+    {
+        size_t remaining = block->size - size;
+        if (block->small)
+            return remaining >= DEVICE_ALLOC_MIN_BLOCK_SIZE;
+        return remaining > DEVICE_ALLOC_LARGE_SPLIT_SIZE;
+    }
+
+    void* DeviceCachingAllocator::malloc(size_t size, aclrtStream stream)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size = roundSize(size);
+        bool small = (size <= DEVICE_ALLOC_SMALL_SIZE);
+        auto& pool = getPool(size);
+        m_stats.alloc_count++;
+        m_last_used_ns = getSteadyTimeNs();
+
+        DeviceBlock* block = findFreeBlock(pool, size, stream);
+        if (nullptr != block)
+        {
+            m_stats.cache_hit_count++;
+        }
+        else
+        {
+            block = mallocSegment(segmentSize(size), stream);
+            if (nullptr == block)
+            {
+                // free cached segments and retry once
+                m_stats.malloc_retry_count++;
+                releaseFreeSegments(m_small_pool);
+                releaseFreeSegments(m_large_pool);
+                block = mallocSegment(segmentSize(size), stream);
+            }
+            if (nullptr == block)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "device {} malloc {} bytes failed, allocated bytes:{}, cached bytes:{}", 
+                    m_device_id, size, m_stats.allocated_bytes, m_stats.cached_bytes);
+                return nullptr;
+            }
+            block->small = small;
+        }
+
+        // split large block, remaining part stays in cache
+        if (shouldSplit(block, size))
+        {
+            DeviceBlock* remaining = new DeviceBlock();
+            remaining->ptr = (uint8_t*)block->ptr + size;
+            remaining->size = block->size - size;
+            remaining->stream = block->stream;
+            remaining->reserved = block->reserved;
+            remaining->small = block->small;
+            remaining->prev = block;
+            remaining->next = block->next;
+            if (nullptr != remaining->next)
+                remaining->next->prev = remaining;
+            block->next = remaining;
+            block->size = size;
+            pool.insert(remaining);
+        }
+
+        block->allocated = true;
+        block->stream = stream;
+        m_allocated_blocks[block->ptr] = block;
+        m_stats.allocated_bytes += block->size;
+        m_stats.peak_allocated_bytes = std::max(m_stats.peak_allocated_bytes, m_stats.allocated_bytes);
+        return block->ptr;
+    }
+
+    void DeviceCachingAllocator::tryMerge(DeviceBlock* dst, DeviceBlock* src, BlockPool& pool)
+    {
+        if (nullptr == src || src->allocated)
+            return;
+        pool.erase(src);
+        if (dst->prev == src)
+        {
+            dst->ptr = src->ptr;
+            dst->prev = src->prev;
+            if (nullptr != dst->prev)
+                dst->prev->next = dst;
+        }
+        else
+        {
+            dst->next = src->next;
+            if (nullptr != dst->next)
+                dst->next->prev = dst;
+        }
+        dst->size += src->size;
+        delete src;
+    }
+
+    void DeviceCachingAllocator::free(void* ptr)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto iter = m_allocated_blocks.find(ptr);
+        if (m_allocated_blocks.end() == iter)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "device {} free ptr 0x{:x} not allocated by caching allocator", 
+                m_device_id, (size_t)ptr);
+            return;
+        }
+        DeviceBlock* block = iter->second;
+        m_allocated_blocks.erase(iter);
+        m_stats.allocated_bytes -= block->size;
+        m_last_used_ns = getSteadyTimeNs();
+
+        // block stays on its stream, engine synchronize stream before free so whole free segment can go to any stream
+        block->allocated = false;
+        auto& pool = block->small ? m_small_pool : m_large_pool;
+        tryMerge(block, block->prev, pool);
+        tryMerge(block, block->next, pool);
+        if (nullptr == block->prev && nullptr == block->next)
+            block->stream = nullptr;
+        pool.insert(block);
+    }
+
+    bool DeviceCachingAllocator::owns(void* ptr)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_allocated_blocks.end() != m_allocated_blocks.find(ptr);
+    }
+
+    int DeviceCachingAllocator::reserve(size_t size)
+    {
+        // reserved segment serves large pool only, small blocks are never split from large segments
+        // because freed blocks are merged inside their own pool, small pool grows by small segments
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size = segmentSize(std::max(size, DEVICE_ALLOC_SMALL_SIZE + 1));
+        DeviceBlock* block = mallocSegment(size, nullptr);
+        if (nullptr == block)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "device {} reserve {} bytes failed", m_device_id, size);
+            return -1;
+        }
+        block->reserved = true;
+        m_large_pool.insert(block);
+        m_stats.reserved_bytes += size;
+        return 0;
+    }
+
+    void DeviceCachingAllocator::releaseFreeSegments(BlockPool& pool)
+    {
+        for (auto iter = pool.begin(); iter != pool.end();)
+        {
+            DeviceBlock* block = *iter;
+            if (block->allocated || block->reserved || nullptr != block->prev || nullptr != block->next)
+            {
+                iter++;
+                continue;
+            }
+            auto ret = aclrtFree(block->ptr);
+            if (ACL_ERROR_NONE != ret)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "device {} free segment failed, ret:{}", m_device_id, int(ret));
+            }
+            m_stats.device_free_count++;
+            m_stats.cached_bytes -= block->size;
+            iter = pool.erase(iter);
+            delete block;
+        }
+    }
+
+    void DeviceCachingAllocator::emptyCache()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        releaseFreeSegments(m_small_pool);
+        releaseFreeSegments(m_large_pool);
+    }
+
+    void DeviceCachingAllocator::getStats(DeviceAllocatorStats& stats)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stats = m_stats;
+    }
+
+    uint64_t DeviceCachingAllocator::lastUsedNs()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_last_used_ns;
+    }
+
+    DeviceAllocatorManager& DeviceAllocatorManager::Instance()
+    {
+        static DeviceAllocatorManager manager;
+        return manager;
+    }
+
+    DeviceAllocatorManager::~DeviceAllocatorManager()
+    {
+        // device may be already released at exit, only stop trim thread here
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        if (m_trim_thread.joinable())
+            m_trim_thread.join();
+    }
+
+    void DeviceAllocatorManager::setConfig(const DeviceAllocatorConfig& config)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_config = config;
+        m_stop = false;
+        if (0 < m_config.trim_idle_ms && m_config.enable_cache && !m_trim_thread.joinable())
+            m_trim_thread = std::thread(&DeviceAllocatorManager::trimLoop, this);
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "device memory cache:{}, reserve bytes:{}, trim idle ms:{}", 
+            m_config.enable_cache, m_config.reserve_bytes, m_config.trim_idle_ms);
+    }
+
+    DeviceCachingAllocator* DeviceAllocatorManager::getAllocator(int device_id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& allocator = m_allocators[device_id];
+        if (nullptr == allocator)
+        {
+            allocator.reset(new DeviceCachingAllocator(device_id));
+            // cached memory is released with device, keep device open until shutdown
+            if (0 == DeviceManager::Instance().retainDevice(device_id))
+                m_retained_devices.insert(device_id);
+        }
+        return allocator.get();
+    }
+
+    DeviceCachingAllocator* DeviceAllocatorManager::findAllocator(int device_id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto iter = m_allocators.find(device_id);
+        return (m_allocators.end() != iter) ? iter->second.get() : nullptr;
+    }
+
+    int DeviceAllocatorManager::reserveAllDevices()
+    {
+        if (!m_config.enable_cache || 0 == m_config.reserve_bytes)
+            return 0;
+
+        initAclResource();
+        uint32_t device_count = 0;
+        auto ret = aclrtGetDeviceCount(&device_count);
+        if (ACL_ERROR_NONE != ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl get device count fail, ret:{}", int(ret));
+            return -1;
+        }
+        for (uint32_t device_id = 0; device_id < device_count; device_id++)
+        {
+            // device is kept open until shutdown, otherwise reserved memory is released with device
+            aclrtContext context = nullptr;
+            if (0 != DeviceManager::Instance().openDevice(device_id, true, context))
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "open device {} failed", device_id);
+                return -1;
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_reserved_devices.insert(device_id);
+            }
+            if (0 != getAllocator(device_id)->reserve(m_config.reserve_bytes))
+                return -1;
+            ACL_LOG(ACL_LOG_LEVEL_INFO, "device {} reserve {} bytes for caching allocator", 
+                device_id, m_config.reserve_bytes);
+        }
+        return 0;
+    }
+
+    void DeviceAllocatorManager::shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        if (m_trim_thread.joinable())
+            m_trim_thread.join();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& it : m_allocators)
+        {
+            DeviceAllocatorStats stats;
+            it.second->getStats(stats);
+            ACL_LOG(ACL_LOG_LEVEL_INFO, "device {} allocator peak allocated bytes:{}, peak cached bytes:{}, "
+                "alloc count:{}, cache hit count:{}, device malloc count:{}", it.first, stats.peak_allocated_bytes, 
+                stats.peak_cached_bytes, stats.alloc_count, stats.cache_hit_count, stats.device_malloc_count);
+            if (0 == DeviceManager::Instance().setCurrentDevice(it.first))
+                it.second.reset();
+        }
+        m_allocators.clear();
+        for (auto device_id : m_retained_devices)
+            DeviceManager::Instance().closeDevice(device_id, nullptr);
+        m_retained_devices.clear();
+        for (auto device_id : m_reserved_devices)
+            DeviceManager::Instance().closeDevice(device_id, nullptr);
+        m_reserved_devices.clear();
+    }
+
+    void* DeviceAllocatorManager::malloc(int device_id, size_t size, aclrtStream stream)
+    {
+        if (!m_config.enable_cache)
+        {
+            void* ptr = nullptr;
+            auto ret = aclrtMalloc(&ptr, size, ACL_MEM_MALLOC_HUGE_FIRST);
+            if (ACL_ERROR_NONE != ret)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "malloc device buffer failed, buffer size {}, ret:{}", size, int(ret));
+                return nullptr;
+            }
+            return ptr;
+        }
+        return getAllocator(device_id)->malloc(size, stream);
+    }
+
+    void DeviceAllocatorManager::free(int device_id, void* ptr)
+    {
+        if (nullptr == ptr)
+            return;
+        // buffer not from allocator is freed directly, allocator is never created here
+        auto allocator = m_config.enable_cache ? findAllocator(device_id) : nullptr;
+        if (nullptr == allocator || !allocator->owns(ptr))
+        {
+            (void)aclrtFree(ptr);
+            return;
+        }
+        allocator->free(ptr);
+    }
+
+    int DeviceAllocatorManager::getStats(int device_id, DeviceAllocatorStats& stats)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto iter = m_allocators.find(device_id);
+        if (m_allocators.end() == iter)
+        {
+            stats = DeviceAllocatorStats();
+            return -1;
+        }
+        iter->second->getStats(stats);
+        return 0;
+    }
+
+    void DeviceAllocatorManager::trimLoop()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stop)
+        {
+            int check_ms = std::max(m_config.trim_idle_ms / 2, DEVICE_ALLOC_MIN_TRIM_CHECK_MS);
+            m_cond.wait_for(lock, std::chrono::milliseconds(check_ms), [this]() { return m_stop; });
+            if (m_stop)
+                break;
+
+            uint64_t idle_ns = (uint64_t)m_config.trim_idle_ms * 1000000;
+            uint64_t now_ns = getSteadyTimeNs();
+            std::vector<std::pair<int, DeviceCachingAllocator*>> idle_allocators;
+            for (auto& it : m_allocators)
+            {
+                // device not kept open has released its memory already, trimming would open it again
+                if (0 == m_retained_devices.count(it.first) && 0 == m_reserved_devices.count(it.first))
+                    continue;
+                auto allocator = it.second.get();
+                DeviceAllocatorStats stats;
+                allocator->getStats(stats);
+                // nothing trimmable or device still busy
+                if (stats.cached_bytes <= stats.allocated_bytes + stats.reserved_bytes || 
+                    now_ns - allocator->lastUsedNs() < idle_ns)
+                    continue;
+                idle_allocators.emplace_back(it.first, allocator);
+            }
+
+            // device calls run outside manager lock, allocators live until shutdown joins this thread
+            lock.unlock();
+            for (auto& it : idle_allocators)
+            {
+                // take a device reference while trimming and give it back after
+                aclrtContext context = nullptr;
+                if (0 != DeviceManager::Instance().openDevice(it.first, true, context))
+                    continue;
+                DeviceAllocatorStats stats;
+                it.second->getStats(stats);
+                it.second->emptyCache();
+                DeviceManager::Instance().closeDevice(it.first, nullptr);
+                DeviceAllocatorStats trimmed_stats;
+                it.second->getStats(trimmed_stats);
+                ACL_LOG(ACL_LOG_LEVEL_INFO, "device {} idle, trim cached bytes from {} to {}", 
+                    it.first, stats.cached_bytes, trimmed_stats.cached_bytes);
+            }
+            lock.lock();
+        }
+    }
+
+} // namespace ACL_ENGINE
\ No newline at end of file
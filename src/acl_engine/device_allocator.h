@@ -0,0 +1,135 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#pragma once
+#include <set>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <condition_variable>
+#include "acl/acl.h"
+#include "acl_engine/non_copyable.h"
+
+namespace ACL_ENGINE
+{
+
+    typedef struct DeviceAllocatorConfig
+    {
+        bool                                    enable_cache = true;        // false means malloc/free device memory directly
+        size_t                                  reserve_bytes = 0;          // memory cached per device at backend init for large blocks, never trimmed
+        int                                     trim_idle_ms = 0;           // release free cached memory after device idle, 0 means never
+    } DeviceAllocatorConfig;
+
+    typedef struct DeviceAllocatorStats
+    {
+        size_t                                  allocated_bytes = 0;        // bytes in use by engines
+        size_t                                  cached_bytes = 0;           // bytes malloced from device, in use and free
+        size_t                                  peak_allocated_bytes = 0;
+        size_t                                  peak_cached_bytes = 0;
+        size_t                                  reserved_bytes = 0;         // bytes of reserved segments
+        uint64_t                                alloc_count = 0;
+        uint64_t                                cache_hit_count = 0;        // alloc served by cached block
+        uint64_t                                device_malloc_count = 0;
+        uint64_t                                device_free_count = 0;
+        uint64_t                                malloc_retry_count = 0;     // device malloc retried after free cached memory
+    } DeviceAllocatorStats;
+
+    /**
+     * caching allocator of one device, device memory is malloced in segments and split into blocks,
+     * freed blocks are cached by size class and coalesced with free neighbours of the same segment
+     */
+    class DeviceCachingAllocator : public NonCopyable
+    {
+    public:
+        explicit DeviceCachingAllocator(int device_id);
+        ~DeviceCachingAllocator();
+
+        /**
+         * @brief malloc device memory, current context should be on allocator's device
+         * @param size, bytes to malloc
+         * @param stream, stream the memory is used on, cached blocks of same stream are reused first
+         * @return device ptr, nullptr if fail
+         */
+        void* malloc(size_t size, aclrtStream stream);
+        void free(void* ptr);
+        bool owns(void* ptr);
+        int reserve(size_t size);
+        // release free segments to device, reserved segments are kept
+        void emptyCache();
+        void getStats(DeviceAllocatorStats& stats);
+        uint64_t lastUsedNs();
+
+    private:
+        typedef struct DeviceBlock
+        {
+            void*                               ptr = nullptr;
+            size_t                              size = 0;
+            aclrtStream                         stream = nullptr;
+            bool                                allocated = false;
+            bool                                reserved = false;           // segment from reserve, never released
+            bool                                small = false;              // block of small pool segment
+            struct DeviceBlock*                 prev = nullptr;             // neighbour blocks in same segment
+            struct DeviceBlock*                 next = nullptr;
+        } DeviceBlock;
+
+        typedef bool (*BlockComparator)(const DeviceBlock*, const DeviceBlock*);
+        typedef std::set<DeviceBlock*, BlockComparator> BlockPool;
+
+        static bool compareBlock(const DeviceBlock* a, const DeviceBlock* b);
+        size_t roundSize(size_t size);
+        size_t segmentSize(size_t size);
+        BlockPool& getPool(size_t size);
+        DeviceBlock* findFreeBlock(BlockPool& pool, size_t size, aclrtStream stream);
+        DeviceBlock* mallocSegment(size_t size, aclrtStream stream);
+        bool shouldSplit(const DeviceBlock* block, size_t size);
+        void tryMerge(DeviceBlock* dst, DeviceBlock* src, BlockPool& pool);
+        void releaseFreeSegments(BlockPool& pool);
+
+    private:
+        int                                                         m_device_id;
+        std::mutex                                                  m_mutex;
+        BlockPool                                                   m_small_pool;
+        BlockPool                                                   m_large_pool;
+        std::map<void*, DeviceBlock*>                               m_allocated_blocks;
+        DeviceAllocatorStats                                        m_stats;
+        uint64_t                                                    m_last_used_ns = 0;
+    };
+
+    /** backend global owner of per device caching allocators, also trim cached memory on idle */
+    class DeviceAllocatorManager : public NonCopyable
+    {
+    public:
+        static DeviceAllocatorManager& Instance();
+        void setConfig(const DeviceAllocatorConfig& config);
+        // reserve memory on all devices with configured reserve bytes
+        int reserveAllDevices();
+        // release all cached memory and stop trim thread
+        void shutdown();
+
+        void* malloc(int device_id, size_t size, aclrtStream stream);
+        void free(int device_id, void* ptr);
+        int getStats(int device_id, DeviceAllocatorStats& stats);
+
+    private:
+        DeviceAllocatorManager() = default;
+        ~DeviceAllocatorManager();
+        DeviceCachingAllocator* getAllocator(int device_id);
+        DeviceCachingAllocator* findAllocator(int device_id);
+        void trimLoop();
+
+    private:
+        std::mutex                                                  m_mutex;
+        std::condition_variable                                     m_cond;
+        DeviceAllocatorConfig                                       m_config;
+        std::map<int, std::unique_ptr<DeviceCachingAllocator>>      m_allocators;
+        std::set<int>                                               m_reserved_devices;
+        std::set<int>                                               m_retained_devices;          // devices kept open for cached memory
+        std::thread                                                 m_trim_thread;
+        bool                                                        m_stop = false;
+    };
+
+} // namespace ACL_ENGINE
\ No newline at end of file
@@ -0,0 +1,195 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#include "acl_engine/log.h"
+#include "acl_engine/device_manager.h"
+
+namespace ACL_ENGINE
+{
+
+    // context last set current by calling thread, valid while generation not changed
+    static thread_local aclrtContext t_current_context = nullptr;
+    static thread_local uint64_t t_context_generation = 0;
+
+    DeviceManager& DeviceManager::Instance()
+    {
+        static DeviceManager manager;
+        return manager;
+    }
+
+    int DeviceManager::createContext(int device_id, aclrtContext& context)
+    {
+        auto ret = aclrtCreateContext(&context, device_id);
+        if (ACL_ERROR_NONE != ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl create context on device {} failed, ret:{}, msg:{}", device_id, 
+                int(ret), aclGetRecentErrMsg());
+            context = nullptr;
+            return -1;
+        }
+        return 0;
+    }
+
+    void DeviceManager::destroyContext(aclrtContext context)
+    {
+        auto ret = aclrtDestroyContext(context);
+        if (ACL_ERROR_NONE != ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "destroy context failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
+        }
+        // a new context may get same handle, contexts tracked by all threads are set again
+        m_context_generation++;
+    }
+
+    int DeviceManager::openDevice(int device_id, bool shared, aclrtContext& context)
+    {
+        context = nullptr;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& state = m_devices[device_id];
+        if (0 == state.ref_count)
+        {
+            auto ret = aclrtSetDevice(device_id);
+            if (ACL_ERROR_NONE != ret)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl set device:{} failed, ret:{}, msg:{}", device_id, int(ret), 
+                    aclGetRecentErrMsg());
+                m_devices.erase(device_id);
+                return -1;
+            }
+            ACL_LOG(ACL_LOG_LEVEL_INFO, "device {} opened", device_id);
+        }
+
+        aclrtContext device_context = shared ? state.shared_context : nullptr;
+        if (nullptr == device_context && 0 != createContext(device_id, device_context))
+        {
+            if (0 == state.ref_count)
+            {
+                aclrtResetDevice(device_id);
+                m_devices.erase(device_id);
+            }
+            return -1;
+        }
+        if (shared)
+            state.shared_context = device_context;
+        state.ref_count++;
+        context = device_context;
+
+        // set device and create context change current context of calling thread behind tracking
+        t_current_context = nullptr;
+        return setCurrentContext(context);
+    }
+
+    void DeviceManager::closeDevice(int device_id, aclrtContext context)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto iter = m_devices.find(device_id);
+        if (m_devices.end() == iter || 0 >= iter->second.ref_count)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_WARN, "close device {} which is not opened", device_id);
+            return;
+        }
+        auto& state = iter->second;
+        if (nullptr != context && context != state.shared_context)
+            destroyContext(context);
+        state.ref_count--;
+        if (0 < state.ref_count)
+            return;
+
+        // last user closed, release shared context and device
+        if (nullptr != state.shared_context)
+            destroyContext(state.shared_context);
+        auto ret = aclrtResetDevice(device_id);
+        if (ACL_ERROR_NONE != ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "reset device {} failed, ret:{}, msg:{}", device_id, int(ret), 
+                aclGetRecentErrMsg());
+        }
+        m_devices.erase(iter);
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "device {} reset", device_id);
+    }
+
+    int DeviceManager::retainDevice(int device_id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto iter = m_devices.find(device_id);
+        if (m_devices.end() == iter || 0 >= iter->second.ref_count)
+            return -1;
+        iter->second.ref_count++;
+        return 0;
+    }
+
+    int DeviceManager::setCurrentContext(aclrtContext context)
+    {
+        uint64_t generation = m_context_generation.load();
+        if (nullptr != context && t_current_context == context && t_context_generation == generation)
+            return 0;
+        auto ret = aclrtSetCurrentContext(context);
+        if (ACL_ERROR_NONE != ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "acl set context failed, ret:{}, msg:{}", int(ret), aclGetRecentErrMsg());
+            t_current_context = nullptr;
+            return -1;
+        }
+        t_current_context = context;
+        t_context_generation = generation;
+        return 0;
+    }
+
+    int DeviceManager::setCurrentDevice(int device_id)
+    {
+        aclrtContext context = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto iter = m_devices.find(device_id);
+            if (m_devices.end() != iter && nullptr != iter->second.shared_context)
+                context = iter->second.shared_context;
+        }
+        if (nullptr != context)
+            return setCurrentContext(context);
+        // device has no shared context yet, open it and keep it open
+        return openDevice(device_id, true, context);
+    }
+
+    bool DeviceManager::enablePeerAccess(int device_id, int peer_device_id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto key = std::make_pair(device_id, peer_device_id);
+        auto iter = m_peer_access.find(key);
+        if (m_peer_access.end() != iter)
+            return iter->second;
+
+        int32_t can_access = 0;
+        auto ret = aclrtDeviceCanAccessPeer(&can_access, device_id, peer_device_id);
+        if (ACL_ERROR_NONE != ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_WARN, "check device {} access peer device {} failed, ret:{}, msg:{}", device_id, 
+                peer_device_id, int(ret), aclGetRecentErrMsg());
+            can_access = 0;
+        }
+        if (0 != can_access)
+        {
+            ret = aclrtDeviceEnablePeerAccess(peer_device_id, 0);
+            if (ACL_ERROR_NONE != ret)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_WARN, "enable device {} access peer device {} failed, ret:{}, msg:{}", 
+                    device_id, peer_device_id, int(ret), aclGetRecentErrMsg());
+                can_access = 0;
+            }
+        }
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "device {} access peer device {}: {}", device_id, peer_device_id, 
+            (0 != can_access) ? "direct" : "staged through host");
+        m_peer_access[key] = (0 != can_access);
+        return 0 != can_access;
+    }
+
+    int DeviceManager::getRefCount(int device_id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto iter = m_devices.find(device_id);
+        return (m_devices.end() == iter) ? 0 : iter->second.ref_count;
+    }
+
+} // namespace ACL_ENGINE
\ No newline at end of file
@@ -0,0 +1,75 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#pragma once
+#include <map>
+#include <mutex>
+#include <atomic>
+#include "acl/acl.h"
+#include "acl_engine/non_copyable.h"
+
+namespace ACL_ENGINE
+{
+
+    /**
+     * backend global owner of device open/reset and device contexts, device is set once when first opened
+     * and reset when last user closed, so closing one engine never disturbs other engines of the device.
+     * engines of a device share one context by default, each engine still runs on its own stream.
+     * current context of each thread is tracked, setting the same context again is skipped
+     */
+    class DeviceManager : public NonCopyable
+    {
+    public:
+        static DeviceManager& Instance();
+
+        /**
+         * @brief open device and get context to run on, current context of calling thread is set to it
+         * @param device_id, device to open
+         * @param shared, share context with other users of device, or create a private context
+         * @param context, context of device returned
+         * @return 0 if success, -1 if fail
+         */
+        int openDevice(int device_id, bool shared, aclrtContext& context);
+        // private context is destroyed, device is reset when last user closed
+        void closeDevice(int device_id, aclrtContext context);
+        // add a user of opened device without touching current context, fail if device not opened
+        int retainDevice(int device_id);
+
+        // skip acl call when context is already current of calling thread
+        int setCurrentContext(aclrtContext context);
+        // set shared context of device current, device opened here is kept until backend finalize
+        int setCurrentDevice(int device_id);
+        int getRefCount(int device_id);
+        /**
+         * @brief enable device to access memory of peer device, checked and enabled once per device pair,
+         *        current context of calling thread must be on device
+         * @return true if device can access peer memory directly, false if copies stage through host
+         */
+        bool enablePeerAccess(int device_id, int peer_device_id);
+
+    private:
+        DeviceManager() = default;
+        ~DeviceManager() = default;
+
+        typedef struct DeviceState
+        {
+            int                                 ref_count = 0;              // users opened device, engines and allocator
+            aclrtContext                        shared_context = nullptr;
+        } DeviceState;
+
+        int createContext(int device_id, aclrtContext& context);
+        void destroyContext(aclrtContext context);
+
+    private:
+        std::mutex                                                  m_mutex;
+        std::map<int, DeviceState>                                  m_devices;
+        // peer access result of device pairs, device -> peer device
+        std::map<std::pair<int, int>, bool>                         m_peer_access;
+        // increased when a context is destroyed, contexts tracked by threads before are stale
+        std::atomic<uint64_t>                                       m_context_generation{0};
+    };
+
+} // namespace ACL_ENGINE
\ No newline at end of file
@@ -0,0 +1,152 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#include <chrono>
+#include <algorithm>
+#include "acl_engine/log.h"
+#include "acl_engine/device_scheduler.h"
+
+namespace ACL_ENGINE
+{
+
+    // default execute cost of a model which has not been executed yet
+    #define DEVICE_SCHED_DEFAULT_EXEC_NS       1000000.0
+    // weight of the latest execute time in moving average
+    #define DEVICE_SCHED_EXEC_NS_ALPHA         0.2
+
+    static uint64_t getSteadyTimeNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    int parseDeviceSchedPolicy(const std::string& policy_str, DeviceSchedPolicy& policy)
+    {
+        static const std::map<std::string, DeviceSchedPolicy> policy_map = {
+            {"fifo",         DEVICE_SCHED_POLICY_FIFO},
+            {"fair_share",   DEVICE_SCHED_POLICY_FAIR_SHARE},
+            {"priority",     DEVICE_SCHED_POLICY_PRIORITY}};
+        auto iter = policy_map.find(policy_str);
+        if (policy_map.end() == iter)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "unsupported device sched policy {}, expect fifo/fair_share/priority", policy_str);
+            return -1;
+        }
+        policy = iter->second;
+        return 0;
+    }
+
+    DeviceScheduler& DeviceScheduler::Instance()
+    {
+        static DeviceScheduler scheduler;
+        return scheduler;
+    }
+
+    void DeviceScheduler::setDefaultConfig(const DeviceSchedConfig& config)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_default_config = config;
+        // device queues created before take the new config too
+        for (auto& it : m_device_queues)
+        {
+            std::lock_guard<std::mutex> queue_lock(it.second->mutex);
+            it.second->config = config;
+            it.second->cond.notify_all();
+        }
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "device scheduler policy:{}, max concurrent executes per device:{}",
+            int(config.policy), config.max_concurrent);
+    }
+
+    DeviceScheduler::DeviceQueue& DeviceScheduler::getDeviceQueue(int device_id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto iter = m_device_queues.find(device_id);
+        if (m_device_queues.end() == iter)
+        {
+            std::unique_ptr<DeviceQueue> queue(new DeviceQueue());
+            queue->config = m_default_config;
+            iter = m_device_queues.emplace(device_id, std::move(queue)).first;
+        }
+        return *(iter->second);
+    }
+
+    DeviceScheduler::SchedWaiter* DeviceScheduler::pickNext(DeviceQueue& queue)
+    {
+        if (queue.waiters.empty())
+            return nullptr;
+        auto policy = queue.config.policy;
+        auto iter = std::min_element(queue.waiters.begin(), queue.waiters.end(),
+            [policy](const SchedWaiter* a, const SchedWaiter* b) {
+                if (DEVICE_SCHED_POLICY_PRIORITY == policy && a->priority != b->priority)
+                    return a->priority > b->priority;
+                if (DEVICE_SCHED_POLICY_FAIR_SHARE == policy && a->finish_tag != b->finish_tag)
+                    return a->finish_tag < b->finish_tag;
+                return a->seq < b->seq;
+            });
+        return *iter;
+    }
+
+    uint64_t DeviceScheduler::acquire(int device_id, const std::string& model_name, int priority, int weight)
+    {
+        auto& queue = getDeviceQueue(device_id);
+        uint64_t enqueue_ns = getSteadyTimeNs();
+        std::unique_lock<std::mutex> lock(queue.mutex);
+
+        // start/finish tag for fair share, cost of execute is estimated with model's recent execute time
+        auto& model_state = queue.models[model_name];
+        double exec_cost = (0 < model_state.avg_exec_ns) ? model_state.avg_exec_ns : DEVICE_SCHED_DEFAULT_EXEC_NS;
+        SchedWaiter waiter;
+        waiter.seq = queue.seq++;
+        waiter.model_name = model_name;
+        waiter.priority = priority;
+        waiter.start_tag = std::max(queue.virtual_time, model_state.finish_tag);
+        waiter.finish_tag = waiter.start_tag + exec_cost / std::max(weight, 1);
+        model_state.finish_tag = waiter.finish_tag;
+
+        queue.waiters.push_back(&waiter);
+        queue.cond.wait(lock, [&]() {
+            bool has_slot = (0 >= queue.config.max_concurrent || queue.running < queue.config.max_concurrent);
+            return has_slot && &waiter == pickNext(queue);
+        });
+        queue.waiters.remove(&waiter);
+        queue.running++;
+        queue.virtual_time = std::max(queue.virtual_time, waiter.start_tag);
+        // other waiters may be runnable when there is still free slot
+        if (!queue.waiters.empty())
+            queue.cond.notify_all();
+        lock.unlock();
+
+        // queue time is reported by instance metrics of the caller
+        return getSteadyTimeNs() - enqueue_ns;
+    }
+
+    void DeviceScheduler::release(int device_id, const std::string& model_name, uint64_t exec_ns)
+    {
+        auto& queue = getDeviceQueue(device_id);
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        auto& model_state = queue.models[model_name];
+        if (0 >= model_state.avg_exec_ns)
+            model_state.avg_exec_ns = exec_ns;
+        else
+            model_state.avg_exec_ns = DEVICE_SCHED_EXEC_NS_ALPHA * exec_ns +
+                (1 - DEVICE_SCHED_EXEC_NS_ALPHA) * model_state.avg_exec_ns;
+        queue.running--;
+        queue.cond.notify_all();
+    }
+
+    DeviceExecuteGuard::DeviceExecuteGuard(int device_id, const std::string& model_name, int priority, int weight)
+        : m_device_id(device_id), m_model_name(model_name)
+    {
+        m_queue_time_ns = DeviceScheduler::Instance().acquire(m_device_id, m_model_name, priority, weight);
+        m_start_ns = getSteadyTimeNs();
+    }
+
+    DeviceExecuteGuard::~DeviceExecuteGuard()
+    {
+        DeviceScheduler::Instance().release(m_device_id, m_model_name, getSteadyTimeNs() - m_start_ns);
+    }
+
+} // namespace ACL_ENGINE
\ No newline at end of file
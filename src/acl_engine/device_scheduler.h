@@ -0,0 +1,112 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#pragma once
+#include <string>
+#include <map>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include "acl_engine/non_copyable.h"
+
+namespace ACL_ENGINE
+{
+
+    typedef enum DeviceSchedPolicy
+    {
+        DEVICE_SCHED_POLICY_FIFO                = 0,                        // first come first serve
+        DEVICE_SCHED_POLICY_FAIR_SHARE          = 1,                        // weighted fair share of device time
+        DEVICE_SCHED_POLICY_PRIORITY            = 2,                        // strict priority, fifo within same priority
+    } DeviceSchedPolicy;
+
+    typedef struct DeviceSchedConfig
+    {
+        DeviceSchedPolicy                       policy = DEVICE_SCHED_POLICY_FIFO;
+        int                                     max_concurrent = 0;         // max executes in flight per device, 0 means unlimited
+    } DeviceSchedConfig;
+
+    int parseDeviceSchedPolicy(const std::string& policy_str, DeviceSchedPolicy& policy);
+
+    /** backend global arbiter, every engine submit its model execute to the device it runs on */
+    class DeviceScheduler : public NonCopyable
+    {
+    public:
+        static DeviceScheduler& Instance();
+        void setDefaultConfig(const DeviceSchedConfig& config);
+
+        /**
+         * @brief wait until the execute is allowed to run on device
+         * @param device_id, device the execute will run on
+         * @param model_name, model submit the execute, used for fair share
+         * @param priority, larger value run first with priority policy
+         * @param weight, share of device time with fair share policy
+         * @return queue time in ns
+         */
+        uint64_t acquire(int device_id, const std::string& model_name, int priority, int weight);
+
+        /**
+         * @brief notify device scheduler the execute is finished
+         * @param exec_ns, device execute time, used to estimate cost of next execute of the model
+         */
+        void release(int device_id, const std::string& model_name, uint64_t exec_ns);
+
+    private:
+        DeviceScheduler() = default;
+        ~DeviceScheduler() = default;
+
+        typedef struct SchedWaiter
+        {
+            uint64_t                            seq;
+            std::string                         model_name;
+            int                                 priority;
+            double                              start_tag;
+            double                              finish_tag;
+        } SchedWaiter;
+
+        typedef struct SchedModelState
+        {
+            double                              finish_tag = 0;
+            double                              avg_exec_ns = 0;
+        } SchedModelState;
+
+        typedef struct DeviceQueue
+        {
+            std::mutex                          mutex;
+            std::condition_variable             cond;
+            DeviceSchedConfig                   config;
+            int                                 running = 0;
+            uint64_t                            seq = 0;
+            double                              virtual_time = 0;
+            std::list<SchedWaiter*>             waiters;
+            std::map<std::string, SchedModelState> models;
+        } DeviceQueue;
+
+        DeviceQueue& getDeviceQueue(int device_id);
+        SchedWaiter* pickNext(DeviceQueue& queue);
+
+    private:
+        std::mutex                                                  m_mutex;
+        DeviceSchedConfig                                           m_default_config;
+        std::map<int, std::unique_ptr<DeviceQueue>>                 m_device_queues;
+    };
+
+    /** submit execute to device scheduler during guard lifetime */
+    class DeviceExecuteGuard : public NonCopyable
+    {
+    public:
+        DeviceExecuteGuard(int device_id, const std::string& model_name, int priority, int weight);
+        ~DeviceExecuteGuard();
+        uint64_t queueTimeNs() { return m_queue_time_ns; }
+
+    private:
+        int                                     m_device_id;
+        std::string                             m_model_name;
+        uint64_t                                m_queue_time_ns = 0;
+        uint64_t                                m_start_ns = 0;
+    };
+
+} // namespace ACL_ENGINE
\ No newline at end of file
@@ -6,13 +6,16 @@
  ********************************************/
 #pragma once
 #include <stdio.h>
+#include "acl_engine/host_allocator.h"
 #define ENGINE_MEMORY_ALIGN_DEFAULT 64
 
 namespace ACL_ENGINE
 {
 
+    // host memory from size class pool, memoryAllocAlign never zero the memory
     void* memoryAllocAlign(size_t size, size_t align);
     void* memoryCallocAlign(size_t size, size_t align);
     void  memoryFreeAlign(void* mem);
+    void  getHostMemoryStats(HostMemoryPoolStats& stats);
 
 } //namespace ACL_ENGINE
\ No newline at end of file
@@ -0,0 +1,72 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#include "acl_engine/engine_releaser.h"
+
+namespace ACL_ENGINE
+{
+
+    EngineReleaser& EngineReleaser::Instance()
+    {
+        static EngineReleaser releaser;
+        return releaser;
+    }
+
+    EngineReleaser::~EngineReleaser()
+    {
+        shutdown();
+    }
+
+    void EngineReleaser::release(std::shared_ptr<void> object)
+    {
+        if (nullptr == object)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_stop)
+            {
+                if (!m_thread.joinable())
+                    m_thread = std::thread(&EngineReleaser::releaseLoop, this);
+                m_objects.push_back(std::move(object));
+                m_cond.notify_one();
+                return;
+            }
+        }
+        // released after shutdown, destroy on caller
+        object.reset();
+    }
+
+    void EngineReleaser::shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        if (m_thread.joinable())
+            m_thread.join();
+    }
+
+    void EngineReleaser::releaseLoop()
+    {
+        while (true)
+        {
+            std::shared_ptr<void> object;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cond.wait(lock, [this]() { return m_stop || !m_objects.empty(); });
+                // destroy pending objects before exit
+                if (m_stop && m_objects.empty())
+                    return;
+                object = std::move(m_objects.front());
+                m_objects.pop_front();
+            }
+            // destroyed outside lock, releasing other objects is not blocked by a slow unload
+            object.reset();
+        }
+    }
+
+} // namespace ACL_ENGINE
\ No newline at end of file
@@ -0,0 +1,44 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#pragma once
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <condition_variable>
+#include "acl_engine/non_copyable.h"
+
+namespace ACL_ENGINE
+{
+
+    /**
+     * backend global thread dropping engines off serving threads, model unload, buffer free and
+     * device close of released engine run here instead of on caller
+     */
+    class EngineReleaser : public NonCopyable
+    {
+    public:
+        static EngineReleaser& Instance();
+        // last reference of object is dropped on release thread, object is destroyed by its own deleter
+        void release(std::shared_ptr<void> object);
+        // destroy pending objects and stop release thread, objects released later are destroyed by caller
+        void shutdown();
+
+    private:
+        EngineReleaser() = default;
+        ~EngineReleaser();
+        void releaseLoop();
+
+    private:
+        std::mutex                                                  m_mutex;
+        std::condition_variable                                     m_cond;
+        std::deque<std::shared_ptr<void>>                           m_objects;
+        std::thread                                                 m_thread;
+        bool                                                        m_stop = false;
+    };
+
+} // namespace ACL_ENGINE
\ No newline at end of file
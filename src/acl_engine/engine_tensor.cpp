@@ -6,15 +6,66 @@
  ********************************************/
 #include <string.h>
 #include <numeric>
+#include <algorithm>
 #include "acl_engine/engine_tensor.h"
 #include "acl_engine/engine_memory_utils.h"
+#include "acl_engine/pinned_allocator.h"
+#include "acl_engine/numa_allocator.h"
 #ifdef ENGINE_SUPPORT_CUDA
 #include <cuda_runtime.h>
+#else
+#include <map>
+#include "acl/acl.h"
+#include "acl_engine/device_manager.h"
+#include "acl_engine/device_allocator.h"
 #endif
 
 namespace ACL_ENGINE
 {
 
+#ifndef ENGINE_SUPPORT_CUDA
+    /**
+     * open device_id and make it current for acl device memory call, the device reference is given back by
+     * leaveAclDevice, or kept by device memory malloced here until it is freed,
+     * current context of caller is saved and restored by leaveAclDevice
+     */
+    static bool enterAclDevice(int& device_id, aclrtContext& saved_context)
+    {
+        saved_context = nullptr;
+        (void)aclrtGetCurrentContext(&saved_context);
+        if (-1 == device_id)
+        {
+            int32_t current_device = -1;
+            auto acl_ret = aclrtGetDevice(&current_device);
+            if (ACL_ERROR_NONE != acl_ret || -1 == current_device)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "get current device id failed, ret:{}", int(acl_ret));
+                return false;
+            }
+            device_id = current_device;
+        }
+        aclrtContext context = nullptr;
+        if (0 != DeviceManager::Instance().openDevice(device_id, true, context))
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "open device {} failed", device_id);
+            return false;
+        }
+        return true;
+    }
+
+    static void leaveAclDevice(int device_id, aclrtContext saved_context, bool release = true)
+    {
+        if (release)
+            DeviceManager::Instance().closeDevice(device_id, nullptr);
+        if (nullptr == saved_context)
+            return;
+        if (0 != DeviceManager::Instance().setCurrentContext(saved_context))
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "restore current context failed");
+        }
+    }
+#endif
+
     static void* mallocDeviceMem(int mem_size, int& device_id)
     {
         void* device_ptr = nullptr;
@@ -61,7 +112,17 @@ namespace ACL_ENGINE
             }
         }
 #else
-        ACL_LOG(ACL_LOG_LEVEL_ERROR, "please rebuild with ENGINE_SUPPORT_CUDA");
+        // device stays open while tensor memory is alive, memory is cached by device allocator
+        aclrtContext saved_context = nullptr;
+        if (!enterAclDevice(device_id, saved_context))
+            return nullptr;
+        device_ptr = DeviceAllocatorManager::Instance().malloc(device_id, mem_size, nullptr);
+        leaveAclDevice(device_id, saved_context, nullptr == device_ptr);
+        if (nullptr == device_ptr)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "malloc device tensor buffer failed, size {}", mem_size);
+            return nullptr;
+        }
 #endif
         return device_ptr;
     }
@@ -105,7 +166,13 @@ namespace ACL_ENGINE
             }
         }
 #else
-        ACL_LOG(ACL_LOG_LEVEL_ERROR, "please rebuild with ENGINE_SUPPORT_CUDA");
+        aclrtContext saved_context = nullptr;
+        if (!enterAclDevice(device_id, saved_context))
+            return;
+        DeviceAllocatorManager::Instance().free(device_id, device_ptr);
+        // device reference kept by the memory since malloc
+        DeviceManager::Instance().closeDevice(device_id, nullptr);
+        leaveAclDevice(device_id, saved_context);
 #endif
         return;
     }
@@ -182,7 +249,26 @@ namespace ACL_ENGINE
             }
         }
 #else
-        ACL_LOG(ACL_LOG_LEVEL_ERROR, "please rebuild with ENGINE_SUPPORT_CUDA");
+        static const std::map<EngineTensor::TensorCopyKindType, aclrtMemcpyKind> acl_copy_kind_map = {
+            {EngineTensor::TENSOR_COPY_HOST_TO_DEVICE,   ACL_MEMCPY_HOST_TO_DEVICE},
+            {EngineTensor::TENSOR_COPY_DEVICE_TO_HOST,   ACL_MEMCPY_DEVICE_TO_HOST},
+            {EngineTensor::TENSOR_COPY_DEVICE_TO_DEVICE, ACL_MEMCPY_DEVICE_TO_DEVICE}};
+        auto kind_iter = acl_copy_kind_map.find(kind);
+        if (acl_copy_kind_map.end() == kind_iter)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "unsupported tensor copy kind type {}", int(kind));
+            return nullptr;
+        }
+        aclrtContext saved_context = nullptr;
+        if (!enterAclDevice(device_id, saved_context))
+            return nullptr;
+        auto acl_ret = aclrtMemcpy(dst_ptr, mem_size, src_ptr, mem_size, kind_iter->second);
+        leaveAclDevice(device_id, saved_context);
+        if (ACL_ERROR_NONE != acl_ret)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "copy device tensor data failed, size {}, ret:{}", mem_size, int(acl_ret));
+            return nullptr;
+        }
 #endif
         return dst_ptr;
     }
@@ -212,6 +298,7 @@ namespace ACL_ENGINE
                 m_buffer.device = (uint64_t)mallocDeviceMem(memory_size, device_id);
                 m_buffer.device_id = device_id;
             }
+            m_buffer.capacity = (memory_size > 0) ? memory_size : 0;
             m_buffer.own_flag = true;
         }
     }
@@ -241,6 +328,7 @@ namespace ACL_ENGINE
                 m_buffer.device = (uint64_t)mallocDeviceMem(memory_size, device_id);
                 m_buffer.device_id = device_id;
             }
+            m_buffer.capacity = (memory_size > 0) ? memory_size : 0;
             m_buffer.own_flag = true;
         }
     }
@@ -249,7 +337,12 @@ namespace ACL_ENGINE
     {
         if (nullptr != m_buffer.host && true == m_buffer.own_flag)
         {
-            memoryFreeAlign(m_buffer.host);
+            if (HOST_MEMORY_TYPE_PINNED == m_buffer.host_type)
+                PinnedHostPool::Instance().free(m_buffer.host);
+            else if (HOST_MEMORY_TYPE_NUMA == m_buffer.host_type)
+                NumaHostAllocator::Instance().free(m_buffer.host);
+            else
+                memoryFreeAlign(m_buffer.host);
         }
         if (nullptr != (void*)m_buffer.device && true == m_buffer.own_flag)
         {
@@ -302,6 +395,50 @@ namespace ACL_ENGINE
         return tensor.release();
     }
 
+    EngineTensor* EngineTensor::createWithCapacity(const std::vector<int64_t>& dims, EngineTensor::TensorDataType type, 
+        TensorFormatType format, size_t capacity, HostMemoryType host_type, int numa_node, bool huge_page)
+    {
+        std::unique_ptr<EngineTensor> tensor(new EngineTensor(dims, type, format, false));
+        auto tensor_size = tensor->size();
+        if (0 > tensor_size)
+            return nullptr;
+        size_t memory_size = std::max((size_t)tensor_size, capacity);
+        if (0 == memory_size)
+            return tensor.release();
+        void* host_data = nullptr;
+        if (HOST_MEMORY_TYPE_PINNED == host_type)
+            host_data = PinnedHostPool::Instance().malloc(memory_size);
+        else if (HOST_MEMORY_TYPE_NUMA == host_type)
+            host_data = NumaHostAllocator::Instance().malloc(memory_size, numa_node, huge_page);
+        if (nullptr == host_data)
+        {
+            host_data = memoryAllocAlign(memory_size, ENGINE_MEMORY_ALIGN_DEFAULT);
+            host_type = HOST_MEMORY_TYPE_DEFAULT;
+        }
+        if (nullptr == host_data)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "malloc host tensor buffer fail, capacity {}", memory_size);
+            return nullptr;
+        }
+        tensor->buffer().host = host_data;
+        tensor->buffer().host_type = host_type;
+        tensor->buffer().capacity = memory_size;
+        tensor->buffer().own_flag = true;
+        return tensor.release();
+    }
+
+    EngineTensor* EngineTensor::createPinned(const std::vector<int64_t>& dims, EngineTensor::TensorDataType type, 
+        TensorFormatType format)
+    {
+        return createWithCapacity(dims, type, format, 0, HOST_MEMORY_TYPE_PINNED);
+    }
+
+    EngineTensor* EngineTensor::createNuma(const std::vector<int64_t>& dims, EngineTensor::TensorDataType type, 
+        TensorFormatType format, int numa_node, bool huge_page)
+    {
+        return createWithCapacity(dims, type, format, 0, HOST_MEMORY_TYPE_NUMA, numa_node, huge_page);
+    }
+
     EngineTensor* EngineTensor::copy(EngineTensor* tensor)
     {
         std::unique_ptr<EngineTensor> copy_tensor;
@@ -439,15 +576,18 @@ namespace ACL_ENGINE
 
     int EngineTensor::reshape(const std::vector<int64_t> new_shape)
     {
-        int new_size = std::accumulate(new_shape.begin(), new_shape.end(), 1, std::multiplies<int>());
+        int64_t new_size = std::accumulate(new_shape.begin(), new_shape.end(), (int64_t)1, std::multiplies<int64_t>());
+        new_size *= m_buffer.elementBytes();
         int ori_size = size();
-        if (new_size == ori_size)
+        // owned data reserved with capacity can hold any shape fits in, no realloc needed
+        if (0 <= new_size && (new_size == ori_size || new_size <= (int64_t)capacity()))
         {
             m_buffer.dim = new_shape;
         }
         else
         {
-            ACL_LOG(ACL_LOG_LEVEL_ERROR, "ori tensor size {} not compatible with new size {}", ori_size, new_size);
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "ori tensor size {} capacity {} not compatible with new size {}", 
+                ori_size, capacity(), new_size);
             return -1;
         }
         return 0;
@@ -50,6 +50,13 @@ namespace ACL_ENGINE
             TENSOR_FORMAT_TYPE_ND          = 2,
             TENSOR_FORMAT_TYPE_MAX         ,
         };
+        /** where host memory of tensor is malloced from */
+        enum HostMemoryType
+        {
+            HOST_MEMORY_TYPE_DEFAULT       = 0,
+            HOST_MEMORY_TYPE_PINNED        = 1,
+            HOST_MEMORY_TYPE_NUMA          = 2,
+        };
     private:
         struct TensorBuffer 
         {
@@ -60,6 +67,8 @@ namespace ACL_ENGINE
             uint64_t                device;
             int                     device_id;
             bool                    own_flag = false;
+            HostMemoryType          host_type = HOST_MEMORY_TYPE_DEFAULT;
+            size_t                  capacity = 0;               // bytes of owned data, may be larger than dims need
             size_t elementBytes() const
             {
                 if (type == TENSOR_DATA_TYPE_INT8 || type == TENSOR_DATA_TYPE_UINT8)
@@ -140,6 +149,40 @@ namespace ACL_ENGINE
         static EngineTensor* create(const std::vector<int64_t>& shape, TensorDataType type, 
             TensorFormatType format = TENSOR_FORMAT_TYPE_NCHW, void* host_data = NULL);
 
+        /**
+         * @brief create tensor with host data reserved for capacity bytes, reshape within capacity won't realloc
+         * @param shape     tensor shape.
+         * @param type      data type.
+         * @param capacity  bytes to reserve, size of shape is used if smaller.
+         * @param host_type allocator of host data, fall back to default host memory.
+         * @param numa_node node host pages bound to when host_type is numa, -1 means no bind.
+         * @param huge_page back host data with huge pages when host_type is numa.
+         * @return created tensor.
+         */
+        static EngineTensor* createWithCapacity(const std::vector<int64_t>& shape, TensorDataType type, 
+            TensorFormatType format, size_t capacity, HostMemoryType host_type = HOST_MEMORY_TYPE_DEFAULT, 
+            int numa_node = -1, bool huge_page = false);
+
+        /**
+         * @brief create tensor with host data malloced from pinned host pool, fall back to pageable host memory
+         * @param shape     tensor shape.
+         * @param type      data type.
+         * @return created tensor.
+         */
+        static EngineTensor* createPinned(const std::vector<int64_t>& shape, TensorDataType type, 
+            TensorFormatType format = TENSOR_FORMAT_TYPE_NCHW);
+
+        /**
+         * @brief create tensor with host data mapped on numa node, fall back to default host memory
+         * @param shape     tensor shape.
+         * @param type      data type.
+         * @param numa_node node host pages bound to, -1 means no bind.
+         * @param huge_page back host data with huge pages if available.
+         * @return created tensor.
+         */
+        static EngineTensor* createNuma(const std::vector<int64_t>& shape, TensorDataType type, 
+            TensorFormatType format, int numa_node, bool huge_page);
+
         /**
          * @brief copy a new tensor have same shape, data type, data(or data ptr) and dimension type
          * @param tensor, origin tensor to be copy
@@ -204,6 +247,15 @@ namespace ACL_ENGINE
             return m_buffer.device;
         }
 
+        /**
+         * @brief host memory is page locked or not.
+         * @return true if host data is from pinned host pool.
+         */
+        bool isHostPinned() const
+        {
+            return HOST_MEMORY_TYPE_PINNED == m_buffer.host_type;
+        }
+
         /**
          * @brief visit device id.
          * @return device id. what the id means device memory locate in which device.
@@ -214,7 +266,16 @@ namespace ACL_ENGINE
         }
 
         /**
-         * @brief reshape tensor to a new valid dims
+         * @brief bytes reserved for tensor data.
+         * @return capacity bytes, 0 if tensor data is not owned.
+         */
+        size_t capacity() const
+        {
+            return m_buffer.own_flag ? m_buffer.capacity : 0;
+        }
+
+        /**
+         * @brief reshape tensor to a new valid dims, owned tensor can grow or shrink within capacity
          * @param new_shape, new dims
          * @return 0 success, else fail
          */
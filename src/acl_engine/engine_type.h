@@ -7,14 +7,40 @@
 #pragma once
 #include <iostream>
 #include <string>
+#include <vector>
 
 namespace ACL_ENGINE
 {
 
+    typedef enum EngineSyncMode
+    {
+        ENGINE_SYNC_MODE_BLOCKING               = 0,                                           // block until stream finish, lowest cpu usage
+        ENGINE_SYNC_MODE_SPIN                   = 1,                                           // busy poll event status, lowest latency
+        ENGINE_SYNC_MODE_YIELD                  = 2,                                           // poll event status, yield and backoff between polls
+    } EngineSyncMode;
+
     typedef struct EngineConfig
     {
         int                                       device_id = -1;                              // ascend core id
         std::string                               config_file = "";                            // model config file
+        std::string                               model_name = "";                             // model name, used by device scheduler
+        int                                       sched_priority = 0;                          // device scheduler priority, larger first
+        int                                       sched_weight = 1;                            // device scheduler fair share weight
+        int                                       execute_timeout_ms = 0;                      // model execute timeout, 0 means wait forever
+        bool                                      enable_graph_capture = false;                // capture model execute once per shape and replay
+        std::string                               sync_mode = "blocking";                      // wait stream mode, blocking/spin/yield
+        int                                       sync_cpu_core = -1;                          // host core polling thread pinned to, -1 means no pin
+        bool                                      pinned_output = false;                       // copy outputs back to pinned host buffers
+        std::vector<int>                          host_numa_nodes;                             // numa node of each device id, one value for all devices
+        bool                                      host_huge_pages = false;                     // back host output buffers with huge pages
+        std::string                               workspace_group = "";                        // models of same group on a device share work memory
+        std::string                               model_load_mode = "mmap";                    // mmap: load from mapped om file, file: acl reads om file itself
+        bool                                      model_map_populate = false;                  // read in all pages of om file when mapped
+        int                                       model_prefault_threads = 0;                  // threads prefault mapped om file, 0 means fault on demand
+        int                                       model_decompress_threads = 0;                // threads decompress .zst om file, 0 means one per cpu core
+        bool                                      share_device_context = true;                 // engines of a device share one context, each has own stream
+        bool                                      warmup = false;                              // execute every compiled gear with synthetic inputs after load
+        int                                       warmup_iterations = 3;                       // executes of each gear when warmup
     } EngineConfig;
 
 } // namespace ACL_ENGINE
\ No newline at end of file
@@ -4,7 +4,17 @@
  * @LastEditTime: 2024-06-13
  * @LastEditors: zhaojd-a
  ********************************************/
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+#include <algorithm>
 #include "acl_engine/file_stream.h"
+#include "acl_engine/zstd_decoder.h"
 #include "acl_engine/log.h"
 #include "ghc/filesystem.hpp"
 namespace fs = ghc::filesystem;
@@ -12,120 +22,198 @@ namespace fs = ghc::filesystem;
 namespace ACL_ENGINE
 {
 
+    static void fillFileStamp(const struct stat& file_stat, FileStamp& stamp)
+    {
+        stamp.inode = (uint64_t)file_stat.st_ino;
+        stamp.mtime_ns = (int64_t)file_stat.st_mtim.tv_sec * 1000000000 + file_stat.st_mtim.tv_nsec;
+        stamp.size = (int64_t)file_stat.st_size;
+    }
+
+    int statFileStamp(const std::string& file, FileStamp& stamp)
+    {
+        struct stat file_stat;
+        if (0 != stat(file.c_str(), &file_stat))
+            return -1;
+        fillFileStamp(file_stat, stamp);
+        return 0;
+    }
+
     // file input stream
-    FileInputStream::FileInputStream(const std::string file)
+    FileInputStream::FileInputStream(const std::string file, const FileMapConfig& config)
     {
         // init member var
         m_size = 0;
+        m_offset = 0;
         m_file = file;
         m_workpath = "";
-        m_in.open(file.c_str(), std::ios_base::binary);
-        if(!m_in.is_open())
+        int fd = open(file.c_str(), O_RDONLY);
+        if (0 > fd)
         {
-            ACL_LOG(ACL_LOG_LEVEL_ERROR, "open file {} failed.", file);
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "open file {} failed, {}", file, strerror(errno));
             return;
         }
 
         // get file size
-        m_in.seekg(0, std::ios::end);
-        m_size = m_in.tellg();
-        m_in.seekg(0, std::ios::beg);
-        if (0 >= m_size)
+        struct stat file_stat;
+        if (0 != fstat(fd, &file_stat) || 0 >= file_stat.st_size)
         {
-            ACL_LOG(ACL_LOG_LEVEL_ERROR, "file {} size:{} is <= 0, please check", file, m_size);
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "file {} size:{} is <= 0, please check", file, (int64_t)file_stat.st_size);
+            close(fd);
             return;
         }
+        m_size = (size_t)file_stat.st_size;
+        fillFileStamp(file_stat, m_stamp);
 
         // get file work path
         fs::path fs_path{m_file};
         fs::path fs_work_path = fs::absolute(fs_path).remove_filename();
         m_workpath = fs_work_path.string();
 
-        // check file size, if larger than
-        if (LARGE_FILE_THRESHOLD < m_size)
+        // mapping is kept after fd closed
+        int flags = MAP_PRIVATE | (config.populate ? MAP_POPULATE : 0);
+        void* data = mmap(nullptr, m_size, PROT_READ, flags, fd, 0);
+        close(fd);
+        if (MAP_FAILED == data)
         {
-            ACL_LOG(ACL_LOG_LEVEL_INFO, "file {} size:{} is larger than {}, try to use mmap to open", 
-                file, m_size, LARGE_FILE_THRESHOLD);
-            m_in.close();
-            std::error_code err;
-            m_map_file = mio::make_mmap_source(file, err);
-            if (err)
-            {
-                ACL_LOG(ACL_LOG_LEVEL_ERROR, "use mmap open file {} fail with {}", file, err.message());
-            }
-            size_t m_map_file_size = m_map_file.size();
-            if (m_map_file_size != m_size)
-            {
-                ACL_LOG(ACL_LOG_LEVEL_ERROR, "file {} mmap size {} not equal to file size {}", 
-                    file, m_map_file_size, m_size);
-            }
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "mmap file {} of {} bytes fail, {}", file, m_size, strerror(errno));
+            m_size = 0;
+            return;
+        }
+        m_data = (char*)data;
+
+        // file is consumed once from begin to end, let kernel read ahead aggressively
+        madvise(m_data, m_size, MADV_SEQUENTIAL);
+        madvise(m_data, m_size, MADV_WILLNEED);
+
+        // compressed file is decompressed into anonymous mapping, stream gives decompressed data
+        if (isZstdFile(file))
+        {
+            char* out_data = nullptr;
+            size_t out_size = 0;
+            int ret = zstdDecompress(m_data, m_size, config.decompress_threads, out_data, out_size);
+            munmap(m_data, m_size);
+            m_data = out_data;
+            m_size = out_size;
+            if (0 != ret)
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "decompress file {} fail", file);
+            return;
         }
+        if (!config.populate && 0 < config.prefault_threads)
+            prefault(config.prefault_threads);
     }
 
     FileInputStream::~FileInputStream()
     {
-        if (m_in.is_open())
-            m_in.close();
-        if (m_map_file.is_open())
-            m_map_file.unmap();
+        release();
     }
 
-    size_t FileInputStream::read(char* buf, size_t len)
+    void FileInputStream::prefault(int thread_num)
     {
-        if (!m_in.is_open())
-        {
-            ACL_LOG(ACL_LOG_LEVEL_ERROR, "read api only support file stream not for mmap, please check");
-            return 0;
-        }
-        ssize_t nread = 0;
-        if (nullptr == buf)
+        // touch one byte per page in parallel, page faults of network filesystem are served concurrently
+        const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+        size_t chunk_size = (m_size + thread_num - 1) / thread_num;
+        chunk_size = (chunk_size + page_size - 1) / page_size * page_size;
+        std::vector<std::thread> threads;
+        for (size_t begin = 0; begin < m_size; begin += chunk_size)
         {
-            return nread;
+            size_t end = std::min(begin + chunk_size, m_size);
+            const char* data = m_data;
+            threads.emplace_back([data, begin, end, page_size]() {
+                volatile char sum = 0;
+                for (size_t offset = begin; offset < end; offset += page_size)
+                    sum += data[offset];
+                (void)sum;
+            });
         }
-        if(m_in.is_open())
-        {
-            m_in.read(buf, len);
-            if(!m_in.bad()) 
-            {
-                nread = m_in.gcount();
-            }
-        }
-        if(nread > 0)
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    void FileInputStream::release()
+    {
+        if (nullptr == m_data)
+            return;
+        if (0 != munmap(m_data, m_size))
+            ACL_LOG(ACL_LOG_LEVEL_WARN, "munmap file {} fail, {}", m_file, strerror(errno));
+        m_data = nullptr;
+        m_offset = 0;
+    }
+
+    size_t FileInputStream::read(char* buf, size_t len)
+    {
+        if (nullptr == m_data)
         {
-            return (size_t)nread;
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "file {} is not open or released, please check", m_file);
+            return 0;
         }
-        else
+        if (nullptr == buf || m_offset >= m_size)
         {
             return 0;
         }
+        size_t nread = std::min(len, m_size - m_offset);
+        memcpy(buf, m_data + m_offset, nread);
+        m_offset += nread;
+        return nread;
     }
 
     bool FileInputStream::isOpen()
     {
-        return m_in.is_open() || m_map_file.is_open();
+        return nullptr != m_data;
     }
 
     const char* FileInputStream::getFileData()
     {
-        if (m_in.is_open())
+        return (const char*)m_data;
+    }
+
+    MappedFileCache& MappedFileCache::Instance()
+    {
+        static MappedFileCache cache;
+        return cache;
+    }
+
+    std::shared_ptr<FileInputStream> MappedFileCache::acquire(const std::string& file, const FileMapConfig& config)
+    {
+        std::promise<std::shared_ptr<FileInputStream>> promise;
         {
-            if (nullptr == m_file_data.get())
+            std::unique_lock<std::mutex> lock(m_mutex);
+            auto& entry = m_files[file];
+            // concurrent loaders of same file wait for its first caller instead of reading it again
+            if (entry.pending.valid())
             {
-                m_file_data.reset(new char[m_size], std::default_delete<char []>());
-                if (m_size != read(m_file_data.get(), m_size))
-                {
-                    ACL_LOG(ACL_LOG_LEVEL_ERROR, "read data from file {} fail", m_file);
-                    return nullptr;
-                }
+                auto pending = entry.pending;
+                lock.unlock();
+                return pending.get();
             }
-            return (const char*)m_file_data.get();
+            // file replaced on disk gets a new mapping, holders of old mapping keep old data
+            FileStamp stamp;
+            auto file_stream = entry.stream.lock();
+            if (nullptr != file_stream && 0 == statFileStamp(file, stamp) && stamp == file_stream->getFileStamp())
+                return file_stream;
+            entry.stream.reset();
+            entry.pending = promise.get_future().share();
         }
-        else if(m_map_file.is_open())
+
+        // map, populate and decompress file without lock
+        std::shared_ptr<FileInputStream> file_stream(new FileInputStream(file, config));
+        if (!file_stream->isOpen())
+            file_stream.reset();
         {
-            return m_map_file.data();
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto& entry = m_files[file];
+            entry.stream = file_stream;
+            entry.pending = std::shared_future<std::shared_ptr<FileInputStream>>();
+            // expired entries are dropped here, cache never grows with unloaded models
+            for (auto it = m_files.begin(); it != m_files.end();)
+            {
+                if (!it->second.pending.valid() && it->second.stream.expired())
+                    it = m_files.erase(it);
+                else
+                    it++;
+            }
         }
-        else
-            return nullptr;
+        promise.set_value(file_stream);
+        return file_stream;
     }
 
     FileOutputStream::FileOutputStream(const std::string file)
@@ -9,36 +9,95 @@
 #include <string>
 #include <fstream>
 #include <memory>
-#include "mio/mio.h"
+#include <mutex>
+#include <future>
+#include <map>
 #include "acl_engine/base_stream.h"
 
-#define LARGE_FILE_THRESHOLD  512*1024*1024
-
 namespace ACL_ENGINE
 {
 
+    typedef struct FileMapConfig
+    {
+        bool                        populate = false;           // MAP_POPULATE, pages are read in by mmap itself
+        int                         prefault_threads = 0;       // threads touch pages after mmap, 0 means fault on demand
+        int                         decompress_threads = 0;     // threads decompress .zst file, 0 means one per cpu core
+    } FileMapConfig;
+
+    /** identity of file on disk, file replaced or rewritten gets a different stamp */
+    typedef struct FileStamp
+    {
+        uint64_t                    inode = 0;
+        int64_t                     mtime_ns = 0;
+        int64_t                     size = 0;
+        bool operator==(const FileStamp& other) const
+        {
+            return inode == other.inode && mtime_ns == other.mtime_ns && size == other.size;
+        }
+        bool operator!=(const FileStamp& other) const { return !(*this == other); }
+    } FileStamp;
+
+    // return 0 if success, -1 if stat file fail
+    int statFileStamp(const std::string& file, FileStamp& stamp);
+
+    /**
+     * input file is always mmaped read only and hinted for sequential read, so file data
+     * is never copied into process heap, call release to drop the mapping once data is consumed.
+     * .zst file is decompressed at open, data and size of stream are the decompressed ones
+     */
     class FileInputStream : public BaseInputStream
     {
     public:
-        FileInputStream(const std::string file);
+        FileInputStream(const std::string file, const FileMapConfig& config = FileMapConfig());
         virtual ~FileInputStream();
         size_t read(char* buf, size_t len) override;
         const char* getFileData();
         std::string getFile() { return m_file; }
-        std::ifstream& getStream() { return m_in; }
         bool isOpen();
         virtual const char* getWorkPath() override { return m_workpath.c_str(); }
         size_t getFileSize() { return m_size; }
+        const FileStamp& getFileStamp() { return m_stamp; }
+        // unmap file data, pointers from getFileData are invalid after release
+        void release();
+
+    private:
+        void prefault(int thread_num);
 
     private:
         size_t                      m_size = 0;
-        std::ifstream               m_in;
+        size_t                      m_offset = 0;               // read offset of read api
         std::string                 m_file;
         std::string                 m_workpath;
-        // file data for call getFileData when use fstream
-        std::shared_ptr<char>       m_file_data;
-        // large file size
-        mio::shared_mmap_source     m_map_file;
+        char*                       m_data = nullptr;           // mapped file data
+        FileStamp                   m_stamp;                    // file mapped, mapping keeps old data if file replaced
+    };
+
+    /**
+     * process wide cache of mapped input files, engines loading same file at same time share one mapping,
+     * holder of returned stream keeps mapping alive, mapping is dropped with its last holder.
+     * mapping of a file changed on disk since mapped is never returned
+     */
+    class MappedFileCache : public NonCopyable
+    {
+    public:
+        static MappedFileCache& Instance();
+        std::shared_ptr<FileInputStream> acquire(const std::string& file, const FileMapConfig& config = FileMapConfig());
+
+    private:
+        MappedFileCache() = default;
+        ~MappedFileCache() = default;
+
+        // mapping of file, or mapping being built by first caller which same file callers wait for
+        typedef struct CachedFile
+        {
+            std::weak_ptr<FileInputStream>                          stream;
+            std::shared_future<std::shared_ptr<FileInputStream>>    pending;
+        } CachedFile;
+
+    private:
+        // held only for lookup, files are mapped without it so loads of different files run in parallel
+        std::mutex                                                  m_mutex;
+        std::map<std::string, CachedFile>                           m_files;
     };
 
     class FileOutputStream : public BaseOutputStream 
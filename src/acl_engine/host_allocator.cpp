@@ -0,0 +1,276 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include "acl_engine/log.h"
+#include "acl_engine/host_allocator.h"
+
+namespace ACL_ENGINE
+{
+
+    // pooled blocks are aligned to this, header of block is kept in the prefix
+    #define HOST_POOL_ALIGNMENT                64
+    #define HOST_POOL_PREFIX_SIZE              64
+    // size classes from min to max, 4 classes per power of 2
+    #define HOST_POOL_MIN_CLASS_SIZE           256UL
+    #define HOST_POOL_MAX_CLASS_SIZE           (256UL << 20)
+    #define HOST_POOL_CLASSES_PER_DOUBLE       4
+    // bytes cached by one size class bin of thread cache, larger classes go to global pool directly
+    #define HOST_POOL_THREAD_BIN_BYTES         (16UL << 20)
+    #define HOST_POOL_THREAD_BIN_MAX_BLOCKS    32
+    #define HOST_POOL_THREAD_MAX_CLASS_SIZE    (1UL << 20)
+    // max bytes of free blocks kept in thread cache of one thread, all bins included
+    #define HOST_POOL_THREAD_CACHE_BYTES       (32UL << 20)
+    // max bytes of free blocks kept in global pool
+    #define HOST_POOL_MAX_CACHED_BYTES         (1UL << 30)
+    #define HOST_POOL_BLOCK_MAGIC              0x48504F4C
+
+    // thread cache may be used by other thread local objects after destroyed
+    static thread_local bool t_thread_cache_destroyed = false;
+
+    HostMemoryPool::HostThreadCache::~HostThreadCache()
+    {
+        HostMemoryPool::Instance().flushThreadCache(*this);
+        t_thread_cache_destroyed = true;
+    }
+
+    HostMemoryPool& HostMemoryPool::Instance()
+    {
+        static HostMemoryPool pool;
+        return pool;
+    }
+
+    HostMemoryPool::HostMemoryPool()
+    {
+        for (size_t base = HOST_POOL_MIN_CLASS_SIZE; base < HOST_POOL_MAX_CLASS_SIZE; base <<= 1)
+        {
+            for (size_t index = 0; index < HOST_POOL_CLASSES_PER_DOUBLE; index++)
+                m_class_sizes.push_back(base + base / HOST_POOL_CLASSES_PER_DOUBLE * index);
+        }
+        m_class_sizes.push_back(HOST_POOL_MAX_CLASS_SIZE);
+        m_pool_bins.resize(m_class_sizes.size());
+    }
+
+    HostMemoryPool::~HostMemoryPool()
+    {
+        HostMemoryPoolStats stats;
+        getStats(stats);
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "host memory pool alloc count:{}, thread cache hit:{}, pool hit:{}, system alloc:{}", 
+            stats.alloc_count, stats.thread_cache_hit_count, stats.pool_hit_count, stats.system_alloc_count);
+        trim();
+    }
+
+    int HostMemoryPool::sizeClassIndex(size_t size)
+    {
+        if (size > HOST_POOL_MAX_CLASS_SIZE)
+            return -1;
+        auto iter = std::lower_bound(m_class_sizes.begin(), m_class_sizes.end(), size);
+        return int(iter - m_class_sizes.begin());
+    }
+
+    size_t HostMemoryPool::binCapacity(int size_class)
+    {
+        if (m_class_sizes[size_class] > HOST_POOL_THREAD_MAX_CLASS_SIZE)
+            return 0;
+        size_t capacity = HOST_POOL_THREAD_BIN_BYTES / m_class_sizes[size_class];
+        return std::min(capacity, (size_t)HOST_POOL_THREAD_BIN_MAX_BLOCKS);
+    }
+
+    HostMemoryPool::HostThreadCache* HostMemoryPool::threadCache()
+    {
+        if (t_thread_cache_destroyed)
+            return nullptr;
+        static thread_local HostThreadCache cache;
+        if (cache.bins.empty())
+            cache.bins.resize(m_class_sizes.size());
+        return &cache;
+    }
+
+    HostMemoryPool::HostBlockHeader* HostMemoryPool::getHeader(void* ptr)
+    {
+        return (HostBlockHeader*)((uint8_t*)ptr - sizeof(HostBlockHeader));
+    }
+
+    void* HostMemoryPool::systemMalloc(size_t size, size_t alignment)
+    {
+        alignment = std::max(alignment, alignof(HostBlockHeader));
+        void* origin = ::malloc(size + sizeof(HostBlockHeader) + alignment);
+        if (nullptr == origin)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "malloc {} bytes from system fail", size);
+            return nullptr;
+        }
+        uintptr_t start = (uintptr_t)origin + sizeof(HostBlockHeader);
+        void* aligned = (void*)((start + alignment - 1) & ~(uintptr_t)(alignment - 1));
+        auto header = getHeader(aligned);
+        header->origin = origin;
+        header->size = size;
+        header->size_class = -1;
+        header->magic = HOST_POOL_BLOCK_MAGIC;
+        return aligned;
+    }
+
+    void* HostMemoryPool::poolMalloc(int size_class)
+    {
+        auto cache = threadCache();
+        if (nullptr != cache && !cache->bins[size_class].empty())
+        {
+            void* origin = cache->bins[size_class].back();
+            cache->bins[size_class].pop_back();
+            cache->cached_bytes -= m_class_sizes[size_class];
+            m_thread_cache_hit_count++;
+            return origin;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto& bin = m_pool_bins[size_class];
+            if (!bin.empty())
+            {
+                void* origin = bin.back();
+                bin.pop_back();
+                m_cached_bytes -= m_class_sizes[size_class];
+                m_pool_hit_count++;
+                return origin;
+            }
+        }
+        void* origin = nullptr;
+        if (0 != posix_memalign(&origin, HOST_POOL_ALIGNMENT, HOST_POOL_PREFIX_SIZE + m_class_sizes[size_class]))
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "malloc {} bytes from system fail", m_class_sizes[size_class]);
+            return nullptr;
+        }
+        m_system_alloc_count++;
+        return origin;
+    }
+
+    void HostMemoryPool::poolFree(int size_class, void* origin)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_cached_bytes + m_class_sizes[size_class] <= HOST_POOL_MAX_CACHED_BYTES)
+            {
+                m_pool_bins[size_class].push_back(origin);
+                m_cached_bytes += m_class_sizes[size_class];
+                return;
+            }
+        }
+        ::free(origin);
+    }
+
+    void HostMemoryPool::flushThreadCache(HostThreadCache& cache)
+    {
+        for (size_t size_class = 0; size_class < cache.bins.size(); size_class++)
+        {
+            for (auto origin : cache.bins[size_class])
+                poolFree(int(size_class), origin);
+            cache.bins[size_class].clear();
+        }
+        cache.cached_bytes = 0;
+    }
+
+    void* HostMemoryPool::malloc(size_t size, size_t alignment)
+    {
+        m_alloc_count++;
+        m_requested_bytes += size;
+        int size_class = sizeClassIndex(size);
+        if (0 > size_class || HOST_POOL_ALIGNMENT < alignment)
+        {
+            void* ptr = systemMalloc(size, alignment);
+            if (nullptr == ptr)
+            {
+                m_requested_bytes -= size;
+                return nullptr;
+            }
+            m_system_alloc_count++;
+            m_in_use_bytes += size;
+            return ptr;
+        }
+
+        void* origin = poolMalloc(size_class);
+        if (nullptr == origin)
+        {
+            m_requested_bytes -= size;
+            return nullptr;
+        }
+        void* ptr = (uint8_t*)origin + HOST_POOL_PREFIX_SIZE;
+        auto header = getHeader(ptr);
+        header->origin = origin;
+        header->size = size;
+        header->size_class = size_class;
+        header->magic = HOST_POOL_BLOCK_MAGIC;
+        m_in_use_bytes += m_class_sizes[size_class];
+        return ptr;
+    }
+
+    void HostMemoryPool::free(void* ptr)
+    {
+        if (nullptr == ptr)
+            return;
+        auto header = getHeader(ptr);
+        if (HOST_POOL_BLOCK_MAGIC != header->magic)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "free ptr 0x{:x} not allocated by host memory pool", (size_t)ptr);
+            return;
+        }
+        header->magic = 0;
+        m_requested_bytes -= header->size;
+        int size_class = header->size_class;
+        void* origin = header->origin;
+        if (0 > size_class)
+        {
+            m_in_use_bytes -= header->size;
+            ::free(origin);
+            return;
+        }
+
+        size_t class_size = m_class_sizes[size_class];
+        m_in_use_bytes -= class_size;
+        auto cache = threadCache();
+        if (nullptr != cache && cache->bins[size_class].size() < binCapacity(size_class) && 
+            cache->cached_bytes + class_size <= HOST_POOL_THREAD_CACHE_BYTES)
+        {
+            cache->bins[size_class].push_back(origin);
+            cache->cached_bytes += class_size;
+            return;
+        }
+        poolFree(size_class, origin);
+    }
+
+    size_t HostMemoryPool::usableSize(void* ptr)
+    {
+        auto header = getHeader(ptr);
+        if (0 > header->size_class)
+            return header->size;
+        return m_class_sizes[header->size_class];
+    }
+
+    void HostMemoryPool::getStats(HostMemoryPoolStats& stats)
+    {
+        stats.alloc_count = m_alloc_count;
+        stats.thread_cache_hit_count = m_thread_cache_hit_count;
+        stats.pool_hit_count = m_pool_hit_count;
+        stats.system_alloc_count = m_system_alloc_count;
+        stats.requested_bytes = m_requested_bytes;
+        stats.in_use_bytes = m_in_use_bytes;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stats.cached_bytes = m_cached_bytes;
+    }
+
+    void HostMemoryPool::trim()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& bin : m_pool_bins)
+        {
+            for (auto origin : bin)
+                ::free(origin);
+            bin.clear();
+        }
+        m_cached_bytes = 0;
+    }
+
+} // namespace ACL_ENGINE
\ No newline at end of file
@@ -0,0 +1,90 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#pragma once
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include "acl_engine/non_copyable.h"
+
+namespace ACL_ENGINE
+{
+
+    typedef struct HostMemoryPoolStats
+    {
+        uint64_t                                alloc_count = 0;
+        uint64_t                                thread_cache_hit_count = 0;     // alloc served by thread local cache
+        uint64_t                                pool_hit_count = 0;             // alloc served by global pool
+        uint64_t                                system_alloc_count = 0;         // alloc fall to system malloc
+        size_t                                  requested_bytes = 0;            // bytes requested by blocks in use
+        size_t                                  in_use_bytes = 0;               // size class bytes of blocks in use
+        size_t                                  cached_bytes = 0;               // bytes of free blocks in global pool
+    } HostMemoryPoolStats;
+
+    /**
+     * size class pool of aligned host memory, freed blocks are kept in a thread local cache first
+     * and then in a global pool, so host tensors of repeated requests never reach system malloc
+     */
+    class HostMemoryPool : public NonCopyable
+    {
+    public:
+        static HostMemoryPool& Instance();
+
+        /**
+         * @brief malloc aligned host memory, content is not zeroed
+         * @param size, bytes to malloc
+         * @param alignment, power of 2, larger than pool alignment fall to system malloc
+         * @return host ptr, nullptr if fail
+         */
+        void* malloc(size_t size, size_t alignment);
+        void free(void* ptr);
+        size_t usableSize(void* ptr);
+        void getStats(HostMemoryPoolStats& stats);
+        // release free blocks of global pool to system
+        void trim();
+
+    private:
+        HostMemoryPool();
+        ~HostMemoryPool();
+
+        typedef struct HostBlockHeader
+        {
+            void*                               origin;
+            size_t                              size;                           // requested size
+            int32_t                             size_class;                     // -1 means not pooled
+            uint32_t                            magic;
+        } HostBlockHeader;
+
+        typedef struct HostThreadCache
+        {
+            std::vector<std::vector<void*>>     bins;
+            size_t                              cached_bytes = 0;
+            ~HostThreadCache();
+        } HostThreadCache;
+
+        int sizeClassIndex(size_t size);
+        size_t binCapacity(int size_class);
+        HostThreadCache* threadCache();
+        void* systemMalloc(size_t size, size_t alignment);
+        void* poolMalloc(int size_class);
+        void poolFree(int size_class, void* origin);
+        void flushThreadCache(HostThreadCache& cache);
+        static HostBlockHeader* getHeader(void* ptr);
+
+    private:
+        std::vector<size_t>                                         m_class_sizes;
+        std::mutex                                                  m_mutex;
+        std::vector<std::vector<void*>>                             m_pool_bins;
+        size_t                                                      m_cached_bytes = 0;
+        std::atomic<uint64_t>                                       m_alloc_count{0};
+        std::atomic<uint64_t>                                       m_thread_cache_hit_count{0};
+        std::atomic<uint64_t>                                       m_pool_hit_count{0};
+        std::atomic<uint64_t>                                       m_system_alloc_count{0};
+        std::atomic<size_t>                                         m_requested_bytes{0};
+        std::atomic<size_t>                                         m_in_use_bytes{0};
+    };
+
+} // namespace ACL_ENGINE
\ No newline at end of file
@@ -0,0 +1,185 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <chrono>
+#include "acl_engine/log.h"
+#include "acl_engine/load_scheduler.h"
+
+namespace ACL_ENGINE
+{
+
+    static uint64_t getSteadyTimeNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    ModelLoadScheduler& ModelLoadScheduler::Instance()
+    {
+        static ModelLoadScheduler scheduler;
+        return scheduler;
+    }
+
+    void ModelLoadScheduler::setConfig(const ModelLoadConfig& config)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_config = config;
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "model load io concurrency:{}, device load concurrency:{}, prefetch count:{}", 
+            m_config.io_concurrency, m_config.device_load_concurrency, m_config.prefetch_count);
+    }
+
+    bool ModelLoadScheduler::throttleIo()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return 0 < m_config.io_concurrency;
+    }
+
+    void ModelLoadScheduler::pickPrefetchFiles(std::vector<std::string>& files)
+    {
+        int window = 0;
+        for (auto& waiter : m_read_waiters)
+        {
+            if (window++ >= m_config.prefetch_count)
+                break;
+            if (m_prefetched_files.end() != m_prefetched_files.find(waiter.file))
+                continue;
+            m_prefetched_files.insert(waiter.file);
+            files.push_back(waiter.file);
+        }
+    }
+
+    void ModelLoadScheduler::prefetchFiles(const std::vector<std::string>& files)
+    {
+        // kernel reads file in background, caller is not blocked by the read
+        for (auto& file : files)
+        {
+            int fd = open(file.c_str(), O_RDONLY);
+            if (0 > fd)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_WARN, "open file {} to prefetch fail, {}", file, strerror(errno));
+                continue;
+            }
+            int ret = posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+            if (0 != ret)
+                ACL_LOG(ACL_LOG_LEVEL_WARN, "prefetch file {} fail, {}", file, strerror(ret));
+            else
+                ACL_LOG(ACL_LOG_LEVEL_DEBUG, "prefetch queued model file {}", file);
+            close(fd);
+        }
+    }
+
+    uint64_t ModelLoadScheduler::acquireRead(const std::string& file)
+    {
+        uint64_t start_ns = getSteadyTimeNs();
+        std::vector<std::string> prefetch_files;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            int io_concurrency = m_config.io_concurrency;
+            if (0 >= io_concurrency)
+            {
+                m_reading++;
+                return 0;
+            }
+            uint64_t seq = m_read_seq++;
+            m_read_waiters.push_back({seq, file});
+            pickPrefetchFiles(prefetch_files);
+            if (!prefetch_files.empty())
+            {
+                lock.unlock();
+                prefetchFiles(prefetch_files);
+                prefetch_files.clear();
+                lock.lock();
+            }
+            m_cond.wait(lock, [&]() { return m_reading < io_concurrency && seq == m_read_waiters.front().seq; });
+            m_read_waiters.pop_front();
+            m_prefetched_files.erase(file);
+            m_reading++;
+            // read ahead window moves on
+            pickPrefetchFiles(prefetch_files);
+        }
+        // next waiter may take another free slot
+        m_cond.notify_all();
+        prefetchFiles(prefetch_files);
+        return getSteadyTimeNs() - start_ns;
+    }
+
+    void ModelLoadScheduler::releaseRead()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_reading--;
+        }
+        m_cond.notify_all();
+    }
+
+    uint64_t ModelLoadScheduler::acquireLoad(int device_id)
+    {
+        uint64_t start_ns = getSteadyTimeNs();
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            auto& queue = m_device_queues[device_id];
+            int load_concurrency = m_config.device_load_concurrency;
+            if (0 >= load_concurrency)
+            {
+                queue.loading++;
+                return 0;
+            }
+            uint64_t seq = queue.seq++;
+            queue.waiters.push_back(seq);
+            m_cond.wait(lock, [&]() { return queue.loading < load_concurrency && seq == queue.waiters.front(); });
+            queue.waiters.pop_front();
+            queue.loading++;
+        }
+        m_cond.notify_all();
+        return getSteadyTimeNs() - start_ns;
+    }
+
+    void ModelLoadScheduler::releaseLoad(int device_id)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_device_queues[device_id].loading--;
+        }
+        m_cond.notify_all();
+    }
+
+    ModelReadGuard::ModelReadGuard(const std::string& file)
+    {
+        m_queue_time_ns = ModelLoadScheduler::Instance().acquireRead(file);
+        m_start_ns = getSteadyTimeNs();
+    }
+
+    ModelReadGuard::~ModelReadGuard()
+    {
+        ModelLoadScheduler::Instance().releaseRead();
+    }
+
+    uint64_t ModelReadGuard::elapsedNs()
+    {
+        return getSteadyTimeNs() - m_start_ns;
+    }
+
+    ModelLoadGuard::ModelLoadGuard(int device_id) : m_device_id(device_id)
+    {
+        m_queue_time_ns = ModelLoadScheduler::Instance().acquireLoad(m_device_id);
+        m_start_ns = getSteadyTimeNs();
+    }
+
+    ModelLoadGuard::~ModelLoadGuard()
+    {
+        ModelLoadScheduler::Instance().releaseLoad(m_device_id);
+    }
+
+    uint64_t ModelLoadGuard::elapsedNs()
+    {
+        return getSteadyTimeNs() - m_start_ns;
+    }
+
+} // namespace ACL_ENGINE
\ No newline at end of file
@@ -0,0 +1,120 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#pragma once
+#include <set>
+#include <map>
+#include <list>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include "acl_engine/non_copyable.h"
+
+namespace ACL_ENGINE
+{
+
+    typedef struct ModelLoadConfig
+    {
+        int                                     io_concurrency = 0;         // model files read at same time, 0 means unlimited
+        int                                     device_load_concurrency = 0;// models loaded per device at same time, 0 means unlimited
+        int                                     prefetch_count = 2;         // queued files read ahead into page cache, 0 means no read ahead
+    } ModelLoadConfig;
+
+    typedef struct ModelLoadStats
+    {
+        uint64_t                                load_count = 0;
+        uint64_t                                file_bytes = 0;             // bytes of model files read
+        uint64_t                                io_queue_time_ns = 0;       // accumulated wait for io slot
+        uint64_t                                read_time_ns = 0;           // accumulated model file read
+        uint64_t                                device_queue_time_ns = 0;   // accumulated wait for device load slot
+        uint64_t                                load_time_ns = 0;           // accumulated acl model load
+    } ModelLoadStats;
+
+    /**
+     * backend global arbiter of model loads, model file reads share io slots and acl model loads share
+     * per device load slots, both served in fifo order. files waiting for io slot are read ahead into
+     * page cache a few at a time, so they are read from memory when their turn comes
+     */
+    class ModelLoadScheduler : public NonCopyable
+    {
+    public:
+        static ModelLoadScheduler& Instance();
+        void setConfig(const ModelLoadConfig& config);
+        // file reads are throttled, mapped files should be read in while holding io slot
+        bool throttleIo();
+
+        // wait until file is allowed to be read, return queue time in ns
+        uint64_t acquireRead(const std::string& file);
+        void releaseRead();
+        // wait until model is allowed to be loaded to device, return queue time in ns
+        uint64_t acquireLoad(int device_id);
+        void releaseLoad(int device_id);
+
+    private:
+        ModelLoadScheduler() = default;
+        ~ModelLoadScheduler() = default;
+
+        typedef struct ReadWaiter
+        {
+            uint64_t                            seq;
+            std::string                         file;
+        } ReadWaiter;
+
+        typedef struct DeviceLoadQueue
+        {
+            int                                 loading = 0;
+            uint64_t                            seq = 0;
+            std::list<uint64_t>                 waiters;
+        } DeviceLoadQueue;
+
+        // pick queued files of read ahead window not prefetched yet, called with lock held
+        void pickPrefetchFiles(std::vector<std::string>& files);
+        void prefetchFiles(const std::vector<std::string>& files);
+
+    private:
+        std::mutex                                                  m_mutex;
+        std::condition_variable                                     m_cond;
+        ModelLoadConfig                                             m_config;
+        int                                                         m_reading = 0;
+        uint64_t                                                    m_read_seq = 0;
+        std::list<ReadWaiter>                                       m_read_waiters;
+        std::set<std::string>                                       m_prefetched_files;
+        std::map<int, DeviceLoadQueue>                              m_device_queues;
+    };
+
+    /** hold io slot during guard lifetime */
+    class ModelReadGuard : public NonCopyable
+    {
+    public:
+        explicit ModelReadGuard(const std::string& file);
+        ~ModelReadGuard();
+        uint64_t queueTimeNs() { return m_queue_time_ns; }
+        // time since io slot acquired
+        uint64_t elapsedNs();
+
+    private:
+        uint64_t                                m_queue_time_ns = 0;
+        uint64_t                                m_start_ns = 0;
+    };
+
+    /** hold device load slot during guard lifetime */
+    class ModelLoadGuard : public NonCopyable
+    {
+    public:
+        explicit ModelLoadGuard(int device_id);
+        ~ModelLoadGuard();
+        uint64_t queueTimeNs() { return m_queue_time_ns; }
+        // time since load slot acquired
+        uint64_t elapsedNs();
+
+    private:
+        int                                     m_device_id;
+        uint64_t                                m_queue_time_ns = 0;
+        uint64_t                                m_start_ns = 0;
+    };
+
+} // namespace ACL_ENGINE
\ No newline at end of file
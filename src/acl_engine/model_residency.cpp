@@ -0,0 +1,199 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#include <chrono>
+#include <algorithm>
+#include "acl_engine/log.h"
+#include "acl_engine/acl_engine.h"
+#include "acl_engine/model_residency.h"
+
+namespace ACL_ENGINE
+{
+
+    static uint64_t getSteadyTimeNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    ModelResidencyManager& ModelResidencyManager::Instance()
+    {
+        static ModelResidencyManager manager;
+        return manager;
+    }
+
+    void ModelResidencyManager::setConfig(const ModelResidencyConfig& config)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_config = config;
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "model residency device budget bytes:{}", config.device_budget_bytes);
+    }
+
+    bool ModelResidencyManager::enabled()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return 0 < m_config.device_budget_bytes;
+    }
+
+    ModelResidencyManager::DeviceResidency& ModelResidencyManager::getDevice(int device_id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto iter = m_devices.find(device_id);
+        if (m_devices.end() == iter)
+            iter = m_devices.emplace(device_id, std::unique_ptr<DeviceResidency>(new DeviceResidency())).first;
+        return *(iter->second);
+    }
+
+    size_t ModelResidencyManager::residentBytes(DeviceResidency& device)
+    {
+        size_t resident_bytes = 0;
+        for (auto& it : device.engines)
+        {
+            if (it.second.loading)
+                resident_bytes += std::max(it.second.loading_bytes, it.first->residentBytes());
+            else if (it.first->isModelResident())
+                resident_bytes += it.first->residentBytes();
+        }
+        return resident_bytes;
+    }
+
+    void ModelResidencyManager::evictForBytes(int device_id, DeviceResidency& device, size_t bytes, 
+        AscendCLEngine* requester)
+    {
+        size_t budget_bytes = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            budget_bytes = m_config.device_budget_bytes;
+        }
+        size_t resident_bytes = residentBytes(device);
+        while (resident_bytes + bytes > budget_bytes)
+        {
+            // least recently used engine which is resident and idle
+            AscendCLEngine* victim = nullptr;
+            uint64_t victim_used_ns = UINT64_MAX;
+            for (auto& it : device.engines)
+            {
+                if (it.first == requester || 0 < it.second.in_use || !it.first->isModelResident())
+                    continue;
+                if (it.second.last_used_ns < victim_used_ns)
+                {
+                    victim = it.first;
+                    victim_used_ns = it.second.last_used_ns;
+                }
+            }
+            if (nullptr == victim)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_WARN, "device {} model memory {} over budget {}, no idle model to evict", 
+                    device_id, resident_bytes + bytes, budget_bytes);
+                return;
+            }
+            size_t victim_bytes = victim->residentBytes();
+            if (0 != victim->offloadModel())
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "device {} evict model failed, stop evicting", device_id);
+                return;
+            }
+            resident_bytes -= std::min(resident_bytes, victim_bytes);
+        }
+    }
+
+    void ModelResidencyManager::beginLoad(int device_id, AscendCLEngine* engine, size_t bytes)
+    {
+        auto& device = getDevice(device_id);
+        std::lock_guard<std::mutex> lock(device.mutex);
+        auto& entry = device.engines[engine];
+        entry.last_used_ns = getSteadyTimeNs();
+        evictForBytes(device_id, device, bytes, engine);
+        entry.loading = true;
+        entry.loading_bytes = bytes;
+    }
+
+    void ModelResidencyManager::endLoad(int device_id, AscendCLEngine* engine, bool loaded)
+    {
+        auto& device = getDevice(device_id);
+        std::lock_guard<std::mutex> lock(device.mutex);
+        auto iter = device.engines.find(engine);
+        if (device.engines.end() == iter)
+            return;
+        if (loaded)
+        {
+            iter->second.loading = false;
+            iter->second.loading_bytes = 0;
+        }
+        else
+        {
+            device.engines.erase(iter);
+        }
+        device.cond.notify_all();
+    }
+
+    void ModelResidencyManager::unregisterEngine(int device_id, AscendCLEngine* engine)
+    {
+        auto& device = getDevice(device_id);
+        std::lock_guard<std::mutex> lock(device.mutex);
+        device.engines.erase(engine);
+    }
+
+    int ModelResidencyManager::acquire(int device_id, AscendCLEngine* engine)
+    {
+        auto& device = getDevice(device_id);
+        std::unique_lock<std::mutex> lock(device.mutex);
+        auto iter = device.engines.find(engine);
+        if (device.engines.end() == iter)
+            return engine->isModelResident() ? 0 : -1;
+        // engine in use is never evicted, and never unregistered since its owner is executing it
+        auto& entry = iter->second;
+        entry.in_use++;
+        entry.last_used_ns = getSteadyTimeNs();
+
+        // another caller of same engine may be reloading it, wait for it instead of loading twice
+        device.cond.wait(lock, [&]() { return !entry.loading; });
+        if (engine->isModelResident())
+            return 0;
+        evictForBytes(device_id, device, engine->residentBytes(), engine);
+        entry.loading = true;
+        entry.loading_bytes = engine->residentBytes();
+
+        // reload reads model and loads it to device, executes of other engines go on meanwhile
+        lock.unlock();
+        int ret = engine->reloadModel();
+        lock.lock();
+        entry.loading = false;
+        entry.loading_bytes = 0;
+        if (0 != ret)
+            entry.in_use--;
+        device.cond.notify_all();
+        return (0 == ret) ? 0 : -1;
+    }
+
+    void ModelResidencyManager::release(int device_id, AscendCLEngine* engine)
+    {
+        auto& device = getDevice(device_id);
+        std::lock_guard<std::mutex> lock(device.mutex);
+        auto iter = device.engines.find(engine);
+        if (device.engines.end() != iter && 0 < iter->second.in_use)
+            iter->second.in_use--;
+    }
+
+    ModelResidencyGuard::ModelResidencyGuard(int device_id, AscendCLEngine* engine)
+        : m_device_id(device_id), m_engine(engine)
+    {
+        if (!ModelResidencyManager::Instance().enabled())
+        {
+            m_resident = true;
+            return;
+        }
+        m_acquired = true;
+        m_resident = (0 == ModelResidencyManager::Instance().acquire(m_device_id, m_engine));
+    }
+
+    ModelResidencyGuard::~ModelResidencyGuard()
+    {
+        if (m_acquired && m_resident)
+            ModelResidencyManager::Instance().release(m_device_id, m_engine);
+    }
+
+} // namespace ACL_ENGINE
\ No newline at end of file
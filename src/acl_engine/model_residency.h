@@ -0,0 +1,110 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#pragma once
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include "acl_engine/non_copyable.h"
+
+namespace ACL_ENGINE
+{
+
+    class AscendCLEngine;
+
+    typedef struct ModelResidencyConfig
+    {
+        size_t                                  device_budget_bytes = 0;    // model memory budget per device, 0 means models never evicted
+    } ModelResidencyConfig;
+
+    typedef struct ModelResidencyStats
+    {
+        uint64_t                                evict_count = 0;
+        uint64_t                                evict_time_ns = 0;          // accumulated time of model unload
+        uint64_t                                reload_count = 0;
+        uint64_t                                reload_time_ns = 0;         // accumulated time of model reload
+        uint64_t                                max_reload_time_ns = 0;
+    } ModelResidencyStats;
+
+    /**
+     * per device budget of model memory, models over budget are offloaded from device in lru order,
+     * model bytes are kept on host (or file mapping) and model is reloaded on its next execute
+     */
+    class ModelResidencyManager : public NonCopyable
+    {
+    public:
+        static ModelResidencyManager& Instance();
+        void setConfig(const ModelResidencyConfig& config);
+        bool enabled();
+
+        /**
+         * @brief register engine before its model is loaded, idle engines are evicted first if model
+         *        bytes would exceed budget, so load never runs out of device memory held by idle models
+         * @param bytes, device memory the model needs, counted as resident while loading
+         */
+        void beginLoad(int device_id, AscendCLEngine* engine, size_t bytes);
+        // model load finished, engine is unregistered if load failed
+        void endLoad(int device_id, AscendCLEngine* engine, bool loaded);
+        // engine is never evicted after unregister, called before engine release its model
+        void unregisterEngine(int device_id, AscendCLEngine* engine);
+
+        /**
+         * @brief keep engine resident until release, reload its model if it has been evicted
+         * @param device_id, device engine loaded on
+         * @param engine, engine to execute
+         * @return 0 if engine is resident, else fail
+         */
+        int acquire(int device_id, AscendCLEngine* engine);
+        void release(int device_id, AscendCLEngine* engine);
+
+    private:
+        ModelResidencyManager() = default;
+        ~ModelResidencyManager() = default;
+
+        typedef struct ResidentEntry
+        {
+            int                                 in_use = 0;                 // executes in flight, engine in use is never evicted
+            uint64_t                            last_used_ns = 0;
+            bool                                loading = false;            // model loading outside device lock
+            size_t                              loading_bytes = 0;          // bytes of model being loaded
+        } ResidentEntry;
+
+        typedef struct DeviceResidency
+        {
+            // held during evict and reload bookkeeping, reload itself runs without it, bytes of loading
+            // engines are counted as resident so device never exceeds budget by race
+            std::mutex                          mutex;
+            std::condition_variable             cond;                       // notified when a reload finished
+            std::map<AscendCLEngine*, ResidentEntry> engines;
+        } DeviceResidency;
+
+        DeviceResidency& getDevice(int device_id);
+        size_t residentBytes(DeviceResidency& device);
+        void evictForBytes(int device_id, DeviceResidency& device, size_t bytes, AscendCLEngine* requester);
+
+    private:
+        std::mutex                                                  m_mutex;
+        ModelResidencyConfig                                        m_config;
+        std::map<int, std::unique_ptr<DeviceResidency>>             m_devices;
+    };
+
+    /** keep engine resident on device during guard lifetime */
+    class ModelResidencyGuard : public NonCopyable
+    {
+    public:
+        ModelResidencyGuard(int device_id, AscendCLEngine* engine);
+        ~ModelResidencyGuard();
+        bool resident() { return m_resident; }
+
+    private:
+        int                                     m_device_id;
+        AscendCLEngine*                         m_engine;
+        bool                                    m_acquired = false;
+        bool                                    m_resident = false;
+    };
+
+} // namespace ACL_ENGINE
\ No newline at end of file
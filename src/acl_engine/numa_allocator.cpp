@@ -0,0 +1,233 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <algorithm>
+#include "acl_engine/log.h"
+#include "acl_engine/numa_allocator.h"
+
+namespace ACL_ENGINE
+{
+
+    #define NUMA_PAGE_SIZE                     4096UL
+    #define NUMA_HUGE_2M_SIZE                  (2UL << 20)
+    #define NUMA_HUGE_1G_SIZE                  (1UL << 30)
+    // sizes are rounded to 4 classes per power of 2 so buffers can be reused
+    #define NUMA_CLASSES_PER_DOUBLE            4
+    // max bytes of free buffers kept over all nodes
+    #define NUMA_MAX_CACHED_BYTES              (1UL << 30)
+    // mbind policy, numaif.h is not required
+    #define NUMA_MPOL_PREFERRED                1
+    #define NUMA_MAX_NODES                     1024
+    #ifndef MAP_HUGE_SHIFT
+    #define MAP_HUGE_SHIFT                     26
+    #endif
+
+    NumaHostAllocator& NumaHostAllocator::Instance()
+    {
+        static NumaHostAllocator allocator;
+        return allocator;
+    }
+
+    NumaHostAllocator::~NumaHostAllocator()
+    {
+        for (auto& it : m_node_stats)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_INFO, "numa node {} host buffer alloc count:{}, cache hit:{}, bind fail:{}", 
+                it.first, it.second.alloc_count, it.second.cache_hit_count, it.second.bind_fail_count);
+        }
+        trim();
+    }
+
+    size_t NumaHostAllocator::roundSize(size_t size, bool huge_page)
+    {
+        size_t page_size = huge_page ? NUMA_HUGE_2M_SIZE : NUMA_PAGE_SIZE;
+        size_t base = page_size;
+        while (base * 2 < size)
+            base <<= 1;
+        size_t step = std::max(base / NUMA_CLASSES_PER_DOUBLE, page_size);
+        return (size + step - 1) / step * step;
+    }
+
+    void* NumaHostAllocator::mapBuffer(size_t size, bool huge_page, NumaPageKind& page_kind)
+    {
+        const int prot = PROT_READ | PROT_WRITE;
+        const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        void* ptr = MAP_FAILED;
+        if (huge_page)
+        {
+            // explicit huge pages need reserved hugetlbfs pages, fall back when not configured
+            if (0 == size % NUMA_HUGE_1G_SIZE)
+            {
+                ptr = mmap(nullptr, size, prot, flags | MAP_HUGETLB | (30 << MAP_HUGE_SHIFT), -1, 0);
+                page_kind = NUMA_PAGE_KIND_HUGE_1G;
+            }
+            if (MAP_FAILED == ptr)
+            {
+                ptr = mmap(nullptr, size, prot, flags | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);
+                page_kind = NUMA_PAGE_KIND_HUGE_2M;
+            }
+            if (MAP_FAILED == ptr)
+            {
+                ptr = mmap(nullptr, size, prot, flags, -1, 0);
+                page_kind = NUMA_PAGE_KIND_THP;
+                if (MAP_FAILED != ptr && 0 != madvise(ptr, size, MADV_HUGEPAGE))
+                    page_kind = NUMA_PAGE_KIND_NORMAL;
+            }
+        }
+        else
+        {
+            ptr = mmap(nullptr, size, prot, flags, -1, 0);
+            page_kind = NUMA_PAGE_KIND_NORMAL;
+        }
+        return (MAP_FAILED == ptr) ? nullptr : ptr;
+    }
+
+    bool NumaHostAllocator::bindNode(void* ptr, size_t size, int numa_node)
+    {
+        if (0 > numa_node || NUMA_MAX_NODES <= numa_node)
+            return false;
+        // preferred policy, pages still come from other nodes when the node is out of memory
+        unsigned long node_mask[NUMA_MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+        node_mask[numa_node / (8 * sizeof(unsigned long))] |= 1UL << (numa_node % (8 * sizeof(unsigned long)));
+        long ret = syscall(SYS_mbind, ptr, size, NUMA_MPOL_PREFERRED, node_mask, NUMA_MAX_NODES + 1, 0);
+        return 0 == ret;
+    }
+
+    void NumaHostAllocator::updatePageStats(NumaNodeStats& stats, const NumaBuffer& buffer, bool in_use)
+    {
+        size_t* page_bytes = nullptr;
+        if (NUMA_PAGE_KIND_HUGE_1G == buffer.page_kind)
+            page_bytes = &stats.huge_1g_bytes;
+        else if (NUMA_PAGE_KIND_HUGE_2M == buffer.page_kind)
+            page_bytes = &stats.huge_2m_bytes;
+        else if (NUMA_PAGE_KIND_THP == buffer.page_kind)
+            page_bytes = &stats.thp_bytes;
+        if (in_use)
+        {
+            stats.in_use_bytes += buffer.size;
+            if (nullptr != page_bytes)
+                *page_bytes += buffer.size;
+        }
+        else
+        {
+            stats.in_use_bytes -= buffer.size;
+            if (nullptr != page_bytes)
+                *page_bytes -= buffer.size;
+        }
+    }
+
+    void* NumaHostAllocator::malloc(size_t size, int numa_node, bool huge_page)
+    {
+        if (0 == size)
+            return nullptr;
+        size = roundSize(size, huge_page);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& stats = m_node_stats[numa_node];
+        stats.alloc_count++;
+
+        void* ptr = nullptr;
+        NumaBuffer buffer;
+        auto iter = m_free_buffers.find(std::make_tuple(numa_node, huge_page, size));
+        if (m_free_buffers.end() != iter && !iter->second.empty())
+        {
+            ptr = iter->second.back().first;
+            buffer = iter->second.back().second;
+            iter->second.pop_back();
+            m_cached_bytes -= buffer.size;
+            stats.cached_bytes -= buffer.size;
+            stats.cache_hit_count++;
+        }
+        else
+        {
+            buffer.size = size;
+            buffer.numa_node = numa_node;
+            buffer.huge_page = huge_page;
+            ptr = mapBuffer(size, huge_page, buffer.page_kind);
+            if (nullptr == ptr)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "map {} bytes host buffer on numa node {} fail", size, numa_node);
+                return nullptr;
+            }
+            // bind before first touch, pages are placed on node when faulted in
+            if (0 <= numa_node && !bindNode(ptr, size, numa_node))
+            {
+                ACL_LOG(ACL_LOG_LEVEL_WARN, "bind {} bytes host buffer to numa node {} fail", size, numa_node);
+                stats.bind_fail_count++;
+            }
+        }
+        m_used_buffers[ptr] = buffer;
+        updatePageStats(stats, buffer, true);
+        return ptr;
+    }
+
+    void NumaHostAllocator::free(void* ptr)
+    {
+        if (nullptr == ptr)
+            return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto iter = m_used_buffers.find(ptr);
+        if (m_used_buffers.end() == iter)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "free ptr 0x{:x} not allocated by numa host allocator", (size_t)ptr);
+            return;
+        }
+        NumaBuffer buffer = iter->second;
+        m_used_buffers.erase(iter);
+        auto& stats = m_node_stats[buffer.numa_node];
+        updatePageStats(stats, buffer, false);
+        if (m_cached_bytes + buffer.size <= NUMA_MAX_CACHED_BYTES)
+        {
+            m_free_buffers[std::make_tuple(buffer.numa_node, buffer.huge_page, buffer.size)].emplace_back(ptr, buffer);
+            m_cached_bytes += buffer.size;
+            stats.cached_bytes += buffer.size;
+            return;
+        }
+        munmap(ptr, buffer.size);
+    }
+
+    bool NumaHostAllocator::owns(void* ptr)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_used_buffers.end() != m_used_buffers.find(ptr);
+    }
+
+    int NumaHostAllocator::getNodeStats(int numa_node, NumaNodeStats& stats)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto iter = m_node_stats.find(numa_node);
+        if (m_node_stats.end() == iter)
+        {
+            stats = NumaNodeStats();
+            return -1;
+        }
+        stats = iter->second;
+        return 0;
+    }
+
+    void NumaHostAllocator::getAllNodeStats(std::map<int, NumaNodeStats>& stats)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stats = m_node_stats;
+    }
+
+    void NumaHostAllocator::trim()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& it : m_free_buffers)
+        {
+            for (auto& buffer : it.second)
+                munmap(buffer.first, buffer.second.size);
+        }
+        m_free_buffers.clear();
+        m_cached_bytes = 0;
+        for (auto& it : m_node_stats)
+            it.second.cached_bytes = 0;
+    }
+
+} // namespace ACL_ENGINE
\ No newline at end of file
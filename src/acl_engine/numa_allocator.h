@@ -0,0 +1,88 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#pragma once
+#include <map>
+#include <tuple>
+#include <vector>
+#include <mutex>
+#include "acl_engine/non_copyable.h"
+
+namespace ACL_ENGINE
+{
+
+    typedef struct NumaNodeStats
+    {
+        uint64_t                                alloc_count = 0;
+        uint64_t                                cache_hit_count = 0;            // alloc served by cached buffer
+        uint64_t                                bind_fail_count = 0;            // buffer not bound to node, first touch decides
+        size_t                                  in_use_bytes = 0;
+        size_t                                  cached_bytes = 0;
+        size_t                                  huge_1g_bytes = 0;              // in use bytes backed by 1GB huge pages
+        size_t                                  huge_2m_bytes = 0;              // in use bytes backed by 2MB huge pages
+        size_t                                  thp_bytes = 0;                  // in use bytes advised to transparent huge pages
+    } NumaNodeStats;
+
+    /**
+     * host buffers mapped on a given numa node, optionally backed by huge pages,
+     * used for staging tensors of devices attached to that node
+     */
+    class NumaHostAllocator : public NonCopyable
+    {
+    public:
+        static NumaHostAllocator& Instance();
+
+        /**
+         * @brief malloc host buffer on numa node
+         * @param size, bytes to malloc
+         * @param numa_node, node buffer pages bound to, -1 means no bind
+         * @param huge_page, try 1GB/2MB huge pages, then transparent huge pages
+         * @return host ptr aligned to page size, nullptr if fail
+         */
+        void* malloc(size_t size, int numa_node, bool huge_page);
+        void free(void* ptr);
+        bool owns(void* ptr);
+        int getNodeStats(int numa_node, NumaNodeStats& stats);
+        void getAllNodeStats(std::map<int, NumaNodeStats>& stats);
+        // unmap all cached buffers
+        void trim();
+
+    private:
+        NumaHostAllocator() = default;
+        ~NumaHostAllocator();
+
+        typedef enum NumaPageKind
+        {
+            NUMA_PAGE_KIND_NORMAL               = 0,
+            NUMA_PAGE_KIND_THP                  = 1,
+            NUMA_PAGE_KIND_HUGE_2M              = 2,
+            NUMA_PAGE_KIND_HUGE_1G              = 3,
+        } NumaPageKind;
+
+        typedef struct NumaBuffer
+        {
+            size_t                              size;
+            int                                 numa_node;
+            bool                                huge_page;
+            NumaPageKind                        page_kind;
+        } NumaBuffer;
+
+        typedef std::tuple<int, bool, size_t> NumaBufferKey;
+
+        size_t roundSize(size_t size, bool huge_page);
+        void* mapBuffer(size_t size, bool huge_page, NumaPageKind& page_kind);
+        bool bindNode(void* ptr, size_t size, int numa_node);
+        void updatePageStats(NumaNodeStats& stats, const NumaBuffer& buffer, bool in_use);
+
+    private:
+        std::mutex                                                  m_mutex;
+        std::map<void*, NumaBuffer>                                 m_used_buffers;
+        std::map<NumaBufferKey, std::vector<std::pair<void*, NumaBuffer>>> m_free_buffers;
+        size_t                                                      m_cached_bytes = 0;
+        std::map<int, NumaNodeStats>                                m_node_stats;
+    };
+
+} // namespace ACL_ENGINE
\ No newline at end of file
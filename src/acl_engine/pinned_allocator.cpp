@@ -0,0 +1,155 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#include <algorithm>
+#include "acl/acl.h"
+#include "acl_engine/log.h"
+#include "acl_engine/pinned_allocator.h"
+
+namespace ACL_ENGINE
+{
+
+    // min size of pinned buffer, page size
+    #define PINNED_POOL_MIN_SIZE               4096UL
+    // sizes are rounded to 4 classes per power of 2
+    #define PINNED_POOL_CLASSES_PER_DOUBLE     4
+
+    PinnedHostPool& PinnedHostPool::Instance()
+    {
+        static PinnedHostPool pool;
+        return pool;
+    }
+
+    void PinnedHostPool::setMaxCachedBytes(size_t max_cached_bytes)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_max_cached_bytes = max_cached_bytes;
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "pinned host pool max cached bytes:{}", m_max_cached_bytes);
+    }
+
+    bool PinnedHostPool::enabled()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return 0 < m_max_cached_bytes;
+    }
+
+    size_t PinnedHostPool::roundSize(size_t size)
+    {
+        if (size <= PINNED_POOL_MIN_SIZE)
+            return PINNED_POOL_MIN_SIZE;
+        size_t base = PINNED_POOL_MIN_SIZE;
+        while (base * 2 < size)
+            base <<= 1;
+        size_t step = base / PINNED_POOL_CLASSES_PER_DOUBLE;
+        return (size + step - 1) / step * step;
+    }
+
+    void* PinnedHostPool::malloc(size_t size)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (0 == m_max_cached_bytes || 0 == size)
+            return nullptr;
+        size = roundSize(size);
+        m_stats.alloc_count++;
+
+        void* ptr = nullptr;
+        auto iter = m_free_buffers.find(size);
+        if (m_free_buffers.end() != iter && !iter->second.empty())
+        {
+            ptr = iter->second.back();
+            iter->second.pop_back();
+            m_stats.cached_bytes -= size;
+            m_stats.cache_hit_count++;
+        }
+        else
+        {
+            auto ret = aclrtMallocHost(&ptr, size);
+            if (ACL_ERROR_NONE != ret && !m_free_buffers.empty())
+            {
+                // cached buffers of other sizes may block the malloc, release them and retry
+                releaseCached();
+                ret = aclrtMallocHost(&ptr, size);
+            }
+            if (ACL_ERROR_NONE != ret || nullptr == ptr)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_WARN, "malloc pinned host buffer of {} bytes fail, ret:{}", size, int(ret));
+                m_stats.fail_count++;
+                return nullptr;
+            }
+            m_stats.host_malloc_count++;
+        }
+        m_used_buffers[ptr] = size;
+        m_stats.in_use_bytes += size;
+        m_stats.peak_in_use_bytes = std::max(m_stats.peak_in_use_bytes, m_stats.in_use_bytes);
+        return ptr;
+    }
+
+    void PinnedHostPool::free(void* ptr)
+    {
+        if (nullptr == ptr)
+            return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto iter = m_used_buffers.find(ptr);
+        if (m_used_buffers.end() == iter)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "free ptr 0x{:x} not allocated by pinned host pool", (size_t)ptr);
+            return;
+        }
+        size_t size = iter->second;
+        m_used_buffers.erase(iter);
+        m_stats.in_use_bytes -= size;
+        if (m_stats.cached_bytes + size <= m_max_cached_bytes)
+        {
+            m_free_buffers[size].push_back(ptr);
+            m_stats.cached_bytes += size;
+            return;
+        }
+        (void)aclrtFreeHost(ptr);
+    }
+
+    bool PinnedHostPool::owns(void* ptr)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_used_buffers.end() != m_used_buffers.find(ptr);
+    }
+
+    std::shared_ptr<void> PinnedHostPool::allocate(size_t size)
+    {
+        void* ptr = malloc(size);
+        if (nullptr == ptr)
+            return nullptr;
+        return std::shared_ptr<void>(ptr, [](void* buffer) { PinnedHostPool::Instance().free(buffer); });
+    }
+
+    void PinnedHostPool::getStats(PinnedHostPoolStats& stats)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stats = m_stats;
+    }
+
+    void PinnedHostPool::releaseCached()
+    {
+        for (auto& it : m_free_buffers)
+        {
+            for (auto ptr : it.second)
+                (void)aclrtFreeHost(ptr);
+        }
+        m_free_buffers.clear();
+        m_stats.cached_bytes = 0;
+    }
+
+    void PinnedHostPool::shutdown()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "pinned host pool alloc count:{}, cache hit:{}, host malloc:{}, fail:{}, "
+            "peak in use bytes:{}", m_stats.alloc_count, m_stats.cache_hit_count, m_stats.host_malloc_count, 
+            m_stats.fail_count, m_stats.peak_in_use_bytes);
+        releaseCached();
+        // buffers still in use are freed directly when returned
+        m_max_cached_bytes = 0;
+    }
+
+} // namespace ACL_ENGINE
\ No newline at end of file
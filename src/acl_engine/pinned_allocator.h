@@ -0,0 +1,67 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#pragma once
+#include <map>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include "acl_engine/non_copyable.h"
+
+namespace ACL_ENGINE
+{
+
+    typedef struct PinnedHostPoolStats
+    {
+        uint64_t                                alloc_count = 0;
+        uint64_t                                cache_hit_count = 0;            // alloc served by cached buffer
+        uint64_t                                host_malloc_count = 0;          // aclrtMallocHost called
+        uint64_t                                fail_count = 0;                 // alloc failed, caller fall back to pageable memory
+        size_t                                  in_use_bytes = 0;
+        size_t                                  peak_in_use_bytes = 0;
+        size_t                                  cached_bytes = 0;               // bytes of free buffers kept in pool
+    } PinnedHostPoolStats;
+
+    /**
+     * backend global pool of page locked host buffers malloced with aclrtMallocHost, used for input
+     * staging and output copy back so h2d/d2h copies run at full dma bandwidth
+     */
+    class PinnedHostPool : public NonCopyable
+    {
+    public:
+        static PinnedHostPool& Instance();
+        // max bytes of free buffers kept in pool, 0 means pool is disabled
+        void setMaxCachedBytes(size_t max_cached_bytes);
+        bool enabled();
+
+        /**
+         * @brief malloc pinned host buffer, size is rounded to pool size class
+         * @return host ptr, nullptr if pool disabled or malloc fail
+         */
+        void* malloc(size_t size);
+        void free(void* ptr);
+        bool owns(void* ptr);
+        // pinned buffer returned to pool when last reference released
+        std::shared_ptr<void> allocate(size_t size);
+        void getStats(PinnedHostPoolStats& stats);
+        // release all free buffers, buffers in use are released when freed
+        void shutdown();
+
+    private:
+        PinnedHostPool() = default;
+        ~PinnedHostPool() = default;
+        size_t roundSize(size_t size);
+        void releaseCached();
+
+    private:
+        std::mutex                                                  m_mutex;
+        size_t                                                      m_max_cached_bytes = 0;
+        std::map<size_t, std::vector<void*>>                        m_free_buffers;
+        std::map<void*, size_t>                                     m_used_buffers;
+        PinnedHostPoolStats                                         m_stats;
+    };
+
+} // namespace ACL_ENGINE
\ No newline at end of file
@@ -0,0 +1,452 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#include <string.h>
+#include <algorithm>
+#include <iterator>
+#include "acl_engine/log.h"
+#include "acl_engine/shard_engine.h"
+
+namespace ACL_ENGINE
+{
+
+    ShardEngine::ShardEngine(const std::vector<EngineConfig>& configs, const std::vector<std::string>& model_files)
+    {
+        if (0 == configs.size())
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine configs is empty");
+            return;
+        }
+
+        // create one engine per device, each engine has its own context and stream
+        for (auto& config : configs)
+        {
+            std::shared_ptr<AscendCLEngine> engine(new AscendCLEngine(config, model_files));
+            if (nullptr == engine || false == engine->status())
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine create engine on device {} fail", config.device_id);
+                m_engines.clear();
+                m_device_ids.clear();
+                return;
+            }
+            m_engines.push_back(engine);
+            m_device_ids.push_back(config.device_id);
+        }
+        m_batch_gears = m_engines[0]->getBatchGears();
+        m_slice_tensors.resize(m_engines.size());
+        m_thread_pool.reset(new ThreadPool(m_engines.size()));
+        m_status = true;
+    }
+
+    ShardEngine::~ShardEngine()
+    {
+        // wait running slices before engines destroyed
+        m_thread_pool.reset();
+        m_slice_tensors.clear();
+        m_output_tensors_map.clear();
+        m_engines.clear();
+    }
+
+    int ShardEngine::splitBatch(int64_t batch_size, std::vector<std::pair<int64_t, int64_t>>& slices)
+    {
+        slices.clear();
+        if (0 >= batch_size)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine input batch size {} invalid", batch_size);
+            return -1;
+        }
+        int64_t engine_num = m_engines.size();
+        if (m_batch_gears.empty())
+        {
+            // split evenly and remainder goes to last slice, small batch may use less engines than devices
+            engine_num = std::min(engine_num, batch_size);
+            int64_t slice_size = batch_size / engine_num;
+            for (int64_t index = 0; index < engine_num; index++)
+            {
+                int64_t offset = index * slice_size;
+                slices.emplace_back(offset, (engine_num - 1 == index) ? batch_size - offset : slice_size);
+            }
+            return 0;
+        }
+
+        // fill engines with compiled gears, balanced fill first takes the smallest gear covering even share of
+        // remaining rows, greedy fill takes the largest gear not larger than remaining rows
+        for (bool balanced : {true, false})
+        {
+            slices.clear();
+            int64_t offset = 0;
+            for (int64_t index = 0; index < engine_num && offset < batch_size; index++)
+            {
+                int64_t remaining = batch_size - offset;
+                int64_t share = (remaining + engine_num - index - 1) / (engine_num - index);
+                auto gear = balanced ? m_batch_gears.lower_bound(share) : m_batch_gears.end();
+                if (m_batch_gears.end() == gear || int64_t(*gear) > remaining)
+                {
+                    gear = m_batch_gears.upper_bound(remaining);
+                    if (m_batch_gears.begin() == gear)
+                        break;
+                    gear = std::prev(gear);
+                }
+                slices.emplace_back(offset, int64_t(*gear));
+                offset += *gear;
+            }
+            if (offset == batch_size)
+                return 0;
+        }
+        ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine input batch size {} cannot be split to batch gears of {} engines", 
+            batch_size, engine_num);
+        slices.clear();
+        return -1;
+    }
+
+    int ShardEngine::setEngineInputTensors(std::map<std::string, EngineTensor*>& input_tensors_map)
+    {
+        if (!m_status)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine has not been inited");
+            return -1;
+        }
+        if (0 == input_tensors_map.size())
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine input tensors is empty");
+            return -1;
+        }
+
+        // all inputs should have same batch size along dim 0
+        int64_t batch_size = -1;
+        for (auto& it : input_tensors_map)
+        {
+            auto tensor_shape = it.second->shape();
+            if (0 == tensor_shape.size())
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine input tensor {} has no batch dim", it.first);
+                return -1;
+            }
+            if (-1 != batch_size && batch_size != tensor_shape[0])
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine input tensor {} batch size {} not equal to {}", 
+                    it.first, tensor_shape[0], batch_size);
+                return -1;
+            }
+            // slices reference host data of input, device inputs are not sliced
+            if (0 != it.second->devicePtr() || nullptr == it.second->host<void>())
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine input tensor {} is not a host tensor", it.first);
+                return -1;
+            }
+            batch_size = tensor_shape[0];
+        }
+        if (0 != splitBatch(batch_size, m_slices))
+            return -1;
+
+        // create slice tensors reference caller's input data
+        for (size_t index = 0; index < m_slice_tensors.size(); index++)
+            m_slice_tensors[index].clear();
+        for (size_t index = 0; index < m_slices.size(); index++)
+        {
+            int64_t slice_offset = m_slices[index].first;
+            int64_t slice_size = m_slices[index].second;
+            for (auto& it : input_tensors_map)
+            {
+                auto input_tensor = it.second;
+                auto tensor_shape = input_tensor->shape();
+                size_t batch_bytes = input_tensor->size() / tensor_shape[0];
+                tensor_shape[0] = slice_size;
+                uint8_t* slice_data = input_tensor->host<uint8_t>() + slice_offset * batch_bytes;
+                std::shared_ptr<EngineTensor> slice_tensor(EngineTensor::create(tensor_shape, 
+                    input_tensor->getTensorDataType(), input_tensor->getTensorFormatType(), slice_data));
+                if (nullptr == slice_tensor.get() || nullptr == slice_tensor->host<void>())
+                {
+                    ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine create slice tensor {} for device {} fail", 
+                        it.first, m_device_ids[index]);
+                    return -1;
+                }
+                m_slice_tensors[index][it.first] = slice_tensor;
+            }
+        }
+        return 0;
+    }
+
+    int ShardEngine::runEngine()
+    {
+        if (!m_status)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine has not been inited");
+            return -1;
+        }
+        if (0 == m_slices.size())
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine input tensors has not been set");
+            return -1;
+        }
+
+        // run slices concurrently, one thread per device
+        std::vector<std::future<int>> results;
+        for (size_t index = 0; index < m_slices.size(); index++)
+        {
+            auto engine = m_engines[index];
+            auto& slice_tensors = m_slice_tensors[index];
+            int device_id = m_device_ids[index];
+            results.emplace_back(m_thread_pool->enqueue([engine, &slice_tensors, device_id]() {
+                std::map<std::string, EngineTensor*> input_tensors;
+                for (auto& it : slice_tensors)
+                    input_tensors[it.first] = it.second.get();
+                if (0 != engine->setEngineInputTensors(input_tensors) || 0 != engine->runEngine())
+                {
+                    ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine run slice on device {} fail", device_id);
+                    return -1;
+                }
+                return 0;
+            }));
+        }
+
+        // wait all slices finish even some of them fail
+        int ret = 0;
+        for (auto& result : results)
+        {
+            if (!result.valid() || 0 != result.get())
+                ret = -1;
+        }
+        if (0 != ret)
+            return -1;
+
+        return gatherOutputs();
+    }
+
+    int ShardEngine::gatherOutputs()
+    {
+        // collect output tensors of every slice
+        std::vector<std::map<std::string, EngineTensor*>> slice_outputs(m_slices.size());
+        for (size_t index = 0; index < m_slices.size(); index++)
+        {
+            if (0 != m_engines[index]->getEngineOutputTensors(slice_outputs[index]))
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine get outputs from device {} fail", m_device_ids[index]);
+                return -1;
+            }
+        }
+
+        // concat output slices along dim 0 in device order
+        for (auto& it : slice_outputs[0])
+        {
+            std::string output_name = it.first;
+            auto first_tensor = it.second;
+            auto output_shape = first_tensor->shape();
+            if (0 == output_shape.size())
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine output tensor {} has no batch dim", output_name);
+                return -1;
+            }
+            int64_t batch_size = 0;
+            for (size_t index = 0; index < slice_outputs.size(); index++)
+            {
+                auto iter = slice_outputs[index].find(output_name);
+                if (slice_outputs[index].end() == iter)
+                {
+                    ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine cannot find output {} from device {}", 
+                        output_name, m_device_ids[index]);
+                    return -1;
+                }
+                auto slice_shape = iter->second->shape();
+                if (slice_shape.size() != output_shape.size() || 
+                    !std::equal(slice_shape.begin() + 1, slice_shape.end(), output_shape.begin() + 1))
+                {
+                    ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine output {} from device {} shape mismatch", 
+                        output_name, m_device_ids[index]);
+                    return -1;
+                }
+                batch_size += slice_shape[0];
+            }
+            output_shape[0] = batch_size;
+
+            // reuse output tensor of last run if shape not changed
+            auto& output_tensor = m_output_tensors_map[output_name];
+            if (nullptr == output_tensor || output_tensor->shape() != output_shape || 
+                output_tensor->getTensorDataType() != first_tensor->getTensorDataType())
+            {
+                output_tensor.reset(EngineTensor::create(output_shape, first_tensor->getTensorDataType(), 
+                    first_tensor->getTensorFormatType(), nullptr));
+                if (nullptr == output_tensor.get() || nullptr == output_tensor->host<void>())
+                {
+                    ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine create output tensor {} fail", output_name);
+                    output_tensor.reset();
+                    return -1;
+                }
+            }
+
+            uint8_t* dst_data = output_tensor->host<uint8_t>();
+            for (size_t index = 0; index < slice_outputs.size(); index++)
+            {
+                auto slice_tensor = slice_outputs[index][output_name];
+                memcpy(dst_data, slice_tensor->host<void>(), slice_tensor->size());
+                dst_data += slice_tensor->size();
+            }
+        }
+        return 0;
+    }
+
+    int ShardEngine::getEngineOutputTensors(std::map<std::string, EngineTensor*>& output_tensors_map)
+    {
+        if (!m_status)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine has not been inited");
+            return -1;
+        }
+
+        if (output_tensors_map.size() != m_output_tensors_map.size())
+            output_tensors_map.clear();
+        for (auto& it : m_output_tensors_map)
+        {
+            output_tensors_map[it.first] = it.second.get();
+        }
+        return 0;
+    }
+
+    int ShardEngine::getInputTensorInfos(std::vector<EngineTensorInfo>& input_tensor_infos)
+    {
+        if (!m_status)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine has not been inited");
+            return -1;
+        }
+        return m_engines[0]->getInputTensorInfos(input_tensor_infos);
+    }
+
+    int ShardEngine::getOutputTensorInfos(std::vector<EngineTensorInfo>& output_tensor_infos)
+    {
+        if (!m_status)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine has not been inited");
+            return -1;
+        }
+        return m_engines[0]->getOutputTensorInfos(output_tensor_infos);
+    }
+
+    uint64_t ShardEngine::getLastQueueTimeNs()
+    {
+        // slices run concurrently, batch waits for the slowest one
+        uint64_t queue_time_ns = 0;
+        for (size_t index = 0; index < m_slices.size() && index < m_engines.size(); index++)
+            queue_time_ns = std::max(queue_time_ns, m_engines[index]->getLastQueueTimeNs());
+        return queue_time_ns;
+    }
+
+    uint64_t ShardEngine::getExecuteTimeoutCount()
+    {
+        uint64_t timeout_count = 0;
+        for (auto& engine : m_engines)
+            timeout_count += engine->getExecuteTimeoutCount();
+        return timeout_count;
+    }
+
+    bool ShardEngine::isStreamBroken()
+    {
+        for (auto& engine : m_engines)
+        {
+            if (engine->isStreamBroken())
+                return true;
+        }
+        return false;
+    }
+
+    uint64_t ShardEngine::getCaptureHitCount()
+    {
+        uint64_t hit_count = 0;
+        for (auto& engine : m_engines)
+            hit_count += engine->getCaptureHitCount();
+        return hit_count;
+    }
+
+    uint64_t ShardEngine::getCaptureMissCount()
+    {
+        uint64_t miss_count = 0;
+        for (auto& engine : m_engines)
+            miss_count += engine->getCaptureMissCount();
+        return miss_count;
+    }
+
+    SyncWaitStats ShardEngine::getSyncWaitStats()
+    {
+        SyncWaitStats sync_stats;
+        for (auto& engine : m_engines)
+        {
+            const auto& engine_stats = engine->getSyncWaitStats();
+            sync_stats.wait_count += engine_stats.wait_count;
+            sync_stats.wait_time_ns += engine_stats.wait_time_ns;
+            sync_stats.max_wait_time_ns = std::max(sync_stats.max_wait_time_ns, engine_stats.max_wait_time_ns);
+            sync_stats.wakeup_latency_ns += engine_stats.wakeup_latency_ns;
+            sync_stats.poll_count += engine_stats.poll_count;
+        }
+        return sync_stats;
+    }
+
+    int ShardEngine::getMemoryStats(std::map<int, EngineMemoryStats>& memory_stats)
+    {
+        if (!m_status)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "shard engine has not been inited");
+            return -1;
+        }
+        for (size_t index = 0; index < m_engines.size(); index++)
+            memory_stats[m_device_ids[index]] = m_engines[index]->getMemoryStats();
+
+        // gathered outputs are host tensors of shard engine itself
+        size_t output_bytes = 0;
+        for (auto& it : m_output_tensors_map)
+        {
+            if (nullptr != it.second)
+                output_bytes += it.second->capacity();
+        }
+        auto& first_stats = memory_stats[m_device_ids[0]];
+        first_stats.host_bytes += output_bytes;
+        first_stats.peak_host_bytes += output_bytes;
+        return 0;
+    }
+
+    ModelResidencyStats ShardEngine::getResidencyStats()
+    {
+        ModelResidencyStats residency_stats;
+        for (auto& engine : m_engines)
+        {
+            const auto& engine_stats = engine->getResidencyStats();
+            residency_stats.evict_count += engine_stats.evict_count;
+            residency_stats.evict_time_ns += engine_stats.evict_time_ns;
+            residency_stats.reload_count += engine_stats.reload_count;
+            residency_stats.reload_time_ns += engine_stats.reload_time_ns;
+            residency_stats.max_reload_time_ns = std::max(residency_stats.max_reload_time_ns, 
+                engine_stats.max_reload_time_ns);
+        }
+        return residency_stats;
+    }
+
+    ModelLoadStats ShardEngine::getLoadStats()
+    {
+        ModelLoadStats load_stats;
+        for (auto& engine : m_engines)
+        {
+            const auto& engine_stats = engine->getLoadStats();
+            load_stats.load_count += engine_stats.load_count;
+            load_stats.file_bytes += engine_stats.file_bytes;
+            load_stats.io_queue_time_ns += engine_stats.io_queue_time_ns;
+            load_stats.read_time_ns += engine_stats.read_time_ns;
+            load_stats.device_queue_time_ns += engine_stats.device_queue_time_ns;
+            load_stats.load_time_ns += engine_stats.load_time_ns;
+        }
+        return load_stats;
+    }
+
+    int ShardEngine::getDeviceMemoryInfo(std::map<int, DeviceMemoryInfo>& infos)
+    {
+        int ret = 0;
+        for (auto& engine : m_engines)
+        {
+            if (0 != engine->getDeviceMemoryInfo(infos))
+                ret = -1;
+        }
+        return ret;
+    }
+
+} // namespace ACL_ENGINE
\ No newline at end of file
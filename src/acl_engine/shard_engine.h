@@ -0,0 +1,70 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include "acl_engine/non_copyable.h"
+#include "acl_engine/engine_type.h"
+#include "acl_engine/engine_tensor.h"
+#include "acl_engine/thread_pool.h"
+#include "acl_engine/acl_engine.h"
+
+namespace ACL_ENGINE
+{
+
+    /** 
+     * data parallel engine, owns one AscendCLEngine per device, split input batch along dim 0
+     * and run slices concurrently, output slices are gathered back in device order
+     */
+    class ShardEngine : NonCopyable
+    {
+    public:
+        // one engine config per device, configs differ in device id and sync cpu core
+        ShardEngine(const std::vector<EngineConfig>& configs, const std::vector<std::string>& model_files);
+        ~ShardEngine();
+
+    public:
+        bool status() { return m_status; }
+        int setEngineInputTensors(std::map<std::string, EngineTensor*>& input_tensors_map);
+        int getEngineOutputTensors(std::map<std::string, EngineTensor*>& output_tensors_map);
+        int runEngine();
+        int getInputTensorInfos(std::vector<EngineTensorInfo>& input_tensor_infos);
+        int getOutputTensorInfos(std::vector<EngineTensorInfo>& output_tensor_infos);
+        uint64_t getLastQueueTimeNs();
+        uint64_t getExecuteTimeoutCount();
+        bool isStreamBroken();
+        uint64_t getCaptureHitCount();
+        uint64_t getCaptureMissCount();
+        SyncWaitStats getSyncWaitStats();
+        // memory stats of each device, gathered outputs are counted to first device
+        int getMemoryStats(std::map<int, EngineMemoryStats>& memory_stats);
+        ModelResidencyStats getResidencyStats();
+        ModelLoadStats getLoadStats();
+        int getDeviceMemoryInfo(std::map<int, DeviceMemoryInfo>& infos);
+
+    private:
+        int splitBatch(int64_t batch_size, std::vector<std::pair<int64_t, int64_t>>& slices);
+        int gatherOutputs();
+
+    private:
+        bool                                                               m_status = false;
+        std::vector<int>                                                   m_device_ids;
+        std::vector<std::shared_ptr<AscendCLEngine>>                       m_engines;
+        // slices of dynamic batch model should be compiled gears
+        std::set<uint64_t>                                                 m_batch_gears;
+        std::unique_ptr<ThreadPool>                                        m_thread_pool;
+        // input slices of current batch, pair of batch offset and batch size per engine
+        std::vector<std::pair<int64_t, int64_t>>                           m_slices;
+        // slice tensors reference data of caller's input tensors, no copy
+        std::vector<std::map<std::string, std::shared_ptr<EngineTensor>>>  m_slice_tensors;
+        std::map<std::string, std::shared_ptr<EngineTensor>>               m_output_tensors_map;
+    };
+
+} // namespace ACL_ENGINE
\ No newline at end of file
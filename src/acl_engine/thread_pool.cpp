@@ -0,0 +1,50 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#include "acl_engine/thread_pool.h"
+
+namespace ACL_ENGINE
+{
+
+    ThreadPool::ThreadPool(size_t thread_num)
+    {
+        for (size_t index = 0; index < thread_num; index++)
+            m_workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        for (auto& worker : m_workers)
+        {
+            if (worker.joinable())
+                worker.join();
+        }
+    }
+
+    void ThreadPool::workerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cond.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+                // finish pending tasks before exit
+                if (m_stop && m_tasks.empty())
+                    return;
+                task = std::move(m_tasks.front());
+                m_tasks.pop();
+            }
+            task();
+        }
+    }
+
+} // namespace ACL_ENGINE
\ No newline at end of file
@@ -0,0 +1,61 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#pragma once
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <future>
+#include <functional>
+#include <condition_variable>
+#include "acl_engine/non_copyable.h"
+
+namespace ACL_ENGINE
+{
+
+    /** fixed size thread pool, tasks run in submit order */
+    class ThreadPool : public NonCopyable
+    {
+    public:
+        explicit ThreadPool(size_t thread_num);
+        ~ThreadPool();
+
+        size_t threadNum() { return m_workers.size(); }
+
+        /**
+         * @brief submit a task to thread pool
+         * @param func, task to run
+         * @return future of task result, invalid future if pool is stopped
+         */
+        template <typename F>
+        auto enqueue(F&& func) -> std::future<decltype(func())>
+        {
+            using ResultType = decltype(func());
+            auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<F>(func));
+            std::future<ResultType> result = task->get_future();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_stop)
+                    return std::future<ResultType>();
+                m_tasks.emplace([task]() { (*task)(); });
+            }
+            m_cond.notify_one();
+            return result;
+        }
+
+    private:
+        void workerLoop();
+
+    private:
+        std::vector<std::thread>                                    m_workers;
+        std::queue<std::function<void()>>                           m_tasks;
+        std::mutex                                                  m_mutex;
+        std::condition_variable                                     m_cond;
+        bool                                                        m_stop = false;
+    };
+
+} // namespace ACL_ENGINE
\ No newline at end of file
@@ -0,0 +1,92 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#include "acl_engine/log.h"
+#include "acl_engine/device_allocator.h"
+#include "acl_engine/workspace_manager.h"
+
+namespace ACL_ENGINE
+{
+
+    WorkspaceManager& WorkspaceManager::Instance()
+    {
+        static WorkspaceManager manager;
+        return manager;
+    }
+
+    std::shared_ptr<SharedWorkspace> WorkspaceManager::acquire(int device_id, const std::string& group, size_t size)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto key = std::make_pair(device_id, group);
+        auto& stats = m_group_stats[key];
+        auto workspace = m_workspaces[key].lock();
+        if (nullptr != workspace && workspace->size >= size)
+        {
+            stats.requested_bytes += size;
+            stats.member_count++;
+            ACL_LOG(ACL_LOG_LEVEL_INFO, "device {} workspace group {} shared by {} models, workspace bytes:{}, "
+                "requested bytes:{}", device_id, group, stats.member_count, stats.workspace_bytes, stats.requested_bytes);
+            return workspace;
+        }
+
+        // loaded models keep the smaller workspace, load largest model of group first to share one workspace
+        if (nullptr != workspace)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_WARN, "device {} workspace group {} size {} smaller than {}, create new workspace", 
+                device_id, group, workspace->size, size);
+        }
+        void* ptr = DeviceAllocatorManager::Instance().malloc(device_id, size, nullptr);
+        if (nullptr == ptr)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "malloc {} bytes workspace of group {} on device {} fail", size, group, device_id);
+            return nullptr;
+        }
+        workspace.reset(new SharedWorkspace(), [this](SharedWorkspace* workspace) { release(workspace); });
+        workspace->device_id = device_id;
+        workspace->group = group;
+        workspace->ptr = ptr;
+        workspace->size = size;
+        m_workspaces[key] = workspace;
+        stats.workspace_bytes += size;
+        stats.requested_bytes += size;
+        stats.member_count++;
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "device {} workspace group {} create workspace of {} bytes", device_id, group, size);
+        return workspace;
+    }
+
+    void WorkspaceManager::release(SharedWorkspace* workspace)
+    {
+        DeviceAllocatorManager::Instance().free(workspace->device_id, workspace->ptr);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto& stats = m_group_stats[std::make_pair(workspace->device_id, workspace->group)];
+            stats.workspace_bytes -= workspace->size;
+        }
+        delete workspace;
+    }
+
+    void WorkspaceManager::detach(const std::shared_ptr<SharedWorkspace>& workspace, size_t size)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& stats = m_group_stats[std::make_pair(workspace->device_id, workspace->group)];
+        stats.requested_bytes -= size;
+        stats.member_count--;
+    }
+
+    int WorkspaceManager::getGroupStats(int device_id, const std::string& group, WorkspaceGroupStats& stats)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto iter = m_group_stats.find(std::make_pair(device_id, group));
+        if (m_group_stats.end() == iter)
+        {
+            stats = WorkspaceGroupStats();
+            return -1;
+        }
+        stats = iter->second;
+        return 0;
+    }
+
+} // namespace ACL_ENGINE
\ No newline at end of file
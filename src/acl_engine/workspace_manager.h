@@ -0,0 +1,63 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#pragma once
+#include <map>
+#include <string>
+#include <memory>
+#include <mutex>
+#include "acl_engine/non_copyable.h"
+
+namespace ACL_ENGINE
+{
+
+    /** model work memory shared by a group of models, models of group execute one at a time */
+    typedef struct SharedWorkspace
+    {
+        int                                     device_id = -1;
+        std::string                             group;
+        void*                                   ptr = nullptr;
+        size_t                                  size = 0;
+        std::mutex                              execute_mutex;              // held by member model during execute
+    } SharedWorkspace;
+
+    typedef struct WorkspaceGroupStats
+    {
+        size_t                                  workspace_bytes = 0;        // device bytes of group workspaces
+        size_t                                  requested_bytes = 0;        // sum of work size of member models
+        uint64_t                                member_count = 0;
+    } WorkspaceGroupStats;
+
+    /** per device owner of shared model workspaces, one workspace per sharing group */
+    class WorkspaceManager : public NonCopyable
+    {
+    public:
+        static WorkspaceManager& Instance();
+
+        /**
+         * @brief get workspace of group on device, workspace is created or replaced by a larger one when too small
+         * @param device_id, device model loaded on, current context should be on it
+         * @param group, sharing group name
+         * @param size, work size of model
+         * @return shared workspace, released when all member models released it, nullptr if fail
+         */
+        std::shared_ptr<SharedWorkspace> acquire(int device_id, const std::string& group, size_t size);
+        // model of work size leaves group, called before model release the workspace
+        void detach(const std::shared_ptr<SharedWorkspace>& workspace, size_t size);
+        int getGroupStats(int device_id, const std::string& group, WorkspaceGroupStats& stats);
+
+    private:
+        WorkspaceManager() = default;
+        ~WorkspaceManager() = default;
+        void release(SharedWorkspace* workspace);
+
+    private:
+        std::mutex                                                                  m_mutex;
+        std::map<std::pair<int, std::string>, std::weak_ptr<SharedWorkspace>>       m_workspaces;
+        std::map<std::pair<int, std::string>, WorkspaceGroupStats>                  m_group_stats;
+    };
+
+} // namespace ACL_ENGINE
\ No newline at end of file
@@ -0,0 +1,213 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include "acl_engine/log.h"
+#include "acl_engine/zstd_decoder.h"
+#ifdef ENGINE_SUPPORT_ZSTD
+#include <zstd.h>
+#endif
+
+namespace ACL_ENGINE
+{
+
+    bool isZstdFile(const std::string& file)
+    {
+        const std::string suffix = ".zst";
+        return file.size() > suffix.size() && 0 == file.compare(file.size() - suffix.size(), suffix.size(), suffix);
+    }
+
+#ifdef ENGINE_SUPPORT_ZSTD
+    // seek table of zstd seekable format, a skippable frame at end of file
+    #define ZSTD_SEEKABLE_MAGIC                 0x8F92EAB1U
+    #define ZSTD_SEEK_TABLE_SKIPPABLE_MAGIC     0x184D2A5EU
+    #define ZSTD_SEEK_TABLE_FOOTER_SIZE         9
+    #define ZSTD_SKIPPABLE_HEADER_SIZE          8
+
+    typedef struct ZstdFrame
+    {
+        size_t                                  src_offset = 0;
+        size_t                                  src_size = 0;
+        size_t                                  dst_offset = 0;
+        size_t                                  dst_size = 0;
+    } ZstdFrame;
+
+    static uint32_t readLE32(const char* data)
+    {
+        const unsigned char* bytes = (const unsigned char*)data;
+        return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+    }
+
+    static bool readSeekTable(const char* data, size_t size, std::vector<ZstdFrame>& frames)
+    {
+        // only last page of file is read, frames are located without walking compressed data
+        if (size < ZSTD_SKIPPABLE_HEADER_SIZE + ZSTD_SEEK_TABLE_FOOTER_SIZE)
+            return false;
+        const char* footer = data + size - ZSTD_SEEK_TABLE_FOOTER_SIZE;
+        if (ZSTD_SEEKABLE_MAGIC != readLE32(footer + 5))
+            return false;
+        size_t frame_num = readLE32(footer);
+        size_t entry_size = (footer[4] & 0x80) ? 12 : 8;
+        size_t table_size = ZSTD_SKIPPABLE_HEADER_SIZE + frame_num * entry_size + ZSTD_SEEK_TABLE_FOOTER_SIZE;
+        if (table_size > size)
+            return false;
+        const char* table = data + size - table_size;
+        if (ZSTD_SEEK_TABLE_SKIPPABLE_MAGIC != readLE32(table) || table_size - ZSTD_SKIPPABLE_HEADER_SIZE != readLE32(table + 4))
+            return false;
+
+        size_t src_offset = 0;
+        size_t dst_offset = 0;
+        const char* entry = table + ZSTD_SKIPPABLE_HEADER_SIZE;
+        for (size_t index = 0; index < frame_num; index++, entry += entry_size)
+        {
+            ZstdFrame frame;
+            frame.src_offset = src_offset;
+            frame.src_size = readLE32(entry);
+            frame.dst_offset = dst_offset;
+            frame.dst_size = readLE32(entry + 4);
+            src_offset += frame.src_size;
+            dst_offset += frame.dst_size;
+            frames.push_back(frame);
+        }
+        if (src_offset != size - table_size)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "zstd seek table frames cover {} bytes, expect {} bytes", src_offset, 
+                size - table_size);
+            frames.clear();
+            return false;
+        }
+        return true;
+    }
+
+    static bool walkFrames(const char* data, size_t size, std::vector<ZstdFrame>& frames)
+    {
+        size_t src_offset = 0;
+        size_t dst_offset = 0;
+        while (src_offset < size)
+        {
+            const char* frame_data = data + src_offset;
+            size_t remain = size - src_offset;
+            size_t frame_size = ZSTD_findFrameCompressedSize(frame_data, remain);
+            if (ZSTD_isError(frame_size))
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "invalid zstd frame at offset {}, {}", src_offset, 
+                    ZSTD_getErrorName(frame_size));
+                return false;
+            }
+            // skippable frames carry no model data
+            if (4 <= remain && ZSTD_MAGIC_SKIPPABLE_START == (readLE32(frame_data) & ZSTD_MAGIC_SKIPPABLE_MASK))
+            {
+                src_offset += frame_size;
+                continue;
+            }
+            unsigned long long content_size = ZSTD_getFrameContentSize(frame_data, remain);
+            if (ZSTD_CONTENTSIZE_UNKNOWN == content_size || ZSTD_CONTENTSIZE_ERROR == content_size)
+            {
+                ACL_LOG(ACL_LOG_LEVEL_ERROR, "zstd frame at offset {} has no content size, compress file with "
+                    "content size in frame header", src_offset);
+                return false;
+            }
+            ZstdFrame frame;
+            frame.src_offset = src_offset;
+            frame.src_size = frame_size;
+            frame.dst_offset = dst_offset;
+            frame.dst_size = (size_t)content_size;
+            frames.push_back(frame);
+            src_offset += frame_size;
+            dst_offset += frame.dst_size;
+        }
+        return true;
+    }
+
+    int zstdDecompress(const char* data, size_t size, int thread_num, char*& out_data, size_t& out_size)
+    {
+        out_data = nullptr;
+        out_size = 0;
+        std::vector<ZstdFrame> frames;
+        if (!readSeekTable(data, size, frames) && !walkFrames(data, size, frames))
+            return -1;
+        for (auto& frame : frames)
+            out_size += frame.dst_size;
+        if (frames.empty() || 0 == out_size)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "zstd data of {} bytes has no content", size);
+            return -1;
+        }
+
+        // decompressed into anonymous mapping, released same way as file mapping
+        void* buffer = mmap(nullptr, out_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (MAP_FAILED == buffer)
+        {
+            ACL_LOG(ACL_LOG_LEVEL_ERROR, "mmap {} bytes for decompressed data fail, {}", out_size, strerror(errno));
+            out_size = 0;
+            return -1;
+        }
+
+        // threads take frames in file order, so compressed data is still read front to back
+        if (0 >= thread_num)
+            thread_num = std::max(1, (int)std::thread::hardware_concurrency());
+        thread_num = std::min(thread_num, (int)frames.size());
+        if (1 == frames.size())
+            ACL_LOG(ACL_LOG_LEVEL_WARN, "zstd data has only one frame, compress it in chunks to decompress in parallel");
+        std::atomic<size_t> next_frame{0};
+        std::atomic<bool> failed{false};
+        char* dst = (char*)buffer;
+        auto worker = [&]() {
+            ZSTD_DCtx* dctx = ZSTD_createDCtx();
+            if (nullptr == dctx)
+            {
+                failed = true;
+                return;
+            }
+            for (size_t index = next_frame++; index < frames.size() && !failed; index = next_frame++)
+            {
+                const auto& frame = frames[index];
+                size_t ret = ZSTD_decompressDCtx(dctx, dst + frame.dst_offset, frame.dst_size, 
+                    data + frame.src_offset, frame.src_size);
+                if (ZSTD_isError(ret) || ret != frame.dst_size)
+                {
+                    ACL_LOG(ACL_LOG_LEVEL_ERROR, "decompress zstd frame {} fail, {}", index, 
+                        ZSTD_isError(ret) ? ZSTD_getErrorName(ret) : "content size mismatch");
+                    failed = true;
+                }
+            }
+            ZSTD_freeDCtx(dctx);
+        };
+        std::vector<std::thread> threads;
+        for (int index = 1; index < thread_num; index++)
+            threads.emplace_back(worker);
+        worker();
+        for (auto& thread : threads)
+            thread.join();
+
+        if (failed)
+        {
+            munmap(buffer, out_size);
+            out_size = 0;
+            return -1;
+        }
+        out_data = dst;
+        ACL_LOG(ACL_LOG_LEVEL_INFO, "decompress zstd data of {} bytes to {} bytes, frames:{}, threads:{}", 
+            size, out_size, frames.size(), thread_num);
+        return 0;
+    }
+#else
+    int zstdDecompress(const char* data, size_t size, int thread_num, char*& out_data, size_t& out_size)
+    {
+        out_data = nullptr;
+        out_size = 0;
+        ACL_LOG(ACL_LOG_LEVEL_ERROR, "decompress zstd data need rebuild with ENGINE_SUPPORT_ZSTD");
+        return -1;
+    }
+#endif
+
+} // namespace ACL_ENGINE
\ No newline at end of file
@@ -0,0 +1,30 @@
+/********************************************
+ * @Author: zhaojd-a
+ * @Date: 2024-06-13
+ * @LastEditTime: 2024-06-13
+ * @LastEditors: zhaojd-a
+ ********************************************/
+#pragma once
+#include <string>
+
+namespace ACL_ENGINE
+{
+
+    // model file compressed with zstd, named with .zst suffix
+    bool isZstdFile(const std::string& file);
+
+    /**
+     * @brief decompress zstd data of one or more frames, frames are decompressed by threads in parallel,
+     *        each thread reads in compressed pages of its own frames, so file read overlaps with decompression.
+     *        frame sizes come from seek table of zstd seekable format if present, else from frame headers,
+     *        frames must have content size in header, which zstd cli writes by default
+     * @param data, compressed data, usually mapped file
+     * @param size, compressed data bytes
+     * @param thread_num, decompress threads, 0 means one per cpu core
+     * @param out_data, decompressed data in anonymous mapping, release it with munmap(out_data, out_size)
+     * @param out_size, decompressed data bytes
+     * @return 0 if success, -1 if fail
+     */
+    int zstdDecompress(const char* data, size_t size, int thread_num, char*& out_data, size_t& out_size);
+
+} // namespace ACL_ENGINE
\ No newline at end of file
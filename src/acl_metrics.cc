@@ -0,0 +1,340 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include <chrono>
+#include "acl_metrics.h"
+
+namespace triton::backend::acl
+{
+
+    typedef struct AclMetricFamilyInfo
+    {
+        const char*                                 name;
+        TRITONSERVER_MetricKind                     kind;
+        const char*                                 description;
+    } AclMetricFamilyInfo;
+
+    static const AclMetricFamilyInfo gAclMetricFamilyInfos[] = {
+        {ACL_METRIC_EXECUTE_QUEUE_DURATION, TRITONSERVER_METRIC_KIND_COUNTER,
+            "Cumulative time executes waited in device scheduler queue in microseconds"},
+#ifdef ACL_METRIC_SUPPORT_HISTOGRAM
+        {ACL_METRIC_EXECUTE_QUEUE_LATENCY, TRITONSERVER_METRIC_KIND_HISTOGRAM,
+            "Distribution of time executes waited in device scheduler queue in microseconds"},
+#endif
+        {ACL_METRIC_EXECUTE_TIMEOUT, TRITONSERVER_METRIC_KIND_COUNTER,
+            "Number of executes failed with execute timeout"},
+        {ACL_METRIC_INSTANCE_STREAM_BROKEN, TRITONSERVER_METRIC_KIND_GAUGE,
+            "1 if instance stream is not recovered after execute timeout and executes are rejected, else 0"},
+        {ACL_METRIC_GRAPH_CAPTURE_HIT, TRITONSERVER_METRIC_KIND_COUNTER,
+            "Number of executes replayed from captured graph"},
+        {ACL_METRIC_GRAPH_CAPTURE_MISS, TRITONSERVER_METRIC_KIND_COUNTER,
+            "Number of executes need graph capture"},
+        {ACL_METRIC_SYNC_WAIT_DURATION, TRITONSERVER_METRIC_KIND_COUNTER,
+            "Cumulative time host waited stream finish in microseconds"},
+        {ACL_METRIC_SYNC_WAKEUP_LATENCY, TRITONSERVER_METRIC_KIND_COUNTER,
+            "Cumulative interval between stream finish and host notice it in polling sync mode in microseconds"},
+        {ACL_METRIC_INSTANCE_DEVICE_MEMORY, TRITONSERVER_METRIC_KIND_GAUGE,
+            "Device memory held by instance, io buffers, dynamic outputs and model memory in bytes"},
+        {ACL_METRIC_INSTANCE_DEVICE_MEMORY_PEAK, TRITONSERVER_METRIC_KIND_GAUGE,
+            "Peak device memory held by instance in bytes"},
+        {ACL_METRIC_INSTANCE_WORKSPACE_MEMORY, TRITONSERVER_METRIC_KIND_GAUGE,
+            "Work memory of workspace group the instance belongs to, shared with other members in bytes"},
+        {ACL_METRIC_INSTANCE_HOST_MEMORY, TRITONSERVER_METRIC_KIND_GAUGE,
+            "Host memory reserved by output tensors of instance in bytes"},
+        {ACL_METRIC_INSTANCE_HOST_MEMORY_PEAK, TRITONSERVER_METRIC_KIND_GAUGE,
+            "Peak host memory reserved by output tensors of instance in bytes"},
+        {ACL_METRIC_DEVICE_MEMORY_TOTAL, TRITONSERVER_METRIC_KIND_GAUGE,
+            "Total device memory in bytes"},
+        {ACL_METRIC_DEVICE_MEMORY_USED, TRITONSERVER_METRIC_KIND_GAUGE,
+            "Used device memory of all processes in bytes"},
+        {ACL_METRIC_DEVICE_ALLOCATOR_ALLOCATED, TRITONSERVER_METRIC_KIND_GAUGE,
+            "Device memory in use from caching allocator in bytes"},
+        {ACL_METRIC_DEVICE_ALLOCATOR_CACHED, TRITONSERVER_METRIC_KIND_GAUGE,
+            "Device memory malloced by caching allocator, in use and free, in bytes"},
+        {ACL_METRIC_DEVICE_ALLOCATOR_PEAK, TRITONSERVER_METRIC_KIND_GAUGE,
+            "Peak device memory in use from caching allocator in bytes"},
+        {ACL_METRIC_HOST_POOL_IN_USE, TRITONSERVER_METRIC_KIND_GAUGE,
+            "Host memory in use from host/pinned/numa pools in bytes"},
+        {ACL_METRIC_HOST_POOL_CACHED, TRITONSERVER_METRIC_KIND_GAUGE,
+            "Free host memory kept by host/pinned/numa pools in bytes"},
+        {ACL_METRIC_MODEL_EVICT, TRITONSERVER_METRIC_KIND_COUNTER,
+            "Number of times model evicted from device by device memory budget"},
+        {ACL_METRIC_MODEL_EVICT_DURATION, TRITONSERVER_METRIC_KIND_COUNTER,
+            "Cumulative time of evicting model from device in microseconds"},
+        {ACL_METRIC_MODEL_RELOAD, TRITONSERVER_METRIC_KIND_COUNTER,
+            "Number of times evicted model reloaded on its next execute"},
+        {ACL_METRIC_MODEL_RELOAD_DURATION, TRITONSERVER_METRIC_KIND_COUNTER,
+            "Cumulative time of reloading evicted model in microseconds"},
+        {ACL_METRIC_MODEL_LOAD_QUEUE_DURATION, TRITONSERVER_METRIC_KIND_COUNTER,
+            "Cumulative time model loads waited for io and device load slots in microseconds"},
+        {ACL_METRIC_MODEL_LOAD_READ_DURATION, TRITONSERVER_METRIC_KIND_COUNTER,
+            "Cumulative time of reading model file in microseconds"},
+        {ACL_METRIC_MODEL_LOAD_DURATION, TRITONSERVER_METRIC_KIND_COUNTER,
+            "Cumulative time of loading model to device in microseconds"},
+    };
+
+#ifdef ACL_METRIC_SUPPORT_HISTOGRAM
+    // bucket bounds of latency histograms in microseconds
+    static const double gAclLatencyBucketsUs[] = {50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000};
+
+    static bool IsHistogramFamily(const std::string& family_name)
+    {
+        for (const auto& info : gAclMetricFamilyInfos)
+        {
+            if (family_name == info.name)
+                return TRITONSERVER_METRIC_KIND_HISTOGRAM == info.kind;
+        }
+        return false;
+    }
+
+    static TRITONSERVER_Error* NewHistogramMetric(TRITONSERVER_MetricFamily* family, 
+        std::vector<const TRITONSERVER_Parameter*>& label_params, TRITONSERVER_Metric** metric)
+    {
+        TRITONSERVER_MetricArgs* args = nullptr;
+        RETURN_IF_ERROR(TRITONSERVER_MetricArgsNew(&args));
+        auto err = TRITONSERVER_MetricArgsSetHistogram(args, gAclLatencyBucketsUs, 
+            sizeof(gAclLatencyBucketsUs) / sizeof(gAclLatencyBucketsUs[0]));
+        if (nullptr == err)
+            err = TRITONSERVER_MetricNewWithArgs(metric, family, label_params.data(), label_params.size(), args);
+        LOG_IF_ERROR(TRITONSERVER_MetricArgsDelete(args), "failed deleting metric args");
+        return err;
+    }
+#endif
+
+    AclMetrics& AclMetrics::Instance()
+    {
+        static AclMetrics metrics;
+        return metrics;
+    }
+
+    TRITONSERVER_Error* AclMetrics::Initialize()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& info : gAclMetricFamilyInfos)
+        {
+            if (families_.end() != families_.find(info.name))
+                continue;
+            TRITONSERVER_MetricFamily* family = nullptr;
+            auto err = TRITONSERVER_MetricFamilyNew(&family, info.kind, info.name, info.description);
+            if (nullptr != err)
+            {
+                // metrics may be disabled by server, acl backend still works without metrics
+                LOG_MESSAGE(TRITONSERVER_LOG_WARN, (std::string("create metric family ") + info.name + 
+                    " fail: " + TRITONSERVER_ErrorMessage(err)).c_str());
+                TRITONSERVER_ErrorDelete(err);
+                continue;
+            }
+            families_[info.name] = family;
+        }
+        return nullptr;
+    }
+
+    TRITONSERVER_Error* AclMetrics::Finalize()
+    {
+        {
+            std::lock_guard<std::mutex> gauge_lock(gauge_mutex_);
+            for (auto& it : gauges_)
+            {
+                if (nullptr != it.second)
+                {
+                    LOG_IF_ERROR(TRITONSERVER_MetricDelete(it.second), "failed deleting backend metric");
+                }
+            }
+            gauges_.clear();
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& it : families_)
+        {
+            LOG_IF_ERROR(TRITONSERVER_MetricFamilyDelete(it.second), "failed deleting metric family");
+        }
+        families_.clear();
+        return nullptr;
+    }
+
+    TRITONSERVER_Error* AclMetrics::NewMetric(const std::string& family_name, 
+        const std::vector<std::pair<std::string, std::string>>& labels, TRITONSERVER_Metric** metric)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        *metric = nullptr;
+        auto iter = families_.find(family_name);
+        if (families_.end() == iter)
+        {
+            return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_NOT_FOUND, 
+                (std::string("metric family ") + family_name + " not found").c_str());
+        }
+
+        std::vector<const TRITONSERVER_Parameter*> label_params;
+        for (const auto& label : labels)
+        {
+            label_params.emplace_back(TRITONSERVER_ParameterNew(label.first.c_str(), 
+                TRITONSERVER_PARAMETER_STRING, label.second.c_str()));
+        }
+#ifdef ACL_METRIC_SUPPORT_HISTOGRAM
+        auto err = IsHistogramFamily(family_name) ? NewHistogramMetric(iter->second, label_params, metric) :
+            TRITONSERVER_MetricNew(metric, iter->second, label_params.data(), label_params.size());
+#else
+        auto err = TRITONSERVER_MetricNew(metric, iter->second, label_params.data(), label_params.size());
+#endif
+        for (auto param : label_params)
+        {
+            TRITONSERVER_ParameterDelete(const_cast<TRITONSERVER_Parameter*>(param));
+        }
+        return err;
+    }
+
+    void AclMetrics::SetGauge(const std::string& family_name, 
+        const std::vector<std::pair<std::string, std::string>>& labels, double value)
+    {
+        SetGauge(GetGauge(family_name, labels), value);
+    }
+
+    void AclMetrics::SetGauge(TRITONSERVER_Metric* metric, double value)
+    {
+        if (nullptr != metric)
+        {
+            LOG_IF_ERROR(TRITONSERVER_MetricSet(metric, value), "failed setting metric");
+        }
+    }
+
+    TRITONSERVER_Metric* AclMetrics::GetGauge(const std::string& family_name, 
+        const std::vector<std::pair<std::string, std::string>>& labels)
+    {
+        std::string key = family_name;
+        for (const auto& label : labels)
+        {
+            key += "," + label.first + "=" + label.second;
+        }
+        std::lock_guard<std::mutex> lock(gauge_mutex_);
+        auto iter = gauges_.find(key);
+        if (gauges_.end() == iter)
+        {
+            // remember nullptr metric too, so a disabled family is only looked up once
+            TRITONSERVER_Metric* metric = nullptr;
+            auto err = NewMetric(family_name, labels, &metric);
+            if (nullptr != err)
+            {
+                LOG_MESSAGE(TRITONSERVER_LOG_VERBOSE, (std::string("create metric ") + family_name + 
+                    " fail: " + TRITONSERVER_ErrorMessage(err)).c_str());
+                TRITONSERVER_ErrorDelete(err);
+            }
+            iter = gauges_.emplace(key, metric).first;
+        }
+        return iter->second;
+    }
+
+    bool AclMetrics::ShouldRefreshShared()
+    {
+        uint64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        uint64_t last_ms = last_refresh_ms_.load();
+        if (0 != last_ms && now_ms - last_ms < ACL_METRIC_SHARED_REFRESH_INTERVAL_MS)
+            return false;
+        return last_refresh_ms_.compare_exchange_strong(last_ms, now_ms);
+    }
+
+    InstanceMetrics::InstanceMetrics(const std::string& model_name, uint64_t model_version, 
+        const std::string& instance_name, int device_id)
+    {
+        labels_ = {{"model", model_name}, {"version", std::to_string(model_version)}, 
+            {"instance", instance_name}, {"device", std::to_string(device_id)}};
+    }
+
+    InstanceMetrics::~InstanceMetrics()
+    {
+        for (auto& it : metrics_)
+        {
+            if (nullptr != it.second)
+            {
+                LOG_IF_ERROR(TRITONSERVER_MetricDelete(it.second), "failed deleting instance metric");
+            }
+        }
+        metrics_.clear();
+    }
+
+    TRITONSERVER_Metric* InstanceMetrics::GetMetric(const char* family_name)
+    {
+        auto iter = metrics_.find(family_name);
+        if (metrics_.end() != iter)
+        {
+            return iter->second;
+        }
+        // remember nullptr metric too, so a disabled family is only looked up once
+        TRITONSERVER_Metric* metric = nullptr;
+        auto err = AclMetrics::Instance().NewMetric(family_name, labels_, &metric);
+        if (nullptr != err)
+        {
+            LOG_MESSAGE(TRITONSERVER_LOG_VERBOSE, (std::string("create metric ") + family_name + 
+                " fail: " + TRITONSERVER_ErrorMessage(err)).c_str());
+            TRITONSERVER_ErrorDelete(err);
+        }
+        metrics_.emplace(family_name, metric);
+        return metric;
+    }
+
+    void InstanceMetrics::Increment(const char* family_name, double value)
+    {
+        auto metric = GetMetric(family_name);
+        if (nullptr != metric)
+        {
+            LOG_IF_ERROR(TRITONSERVER_MetricIncrement(metric, value), "failed incrementing metric");
+        }
+    }
+
+    void InstanceMetrics::Set(const char* family_name, double value)
+    {
+        auto metric = GetMetric(family_name);
+        if (nullptr != metric)
+        {
+            LOG_IF_ERROR(TRITONSERVER_MetricSet(metric, value), "failed setting metric");
+        }
+    }
+
+    void InstanceMetrics::Observe(const char* family_name, double value)
+    {
+#ifdef ACL_METRIC_SUPPORT_HISTOGRAM
+        auto metric = GetMetric(family_name);
+        if (nullptr != metric)
+        {
+            LOG_IF_ERROR(TRITONSERVER_MetricObserve(metric, value), "failed observing metric");
+        }
+#else
+        (void)family_name;
+        (void)value;
+#endif
+    }
+
+    void InstanceMetrics::IncrementTo(const char* family_name, uint64_t total)
+    {
+        auto iter = totals_.find(family_name);
+        if (totals_.end() == iter)
+            iter = totals_.emplace(family_name, 0).first;
+        auto& last_total = iter->second;
+        if (total <= last_total)
+            return;
+        Increment(family_name, double(total - last_total));
+        last_total = total;
+    }
+
+} // namespace triton::backend::acl
\ No newline at end of file
@@ -0,0 +1,130 @@
+// Copyright (c) 2021, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#include <map>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "triton/backend/backend_common.h"
+#include "triton/core/tritonserver.h"
+
+namespace triton::backend::acl
+{
+
+    // backend custom metric family names
+    #define ACL_METRIC_EXECUTE_QUEUE_DURATION           "acl_execute_queue_duration_us"
+    #define ACL_METRIC_EXECUTE_QUEUE_LATENCY            "acl_execute_queue_latency_us"
+    #define ACL_METRIC_EXECUTE_TIMEOUT                  "acl_execute_timeout_total"
+    #define ACL_METRIC_INSTANCE_STREAM_BROKEN           "acl_instance_stream_broken"
+    #define ACL_METRIC_GRAPH_CAPTURE_HIT                "acl_graph_capture_hit_total"
+    #define ACL_METRIC_GRAPH_CAPTURE_MISS               "acl_graph_capture_miss_total"
+    #define ACL_METRIC_SYNC_WAIT_DURATION               "acl_sync_wait_duration_us"
+    #define ACL_METRIC_SYNC_WAKEUP_LATENCY              "acl_sync_wakeup_latency_us"
+    #define ACL_METRIC_INSTANCE_DEVICE_MEMORY           "acl_instance_device_memory_bytes"
+    #define ACL_METRIC_INSTANCE_DEVICE_MEMORY_PEAK      "acl_instance_device_memory_peak_bytes"
+    #define ACL_METRIC_INSTANCE_WORKSPACE_MEMORY        "acl_instance_shared_workspace_bytes"
+    #define ACL_METRIC_INSTANCE_HOST_MEMORY             "acl_instance_host_memory_bytes"
+    #define ACL_METRIC_INSTANCE_HOST_MEMORY_PEAK        "acl_instance_host_memory_peak_bytes"
+    #define ACL_METRIC_DEVICE_MEMORY_TOTAL              "acl_device_memory_total_bytes"
+    #define ACL_METRIC_DEVICE_MEMORY_USED               "acl_device_memory_used_bytes"
+    #define ACL_METRIC_DEVICE_ALLOCATOR_ALLOCATED       "acl_device_allocator_allocated_bytes"
+    #define ACL_METRIC_DEVICE_ALLOCATOR_CACHED          "acl_device_allocator_cached_bytes"
+    #define ACL_METRIC_DEVICE_ALLOCATOR_PEAK            "acl_device_allocator_peak_allocated_bytes"
+    #define ACL_METRIC_HOST_POOL_IN_USE                 "acl_host_pool_in_use_bytes"
+    #define ACL_METRIC_HOST_POOL_CACHED                 "acl_host_pool_cached_bytes"
+    #define ACL_METRIC_MODEL_EVICT                      "acl_model_evict_total"
+    #define ACL_METRIC_MODEL_EVICT_DURATION             "acl_model_evict_duration_us"
+    #define ACL_METRIC_MODEL_RELOAD                     "acl_model_reload_total"
+    #define ACL_METRIC_MODEL_RELOAD_DURATION            "acl_model_reload_duration_us"
+    #define ACL_METRIC_MODEL_LOAD_QUEUE_DURATION        "acl_model_load_queue_duration_us"
+    #define ACL_METRIC_MODEL_LOAD_READ_DURATION         "acl_model_load_read_duration_us"
+    #define ACL_METRIC_MODEL_LOAD_DURATION              "acl_model_load_duration_us"
+
+    // backend wide gauges such as device memory are refreshed at most once per interval
+    #define ACL_METRIC_SHARED_REFRESH_INTERVAL_MS       1000
+
+    // Owns the custom metric families of acl backend, created in
+    // TRITONBACKEND_Initialize and deleted in TRITONBACKEND_Finalize.
+    class AclMetrics
+    {
+    public:
+        static AclMetrics& Instance();
+        TRITONSERVER_Error* Initialize();
+        TRITONSERVER_Error* Finalize();
+        TRITONSERVER_Error* NewMetric(const std::string& family_name, 
+            const std::vector<std::pair<std::string, std::string>>& labels, TRITONSERVER_Metric** metric);
+        // Set backend wide gauge, metric is created on first use and owned by AclMetrics
+        void SetGauge(const std::string& family_name, 
+            const std::vector<std::pair<std::string, std::string>>& labels, double value);
+        // Backend wide gauge owned by AclMetrics, callers refreshing it often keep the handle,
+        // nullptr if metric family is disabled
+        TRITONSERVER_Metric* GetGauge(const std::string& family_name, 
+            const std::vector<std::pair<std::string, std::string>>& labels);
+        void SetGauge(TRITONSERVER_Metric* metric, double value);
+        // True for the first caller after refresh interval passed, it refreshes backend wide gauges
+        bool ShouldRefreshShared();
+
+    private:
+        AclMetrics() = default;
+        ~AclMetrics() = default;
+
+    private:
+        std::mutex                                                  mutex_;
+        std::map<std::string, TRITONSERVER_MetricFamily*>           families_;
+        std::mutex                                                  gauge_mutex_;
+        std::map<std::string, TRITONSERVER_Metric*>                 gauges_;
+        std::atomic<uint64_t>                                       last_refresh_ms_{0};
+    };
+
+    // Metrics of one model instance, each metric is created on first use
+    // with model/version/instance/device labels.
+    class InstanceMetrics
+    {
+    public:
+        InstanceMetrics(const std::string& model_name, uint64_t model_version, const std::string& instance_name, 
+            int device_id);
+        ~InstanceMetrics();
+        // family names are looked up without building strings, execute path passes ACL_METRIC_* literals
+        void Increment(const char* family_name, double value);
+        void Set(const char* family_name, double value);
+        // Observe histogram, no-op when backend built without ACL_METRIC_SUPPORT_HISTOGRAM
+        void Observe(const char* family_name, double value);
+        // Increment counter to total value counted elsewhere, such as engine
+        void IncrementTo(const char* family_name, uint64_t total);
+        // engine replaced, totals counted by new engine start from zero
+        void ResetTotals() { totals_.clear(); }
+
+    private:
+        TRITONSERVER_Metric* GetMetric(const char* family_name);
+
+    private:
+        std::vector<std::pair<std::string, std::string>>            labels_;
+        std::map<std::string, TRITONSERVER_Metric*, std::less<>>    metrics_;
+        std::map<std::string, uint64_t, std::less<>>                totals_;
+    };
+
+} // namespace triton::backend::acl
\ No newline at end of file
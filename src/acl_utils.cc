@@ -24,6 +24,8 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <algorithm>
+#include <new>
+#include <cstdlib>
 #include <functional>
 #include <iterator>
 #include <numeric>
@@ -37,9 +39,59 @@
 #endif
 #include "acl_utils.h"
 
+#ifndef NDEBUG
+// counted per thread, so each stage of execute path sees its own allocations
+static thread_local uint64_t t_alloc_count = 0;
+
+void* operator new(size_t size)
+{
+    t_alloc_count++;
+    void* ptr = malloc(0 < size ? size : 1);
+    if (nullptr == ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{
+    t_alloc_count++;
+    void* ptr = malloc(0 < size ? size : 1);
+    if (nullptr == ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+#endif
+
 namespace triton::backend::acl
 {
 
+    #ifndef NDEBUG
+    uint64_t ThreadAllocCount()
+    {
+        return t_alloc_count;
+    }
+    #endif
+
     AclTensorDataType ConvertDataType(TRITONSERVER_DataType dtype)
     {
         switch (dtype)
@@ -37,6 +37,16 @@ using AclTensorDataType = ACL_ENGINE::EngineTensor::TensorDataType;
 namespace triton::backend::acl
 {
 
+    // verbose message is only built when verbose log is enabled, so execute path builds no strings by default
+    #define LOG_VERBOSE_MESSAGE(MSG)                                                    \
+        do                                                                              \
+        {                                                                               \
+            if (TRITONSERVER_LogIsEnabled(TRITONSERVER_LOG_VERBOSE))                    \
+            {                                                                           \
+                LOG_MESSAGE(TRITONSERVER_LOG_VERBOSE, (MSG).c_str());                   \
+            }                                                                           \
+        } while (false)
+
     AclTensorDataType ConvertDataType(TRITONSERVER_DataType dtype);
     AclTensorDataType ConvertDataType(const std::string& dtype);
     TRITONSERVER_DataType ConvertDataType(AclTensorDataType dtype);
@@ -46,4 +56,10 @@ namespace triton::backend::acl
     TRITONSERVER_Error* OpenLibraryHandle(const std::string& path, void** handle);
     TRITONSERVER_Error* CloseLibraryHandle(void* handle);
 
+    #ifndef NDEBUG
+    // operator new calls made by backend code on calling thread, debug builds only. Symbols of backend
+    // are local by its linker script, so allocations of server and other backends are not counted
+    uint64_t ThreadAllocCount();
+    #endif
+
 } // namespace triton::backend::acl
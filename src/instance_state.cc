@@ -24,10 +24,13 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <set>
+#include <algorithm>
 #include "model_state.h"
 #include "acl_utils.h"
 #include "instance_state.h"
 #include "acl_engine/engine_tensor_utils.h"
+#include "acl_engine/engine_memory_utils.h"
+#include "acl_engine/numa_allocator.h"
 
 namespace triton::backend::acl
 {
@@ -35,23 +38,79 @@ namespace triton::backend::acl
     TRITONSERVER_Error* ModelInstanceState::RunAclModel(std::vector<std::string>& input_names, 
         std::map<std::string, std::shared_ptr<AclTensor>>& input_tensors)
     {
-        if (nullptr == acl_engine_)
+        if (nullptr == acl_engine_ && nullptr == shard_engine_)
         {
             auto err = TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INTERNAL, (std::string("acl engine is nullptr")).c_str());
             return err;
         }
 
-        std::map<std::string, AclTensor*> prepared_tensors;
+        // prepared map keeps its nodes across calls, it is rebuilt only when input names changed
+        auto& prepared_tensors = execute_scratch_.prepared_tensors;
+        if (prepared_tensors.size() != input_names.size())
+            prepared_tensors.clear();
         for (size_t index = 0; index < input_names.size(); index++)
         {
-            std::string tensor_name = input_names[index];
-            if (input_tensors.end() == input_tensors.find(tensor_name))
+            const std::string& tensor_name = input_names[index];
+            auto iter = input_tensors.find(tensor_name);
+            if (input_tensors.end() == iter)
             {
                 auto err = TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INTERNAL, 
                     (std::string("cannot find tensor named: ") + tensor_name).c_str());
                 return err;
             }
-            prepared_tensors[tensor_name] = input_tensors[tensor_name].get();
+            prepared_tensors[tensor_name] = iter->second.get();
+        }
+        if (prepared_tensors.size() != input_names.size())
+        {
+            prepared_tensors.clear();
+            for (const auto& tensor_name : input_names)
+                prepared_tensors[tensor_name] = input_tensors[tensor_name].get();
+        }
+
+        // data parallel engine split batch across devices
+        if (nullptr != shard_engine_)
+        {
+            if (0 != shard_engine_->setEngineInputTensors(prepared_tensors))
+            {
+                TRITONSERVER_Error* err = TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INTERNAL, 
+                        (std::string("shard engine set input tensors fail").c_str()));
+                return err;
+            }
+            if (0 != shard_engine_->runEngine())
+            {
+                // stream not recovered after timeout is recovered again by next execute, report instance unavailable
+                bool stream_broken = shard_engine_->isStreamBroken();
+                if (nullptr != metrics_)
+                    metrics_->Set(ACL_METRIC_INSTANCE_STREAM_BROKEN, stream_broken ? 1 : 0);
+                if (stream_broken)
+                {
+                    UpdateExecuteTimeoutCount(shard_engine_->getExecuteTimeoutCount());
+                    return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_UNAVAILABLE, 
+                        (std::string("shard engine disabled, stream is not recovered after execute timeout").c_str()));
+                }
+                if (UpdateExecuteTimeoutCount(shard_engine_->getExecuteTimeoutCount()))
+                {
+                    return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_UNAVAILABLE, 
+                        (std::string("shard engine execute timeout").c_str()));
+                }
+                TRITONSERVER_Error* err = TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INTERNAL, 
+                    (std::string("shard engine run fail").c_str()));
+                return err;
+            }
+            if (nullptr != metrics_)
+            {
+                metrics_->Set(ACL_METRIC_INSTANCE_STREAM_BROKEN, 0);
+                const double queue_us = shard_engine_->getLastQueueTimeNs() / 1000.0;
+                metrics_->Increment(ACL_METRIC_EXECUTE_QUEUE_DURATION, queue_us);
+                metrics_->Observe(ACL_METRIC_EXECUTE_QUEUE_LATENCY, queue_us);
+                metrics_->IncrementTo(ACL_METRIC_GRAPH_CAPTURE_HIT, shard_engine_->getCaptureHitCount());
+                metrics_->IncrementTo(ACL_METRIC_GRAPH_CAPTURE_MISS, shard_engine_->getCaptureMissCount());
+                const auto sync_stats = shard_engine_->getSyncWaitStats();
+                metrics_->IncrementTo(ACL_METRIC_SYNC_WAIT_DURATION, sync_stats.wait_time_ns / 1000);
+                metrics_->IncrementTo(ACL_METRIC_SYNC_WAKEUP_LATENCY, sync_stats.wakeup_latency_ns / 1000);
+                UpdateMemoryMetrics();
+            }
+            return nullptr;
         }
 
         // set acl engine input tensors
@@ -65,19 +124,211 @@ namespace triton::backend::acl
         // acl engine run
         if (0 != acl_engine_->runEngine())
         {
+            // stream not recovered after timeout is recovered again by next execute, report instance unavailable
+            bool stream_broken = acl_engine_->isStreamBroken();
+            if (nullptr != metrics_)
+                metrics_->Set(ACL_METRIC_INSTANCE_STREAM_BROKEN, stream_broken ? 1 : 0);
+            if (stream_broken)
+            {
+                UpdateExecuteTimeoutCount(acl_engine_->getExecuteTimeoutCount());
+                return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_UNAVAILABLE, 
+                    (std::string("acl engine disabled, stream is not recovered after execute timeout").c_str()));
+            }
+            if (UpdateExecuteTimeoutCount(acl_engine_->getExecuteTimeoutCount()))
+            {
+                return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_UNAVAILABLE, 
+                    (std::string("acl engine execute timeout").c_str()));
+            }
             TRITONSERVER_Error* err = TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INTERNAL, 
                 (std::string("acl engine run fail").c_str()));
             return err;
         }
+        if (nullptr != metrics_)
+        {
+            metrics_->Set(ACL_METRIC_INSTANCE_STREAM_BROKEN, 0);
+            const double queue_us = acl_engine_->getLastQueueTimeNs() / 1000.0;
+            metrics_->Increment(ACL_METRIC_EXECUTE_QUEUE_DURATION, queue_us);
+            metrics_->Observe(ACL_METRIC_EXECUTE_QUEUE_LATENCY, queue_us);
+            metrics_->IncrementTo(ACL_METRIC_GRAPH_CAPTURE_HIT, acl_engine_->getCaptureHitCount());
+            metrics_->IncrementTo(ACL_METRIC_GRAPH_CAPTURE_MISS, acl_engine_->getCaptureMissCount());
+            const auto& sync_stats = acl_engine_->getSyncWaitStats();
+            metrics_->IncrementTo(ACL_METRIC_SYNC_WAIT_DURATION, sync_stats.wait_time_ns / 1000);
+            metrics_->IncrementTo(ACL_METRIC_SYNC_WAKEUP_LATENCY, sync_stats.wakeup_latency_ns / 1000);
+            UpdateMemoryMetrics();
+        }
 
         return nullptr;
     }
 
-    TRITONSERVER_Error* ModelInstanceState::GetAclModelOutputs(std::vector<std::string>& output_names, 
+    bool ModelInstanceState::UpdateExecuteTimeoutCount(uint64_t timeout_count)
+    {
+        // engine counts timeouts, report new ones since last check
+        if (timeout_count <= execute_timeout_count_)
+            return false;
+        if (nullptr != metrics_)
+            metrics_->Increment(ACL_METRIC_EXECUTE_TIMEOUT, double(timeout_count - execute_timeout_count_));
+        execute_timeout_count_ = timeout_count;
+        return true;
+    }
+
+    void ModelInstanceState::SetMemoryMetrics(InstanceMetrics* metrics, const EngineMemoryStats& memory_stats)
+    {
+        metrics->Set(ACL_METRIC_INSTANCE_DEVICE_MEMORY, double(memory_stats.device_bytes + memory_stats.model_bytes));
+        metrics->Set(ACL_METRIC_INSTANCE_DEVICE_MEMORY_PEAK, double(memory_stats.peak_device_bytes + memory_stats.model_bytes));
+        metrics->Set(ACL_METRIC_INSTANCE_WORKSPACE_MEMORY, double(memory_stats.workspace_bytes));
+        metrics->Set(ACL_METRIC_INSTANCE_HOST_MEMORY, double(memory_stats.host_bytes));
+        metrics->Set(ACL_METRIC_INSTANCE_HOST_MEMORY_PEAK, double(memory_stats.peak_host_bytes));
+    }
+
+    void ModelInstanceState::UpdateMemoryMetrics()
+    {
+        if (nullptr != shard_engine_)
+        {
+            auto& memory_stats = execute_scratch_.memory_stats;
+            shard_engine_->getMemoryStats(memory_stats);
+            for (auto& it : memory_stats)
+            {
+                auto iter = shard_metrics_.find(it.first);
+                SetMemoryMetrics((shard_metrics_.end() != iter) ? iter->second.get() : metrics_.get(), it.second);
+            }
+        }
+        else
+        {
+            SetMemoryMetrics(metrics_.get(), acl_engine_->getMemoryStats());
+        }
+        auto residency_stats = (nullptr != shard_engine_) ? shard_engine_->getResidencyStats() : 
+            acl_engine_->getResidencyStats();
+        metrics_->IncrementTo(ACL_METRIC_MODEL_EVICT, residency_stats.evict_count);
+        metrics_->IncrementTo(ACL_METRIC_MODEL_EVICT_DURATION, residency_stats.evict_time_ns / 1000);
+        metrics_->IncrementTo(ACL_METRIC_MODEL_RELOAD, residency_stats.reload_count);
+        metrics_->IncrementTo(ACL_METRIC_MODEL_RELOAD_DURATION, residency_stats.reload_time_ns / 1000);
+        auto load_stats = (nullptr != shard_engine_) ? shard_engine_->getLoadStats() : acl_engine_->getLoadStats();
+        metrics_->IncrementTo(ACL_METRIC_MODEL_LOAD_QUEUE_DURATION, 
+            (load_stats.io_queue_time_ns + load_stats.device_queue_time_ns) / 1000);
+        metrics_->IncrementTo(ACL_METRIC_MODEL_LOAD_READ_DURATION, load_stats.read_time_ns / 1000);
+        metrics_->IncrementTo(ACL_METRIC_MODEL_LOAD_DURATION, load_stats.load_time_ns / 1000);
+
+        // device and host pool gauges are backend wide, refreshed by any instance at most once per interval
+        auto& acl_metrics = AclMetrics::Instance();
+        if (!acl_metrics.ShouldRefreshShared())
+            return;
+        auto& device_infos = execute_scratch_.device_infos;
+        if (nullptr != shard_engine_)
+            shard_engine_->getDeviceMemoryInfo(device_infos);
+        else
+            acl_engine_->getDeviceMemoryInfo(device_infos);
+        for (auto& it : device_infos)
+        {
+            const auto& info = it.second;
+            auto& gauges = GetDeviceGauges(it.first);
+            if (0 < info.total_bytes)
+            {
+                acl_metrics.SetGauge(gauges.total, double(info.total_bytes));
+                acl_metrics.SetGauge(gauges.used, double(info.total_bytes - info.free_bytes));
+            }
+            acl_metrics.SetGauge(gauges.allocated, double(info.allocated_bytes));
+            acl_metrics.SetGauge(gauges.cached, double(info.cached_bytes));
+            acl_metrics.SetGauge(gauges.peak, double(info.peak_allocated_bytes));
+        }
+
+        HostMemoryPoolStats host_stats;
+        getHostMemoryStats(host_stats);
+        auto& host_gauges = GetPoolGauges("host", -1);
+        acl_metrics.SetGauge(host_gauges.in_use, double(host_stats.in_use_bytes));
+        acl_metrics.SetGauge(host_gauges.cached, double(host_stats.cached_bytes));
+        PinnedHostPoolStats pinned_stats;
+        PinnedHostPool::Instance().getStats(pinned_stats);
+        auto& pinned_gauges = GetPoolGauges("pinned", -1);
+        acl_metrics.SetGauge(pinned_gauges.in_use, double(pinned_stats.in_use_bytes));
+        acl_metrics.SetGauge(pinned_gauges.cached, double(pinned_stats.cached_bytes));
+        auto& numa_stats = execute_scratch_.numa_stats;
+        NumaHostAllocator::Instance().getAllNodeStats(numa_stats);
+        for (auto& it : numa_stats)
+        {
+            auto& numa_gauges = GetPoolGauges("numa", it.first);
+            acl_metrics.SetGauge(numa_gauges.in_use, double(it.second.in_use_bytes));
+            acl_metrics.SetGauge(numa_gauges.cached, double(it.second.cached_bytes));
+        }
+    }
+
+    ModelInstanceState::DeviceGauges& ModelInstanceState::GetDeviceGauges(int device_id)
+    {
+        auto iter = device_gauges_.find(device_id);
+        if (device_gauges_.end() != iter)
+            return iter->second;
+        auto& acl_metrics = AclMetrics::Instance();
+        std::vector<std::pair<std::string, std::string>> labels = {{"device", std::to_string(device_id)}};
+        auto& gauges = device_gauges_[device_id];
+        gauges.total = acl_metrics.GetGauge(ACL_METRIC_DEVICE_MEMORY_TOTAL, labels);
+        gauges.used = acl_metrics.GetGauge(ACL_METRIC_DEVICE_MEMORY_USED, labels);
+        gauges.allocated = acl_metrics.GetGauge(ACL_METRIC_DEVICE_ALLOCATOR_ALLOCATED, labels);
+        gauges.cached = acl_metrics.GetGauge(ACL_METRIC_DEVICE_ALLOCATOR_CACHED, labels);
+        gauges.peak = acl_metrics.GetGauge(ACL_METRIC_DEVICE_ALLOCATOR_PEAK, labels);
+        return gauges;
+    }
+
+    ModelInstanceState::PoolGauges& ModelInstanceState::GetPoolGauges(const char* pool, int node)
+    {
+        // pool names are short, key is kept in string inline buffer
+        auto key = std::make_pair(std::string(pool), node);
+        auto iter = pool_gauges_.find(key);
+        if (pool_gauges_.end() != iter)
+            return iter->second;
+        auto& acl_metrics = AclMetrics::Instance();
+        std::vector<std::pair<std::string, std::string>> labels = {{"pool", pool}, {"node", std::to_string(node)}};
+        auto& gauges = pool_gauges_[key];
+        gauges.in_use = acl_metrics.GetGauge(ACL_METRIC_HOST_POOL_IN_USE, labels);
+        gauges.cached = acl_metrics.GetGauge(ACL_METRIC_HOST_POOL_CACHED, labels);
+        return gauges;
+    }
+
+    size_t ModelInstanceState::ScratchFootprint()
+    {
+        size_t footprint = scratch_.responses.capacity() + scratch_.request_batch_sizes.capacity() + 
+            scratch_.input_names.capacity() + scratch_.input_tensors.size() + scratch_.backend_memorys.capacity() + 
+            scratch_.pinned_buffers.capacity() + scratch_.input_shape.capacity() + scratch_.string_ptrs.capacity() + 
+            scratch_.sub_batches.size() + scratch_.sub_batch_results.capacity() + 
+            execute_scratch_.prepared_tensors.size() + execute_scratch_.output_tensors.size() + 
+            execute_scratch_.output_shape.capacity() + execute_scratch_.string_buffer.capacity() + 
+            execute_scratch_.offsets.capacity();
+        for (const auto& name : scratch_.input_names)
+            footprint += name.capacity();
+        for (const auto& sub_batch : scratch_.sub_batches)
+        {
+            footprint += sub_batch->responses.capacity() + sub_batch->backend_memorys.capacity() + 
+                sub_batch->pinned_buffers.capacity() + sub_batch->input_tensors.size() + sub_batch->input_names.capacity();
+            for (const auto& name : sub_batch->input_names)
+                footprint += name.capacity();
+        }
+        return footprint;
+    }
+
+    void ModelInstanceState::CheckScratchGrowth(size_t last_footprint, uint64_t alloc_count)
+    {
+        // scratch only grows while requests are new to the instance, steady state calls leave it unchanged
+        size_t footprint = ScratchFootprint();
+        if (footprint > last_footprint)
+        {
+            scratch_grow_count_++;
+            LOG_VERBOSE_MESSAGE(Name() + " request scratch grows to footprint " + 
+                std::to_string(footprint) + ", grow count " + std::to_string(scratch_grow_count_));
+        }
+
+        // allocations left in steady state are made by triton helpers, such as input collector internals
+        LOG_VERBOSE_MESSAGE(Name() + " call made " + std::to_string(alloc_count) + 
+            " allocations on instance thread and " + std::to_string(pipeline_alloc_count_) + 
+            " on pipeline worker");
+        pipeline_alloc_count_ = 0;
+        return;
+    }
+
+    TRITONSERVER_Error* ModelInstanceState::GetAclModelOutputs(const std::vector<std::string>& output_names, 
         std::map<std::string, AclTensor*>& output_tensors)
     {
         (void)output_names;
-        if (0 != acl_engine_->getEngineOutputTensors(output_tensors))
+        int ret = (nullptr != shard_engine_) ? shard_engine_->getEngineOutputTensors(output_tensors) : 
+            acl_engine_->getEngineOutputTensors(output_tensors);
+        if (0 != ret)
         {
             TRITONSERVER_Error* err = TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INTERNAL, 
                 (std::string("acl engine get output tensors fail").c_str()));
@@ -127,6 +378,32 @@ namespace triton::backend::acl
         return nullptr;  
     }
 
+    TRITONSERVER_Error* ModelInstanceState::BindTensor(const char* input_name, const std::vector<int64_t>& shape, 
+        TRITONSERVER_DataType triton_dtype, int batchn_byte_size, TRITONSERVER_MemoryType mem_type, int mem_type_id, 
+        std::shared_ptr<AclTensor>& tensor, void* data)
+    {
+        // wrapper tensor of last call only references data, rebind it instead of creating a new one
+        AclTensorDataType tensor_dtype = ConvertDataType(triton_dtype);
+        if (nullptr == tensor || tensor->buffer().own_flag || tensor->getTensorDataType() != tensor_dtype)
+        {
+            return CreateTensor(input_name, shape, triton_dtype, batchn_byte_size, mem_type, mem_type_id, tensor, data);
+        }
+        auto& buffer = tensor->buffer();
+        bool on_device = (TRITONSERVER_MEMORY_GPU == mem_type);
+        buffer.host = on_device ? nullptr : data;
+        buffer.device = on_device ? (uint64_t)data : 0;
+        buffer.device_id = on_device ? mem_type_id : -1;
+        buffer.dim.assign(shape.begin(), shape.end());
+        if (tensor->size() != batchn_byte_size)
+        {
+            tensor.reset();
+            auto err = TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INTERNAL,
+                (std::string("create tensor ") + input_name +  " fail").c_str());
+            return err;
+        }
+        return nullptr;
+    }
+
     TRITONSERVER_Error* ModelInstanceState::CreateStringTensor(const char* input_name, const std::vector<int64_t> shape, 
         TRITONSERVER_DataType triton_dtype, TRITONSERVER_MemoryType mem_type, int mem_type_id, 
         std::shared_ptr<AclTensor>& tensor)
@@ -185,74 +462,86 @@ namespace triton::backend::acl
         return nullptr;  // success
     }
 
-    TRITONSERVER_Error* ModelInstanceState::DetermineModelPath(const std::string& model_dir, std::string* model_path, 
-        std::string* config_path)
+    ModelInstanceState::ModelInstanceState(ModelState* model_state, TRITONBACKEND_ModelInstance* triton_model_instance)
+        : BackendModelInstance(model_state, triton_model_instance), model_state_(model_state)
     {
-        bool config_exists = true;
-        std::string config_file_path = JoinPath({model_dir, "model.txt"});
-        RETURN_IF_ERROR(FileExists(config_file_path, &config_exists));
-        if (not config_exists)
+        // acl model and config file path are determined once by model state
+        const std::string& model_path = model_state->ModelPath();
+        int device_id = DeviceId();
+
+        // sub batches of large batch are executed by pipeline worker
+        if (0 < model_state->PipelineSubBatchSize())
+            pipeline_pool_.reset(new ThreadPool(1));
+
+        // memory types inputs are collected to, built once instead of every request
+        if (Kind() == TRITONSERVER_INSTANCEGROUPKIND_GPU)
         {
-            LOG_MESSAGE(TRITONSERVER_LOG_WARN, ("cannot find model config " + config_file_path).c_str());
+            allowed_input_types_ = {{TRITONSERVER_MEMORY_GPU, DeviceId()},
+                                    {TRITONSERVER_MEMORY_CPU_PINNED, 0},
+                                    {TRITONSERVER_MEMORY_CPU, 0}};
         }
         else
-            *config_path = config_file_path;
-
-        // check mindspore lite model file exist
-        bool mindir_exists = false;
-        bool ms_exists = false;
-        std::string mindir_file_path = JoinPath({model_dir, "model.mindir"});
-        std::string ms_file_path = JoinPath({model_dir, "model.ms"});
-        RETURN_IF_ERROR(FileExists(mindir_file_path, &mindir_exists));
-        RETURN_IF_ERROR(FileExists(ms_file_path, &ms_exists));
-        if (not mindir_exists && not ms_exists)
         {
-            return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_NOT_FOUND, 
-                std::string("acl model should be named as 'model.mindir or model.ms'").c_str());
+            allowed_input_types_ = {{TRITONSERVER_MEMORY_CPU_PINNED, 0}, 
+                                    {TRITONSERVER_MEMORY_CPU, 0}};
         }
-        if (mindir_exists && ms_exists)
+        pinned_input_types_ = {{TRITONSERVER_MEMORY_CPU_PINNED, 0}};
+        cpu_input_types_ = {{TRITONSERVER_MEMORY_CPU, 0}};
+
+        // init data parallel engine when instance shards batch across devices
+        std::vector<std::string> model_files = {model_path};
+        const auto& data_parallel_device_ids = model_state->DataParallelDeviceIds();
+        if (0 != data_parallel_device_ids.size())
         {
-            LOG_MESSAGE(TRITONSERVER_LOG_WARN, "model.mindir and model.ms both exists, model.mindir will be used");
+            // slices run concurrently on pool threads, each shard polls its stream on its own sync core
+            std::vector<EngineConfig> shard_configs;
+            for (auto shard_device_id : data_parallel_device_ids)
+            {
+                EngineConfig shard_config = model_state->InstanceEngineConfig(device_id);
+                shard_config.device_id = shard_device_id;
+                shard_configs.push_back(shard_config);
+            }
+            shard_engine_.reset(new ShardEngine(shard_configs, model_files));
+            if (nullptr == shard_engine_ || false == shard_engine_->status())
+            {
+                shard_engine_.reset();
+                auto err = TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INTERNAL, 
+                    (std::string("Failed to load data parallel model from ") + model_path).c_str());
+                THROW_IF_BACKEND_INSTANCE_ERROR(err);
+            }
+            metrics_.reset(new InstanceMetrics(model_state->Name(), model_state->Version(), Name(), 
+                data_parallel_device_ids[0]));
+            for (size_t index = 1; index < data_parallel_device_ids.size(); index++)
+            {
+                shard_metrics_[data_parallel_device_ids[index]].reset(new InstanceMetrics(model_state->Name(), 
+                    model_state->Version(), Name(), data_parallel_device_ids[index]));
+            }
+            if (model_state->VersionSwap())
+                LOG_MESSAGE(TRITONSERVER_LOG_WARN, "version swap is not supported by data parallel instance");
+            return;
         }
-        *model_path = mindir_exists ? mindir_file_path : ms_file_path;
 
-        return nullptr;
-    }
+        // engine may run on another device than triton's when model state places instances by device memory
+        int engine_device_id = device_id;
+        size_t planned_bytes = 0;
+        THROW_IF_BACKEND_INSTANCE_ERROR(model_state->PlaceInstance(device_id, &engine_device_id, &planned_bytes));
 
-    ModelInstanceState::ModelInstanceState(ModelState* model_state, TRITONBACKEND_ModelInstance* triton_model_instance)
-        : BackendModelInstance(model_state, triton_model_instance), model_state_(model_state)
-    {
-        // get acl model and config file path
-        std::string model_path, config_path;
-        int device_id = DeviceId();
-        auto model_dir = JoinPath({model_state->RepositoryPath(), std::to_string(model_state->Version())});
-        THROW_IF_BACKEND_INSTANCE_ERROR(DetermineModelPath(model_dir, &model_path, &config_path));
-
-        // init engine config
-        EngineConfig engine_config = model_state->AclEngineConfig();
-        // overwrite device id
-        if (-1 == engine_config.device_id)
-        {
-            LOG_MESSAGE(TRITONSERVER_LOG_INFO, ("overwrite device id to " + std::to_string(device_id)).c_str());
-            engine_config.device_id = device_id;
-        }
-        // overwrite config path
-        if ("" == engine_config.config_file && "" != config_path)
+        // engine may be loaded ahead by model state together with engines of other instances
+        acl_engine_ = model_state->TakePreparedEngine(engine_device_id);
+        if (nullptr != acl_engine_)
         {
-            LOG_MESSAGE(TRITONSERVER_LOG_INFO, ("overwrite acl config file to " + config_path).c_str());
-            engine_config.config_file = config_path;
+            model_state->ReleasePlacement(engine_device_id, planned_bytes);
+            metrics_.reset(new InstanceMetrics(model_state->Name(), model_state->Version(), Name(), 
+                model_state->EngineDeviceId(engine_device_id)));
+            InitVersionSwap();
+            return;
         }
-        // overwrite model type by model file postfix
-        // if model ends with ".mindir" then model_type set kmindir or else set kmindir_lite
-        std::string file_postfix = ".mindir";
-        if (model_path.rfind(file_postfix) == (model_path.length() - file_postfix.length()))
-            engine_config.model_type = "kmindir";
-        else
-            engine_config.model_type = "kmindir_lite";
 
         // init acl engine with model files and config info
-        std::vector<std::string> model_files = {model_path};
-        acl_engine_.reset(new MindSporeLiteEngine(engine_config, model_files));
+        EngineConfig engine_config = model_state->InstanceEngineConfig(engine_device_id);
+        acl_engine_.reset(new AscendCLEngine(engine_config, model_files));
+        // loaded engine memory is counted by device free memory from now on
+        model_state->ReleasePlacement(engine_device_id, planned_bytes);
         if (nullptr == acl_engine_ || false == acl_engine_->status())
         {
             acl_engine_.reset();
@@ -260,9 +549,58 @@ namespace triton::backend::acl
                 (std::string("Failed to load model from ") + model_path).c_str());
             THROW_IF_BACKEND_INSTANCE_ERROR(err);
         }
+        metrics_.reset(new InstanceMetrics(model_state->Name(), model_state->Version(), Name(), engine_config.device_id));
+        InitVersionSwap();
         return;
     }
 
+    ModelInstanceState::~ModelInstanceState()
+    {
+        // work running on engines finishes before they are released
+        pipeline_pool_.reset();
+        // engine loaded for this instance by version swap is released by model state
+        if (swap_registered_)
+            model_state_->UnregisterSwapInstance(this);
+        if (!model_state_->AsyncUnload())
+            return;
+
+        // model unload and device close run on releaser thread, instance finalize returns at once
+        EngineReleaser::Instance().release(std::move(acl_engine_));
+        EngineReleaser::Instance().release(std::move(shard_engine_));
+    }
+
+    void ModelInstanceState::InitVersionSwap()
+    {
+        if (!model_state_->VersionSwap())
+            return;
+        swap_registered_ = model_state_->RegisterSwapInstance(this, acl_engine_, &swap_generation_);
+    }
+
+    void ModelInstanceState::CheckVersionSwap()
+    {
+        if (!swap_registered_)
+            return;
+
+        // model state loads changed file for all instances, engine is taken once every instance has it ready,
+        // swap happens between two executes so requests see old or new engine only
+        auto engine = model_state_->TakeSwapEngine(this, &swap_generation_);
+        if (nullptr == engine)
+        {
+            model_state_->CheckModelFile();
+            return;
+        }
+        std::shared_ptr<AscendCLEngine> old_engine = std::move(acl_engine_);
+        acl_engine_ = engine;
+        // engine counters of new engine start from zero
+        execute_timeout_count_ = 0;
+        if (nullptr != metrics_)
+            metrics_->ResetTotals();
+        LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("instance ") + Name() + " swapped to engine of generation " + 
+            std::to_string(swap_generation_) + " of model file " + model_state_->ModelPath()).c_str());
+        if (model_state_->AsyncUnload())
+            EngineReleaser::Instance().release(std::move(old_engine));
+    }
+
     void ModelInstanceState::FillStringData(std::vector<const char*>* string_ptrs, size_t cnt)
     {
         static const char* empty = "";
@@ -452,7 +790,8 @@ namespace triton::backend::acl
         const uint32_t request_count, std::vector<TRITONBACKEND_Response*>* responses, 
         BackendInputCollector* collector, std::vector<std::string>& input_names, 
         std::map<std::string, std::shared_ptr<AclTensor>>& input_tensors, 
-        std::vector<std::shared_ptr<BackendMemory>>& backend_memorys, bool* cuda_copy)
+        std::vector<std::shared_ptr<BackendMemory>>& backend_memorys, std::vector<std::shared_ptr<void>>& pinned_buffers, 
+        bool* cuda_copy)
     {
         const int max_batch_size = model_state_->MaxBatchSize();
 
@@ -461,6 +800,13 @@ namespace triton::backend::acl
         uint32_t input_count;
         RETURN_IF_ERROR(TRITONBACKEND_RequestInputCount(requests[0], &input_count));
 
+        // names of last call are overwritten in place, so their strings keep capacity
+        size_t name_count = input_count;
+        for (const auto& batch_input : StateForModel()->BatchInputs())
+            name_count += batch_input.TargetNames().size();
+        input_names.resize(name_count);
+        size_t name_index = 0;
+
         for (uint32_t input_idx = 0; input_idx < input_count; input_idx++)
         {
             TRITONBACKEND_Input* input;
@@ -473,14 +819,14 @@ namespace triton::backend::acl
             RETURN_IF_ERROR(TRITONBACKEND_InputProperties(input, &input_name, &input_datatype, 
                 &input_shape, &input_dims_count, nullptr, nullptr));
 
-            input_names.emplace_back(input_name);
-            std::shared_ptr<AclTensor> input_tensor;
-            std::vector<int64_t> batchn_shape;
+            input_names[name_index++].assign(input_name);
+            auto& input_tensor = input_tensors[input_names[name_index - 1]];
+            auto& batchn_shape = scratch_.input_shape;
             // For a ragged input tensor, the tensor shape should be
             // the flatten shape of the whole batch
             if (StateForModel()->IsInputRagged(input_name))
             {
-                batchn_shape = std::vector<int64_t>{0};
+                batchn_shape.assign(1, 0);
                 for (size_t idx = 0; idx < request_count; idx++)
                 {
                     TRITONBACKEND_Input* input;
@@ -498,7 +844,7 @@ namespace triton::backend::acl
             // The shape for the entire input batch, [total_batch_size, ...]
             else 
             {
-                batchn_shape = std::vector<int64_t>(input_shape, input_shape + input_dims_count);
+                batchn_shape.assign(input_shape, input_shape + input_dims_count);
                 if (max_batch_size != 0)
                 {
                     batchn_shape[0] = total_batch_size;
@@ -514,24 +860,31 @@ namespace triton::backend::acl
                 size_t batchn_byte_size;
                 TRITONSERVER_MemoryType memory_type;
                 int64_t memory_type_id;
-                std::vector<std::pair<TRITONSERVER_MemoryType, int64_t>> allowed_input_types;
-                if (Kind() == TRITONSERVER_INSTANCEGROUPKIND_GPU)
+
+                // gather cpu inputs into pinned staging buffer, so h2d copy of engine runs at dma bandwidth
+                std::shared_ptr<void> pinned_buffer;
+                if (Kind() != TRITONSERVER_INSTANCEGROUPKIND_GPU && model_state_->EnablePinnedInput() && 
+                    PinnedHostPool::Instance().enabled())
+                {
+                    int64_t byte_size = GetByteSize(input_datatype, batchn_shape);
+                    if (0 < byte_size)
+                        pinned_buffer = PinnedHostPool::Instance().allocate(byte_size);
+                }
+                if (nullptr != pinned_buffer)
                 {
-                    allowed_input_types = {{TRITONSERVER_MEMORY_GPU, DeviceId()},
-                                           {TRITONSERVER_MEMORY_CPU_PINNED, 0},
-                                           {TRITONSERVER_MEMORY_CPU, 0}};
+                    RETURN_IF_ERROR(collector->ProcessTensor(input_name, static_cast<char*>(pinned_buffer.get()), 
+                        GetByteSize(input_datatype, batchn_shape), pinned_input_types_, &input_buffer,
+                        &batchn_byte_size, &memory_type, &memory_type_id));
+                    pinned_buffers.push_back(pinned_buffer);
                 }
                 else
                 {
-                    allowed_input_types = {{TRITONSERVER_MEMORY_CPU_PINNED, 0}, 
-                                           {TRITONSERVER_MEMORY_CPU, 0}};
+                    RETURN_IF_ERROR(collector->ProcessTensor(input_name, nullptr, 0, allowed_input_types_, &input_buffer,
+                        &batchn_byte_size, &memory_type, &memory_type_id));
                 }
 
-                RETURN_IF_ERROR(collector->ProcessTensor(input_name, nullptr, 0, allowed_input_types, &input_buffer,
-                    &batchn_byte_size, &memory_type, &memory_type_id));
-
-                // Create acl Tensor
-                RETURN_IF_ERROR(CreateTensor(input_name, batchn_shape, input_datatype, batchn_byte_size, 
+                // Create acl Tensor, or rebind the one of last call
+                RETURN_IF_ERROR(BindTensor(input_name, batchn_shape, input_datatype, batchn_byte_size, 
                     memory_type, memory_type_id, input_tensor, (void*)input_buffer));
             }
             else
@@ -544,7 +897,8 @@ namespace triton::backend::acl
                 // <int32_len><bytes><int32_len><bytes>... serialization into a
                 // <bytes><null-terminator><bytes><null-terminator>... serialization
                 // and then initialize 'string_ptrs' to point to each <bytes>.
-                std::vector<const char*> string_ptrs;
+                auto& string_ptrs = scratch_.string_ptrs;
+                string_ptrs.clear();
                 std::shared_ptr<BackendMemory> backend_memory;
                 RETURN_IF_ERROR(SetStringInputTensor(requests, request_count, responses, input_name, 
                     backend_memory, &string_ptrs, cuda_copy));
@@ -558,17 +912,17 @@ namespace triton::backend::acl
                 RETURN_ERROR_IF_TRUE(0 != TensorUtils::setStringTensorContent(input_tensor.get(), string_ptrs.data(), string_ptrs.size()), 
                     TRITONSERVER_ERROR_INTERNAL, std::string("set string tensor ") + input_name + std::string(" content fail"));
             }
-            input_tensors[input_name] = input_tensor;
         }
 
         // Process batch input if any
         for (const auto& batch_input : StateForModel()->BatchInputs())
         {
-            std::vector<int64_t> shape;
+            auto& shape = scratch_.input_shape;
+            shape.clear();
             collector->BatchInputShape(batch_input, &shape);
             for (const auto& input_name : batch_input.TargetNames())
             {
-                input_names.emplace_back(input_name);
+                input_names[name_index++].assign(input_name);
 
                 const char* dst_buffer;
                 size_t dst_buffer_byte_size;
@@ -577,15 +931,25 @@ namespace triton::backend::acl
 
                 // Batch inputs are always created on CPU
                 RESPOND_ALL_AND_SET_NULL_IF_ERROR((*responses), responses->size(),
-                    collector->ProcessBatchInput(batch_input, nullptr, 0, {{TRITONSERVER_MEMORY_CPU, 0}},
+                    collector->ProcessBatchInput(batch_input, nullptr, 0, cpu_input_types_,
                     &dst_buffer, &dst_buffer_byte_size, &dst_memory_type, &dst_memory_type_id));
 
-                // Create acl Tensor
-                std::shared_ptr<AclTensor> input_tensor;
-                RETURN_IF_ERROR(CreateTensor(input_name.c_str(), shape, batch_input.DataType(), 
-                    dst_buffer_byte_size, dst_memory_type, dst_memory_type_id, input_tensor, (void*)dst_buffer));
-                input_tensors[input_name] = input_tensor;
+                // Create acl Tensor, or rebind the one of last call
+                RETURN_IF_ERROR(BindTensor(input_name.c_str(), shape, batch_input.DataType(), 
+                    dst_buffer_byte_size, dst_memory_type, dst_memory_type_id, input_tensors[input_name], 
+                    (void*)dst_buffer));
+            }
+        }
 
+        // drop tensors of inputs not given by this call
+        if (input_tensors.size() > input_names.size())
+        {
+            for (auto iter = input_tensors.begin(); iter != input_tensors.end();)
+            {
+                if (input_names.end() == std::find(input_names.begin(), input_names.end(), iter->first))
+                    iter = input_tensors.erase(iter);
+                else
+                    iter++;
             }
         }
 
@@ -594,13 +958,28 @@ namespace triton::backend::acl
         return nullptr;
     }
 
+    void ModelInstanceState::ReleaseInputTensors(std::map<std::string, std::shared_ptr<AclTensor>>& input_tensors, 
+        std::vector<std::shared_ptr<BackendMemory>>& backend_memorys, std::vector<std::shared_ptr<void>>& pinned_buffers)
+    {
+        // tensors owning data are released, wrappers only referencing request data are kept for next call
+        for (auto& it : input_tensors)
+        {
+            if (nullptr != it.second && it.second->buffer().own_flag)
+                it.second.reset();
+        }
+        backend_memorys.clear();
+        pinned_buffers.clear();
+        return;
+    }
+
     TRITONSERVER_Error* ModelInstanceState::ReadOutputTensor(const std::string& name, std::vector<int64_t>& batchn_shape, 
         TRITONSERVER_DataType& dtype, AclTensor* output_tensor, void** output_buffer, 
-        std::vector<std::vector<char>>& string_buffers, std::vector<size_t>& offsets)
+        std::vector<char>& string_buffer, std::vector<size_t>& offsets)
     {
         // Get output type and shape
         auto type = output_tensor->getTensorDataType();
-        auto shape = output_tensor->shape();
+        // dims are read in place, shape() returns a copy
+        const auto& shape = output_tensor->buffer().dim;
         dtype = ConvertDataType(type);
         if (TRITONSERVER_TYPE_INVALID == dtype)
         {
@@ -615,9 +994,9 @@ namespace triton::backend::acl
             size_t total_length = 0;
             RETURN_ERROR_IF_TRUE(0 != TensorUtils::getStringTensorByteSize(output_tensor, total_length), 
                 TRITONSERVER_ERROR_INTERNAL, std::string("get string tensor size fail"));
-            string_buffers.emplace_back(std::vector<char>(total_length));
-            auto content = string_buffers.back().data();
-            offsets.reserve(element_count + 1);
+            string_buffer.resize(total_length);
+            auto content = string_buffer.data();
+            offsets.resize(element_count + 1);
             RETURN_ERROR_IF_TRUE(0 != TensorUtils::getStringTensorContent(output_tensor, content, total_length, 
                 offsets.data(), element_count), TRITONSERVER_ERROR_INTERNAL, 
                 std::string("get string tensor content fail"));
@@ -796,9 +1175,9 @@ namespace triton::backend::acl
         // Use to hold string output contents
         bool cuda_copy = false;
         auto& model_outputs = StateForModel()->ModelOutputs();
-        auto model_outout_names = StateForModel()->OutputNames();
+        const auto& model_outout_names = StateForModel()->OutputNames();
 
-        std::map<std::string, AclTensor*> output_tensors;
+        auto& output_tensors = execute_scratch_.output_tensors;
         RETURN_IF_ERROR(GetAclModelOutputs(model_outout_names, output_tensors));
         if (output_tensors.size() != model_outputs.size())
         {
@@ -806,19 +1185,19 @@ namespace triton::backend::acl
                 ("Retrieved output count is not equal to expected count.")));
         }
 
-        std::vector<std::vector<char>> string_buffers;
         auto model_outputs_it = model_outputs.begin();
         for (size_t idx = 0; idx < model_outputs.size(); idx++, model_outputs_it++)
         {
             AclTensor* output_tensor = nullptr;
             const std::string& name = model_outputs_it->first;
             auto& output_tensor_pair = model_outputs_it->second;
-            if (output_tensors.end() == output_tensors.find(name))
+            auto output_iter = output_tensors.find(name);
+            if (output_tensors.end() == output_iter)
             {
                 RETURN_IF_ERROR(TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INTERNAL,
                     (std::string("output tensor '") + name + "' is not found").c_str()));
             }
-            output_tensor = output_tensors[name];
+            output_tensor = output_iter->second;
             void* device_ptr = (void*)output_tensor->devicePtr();
             void* host_ptr = output_tensor->host<void>();
             if (nullptr == host_ptr && nullptr == device_ptr)
@@ -827,23 +1206,25 @@ namespace triton::backend::acl
                     (std::string("output tensor '") + name + "' host/device data both is nullptr").c_str()));
             }
 
-            const auto memory_type = (nullptr == device_ptr) ? TRITONSERVER_MEMORY_CPU : TRITONSERVER_MEMORY_GPU;
+            const auto host_memory_type = output_tensor->isHostPinned() ? TRITONSERVER_MEMORY_CPU_PINNED : TRITONSERVER_MEMORY_CPU;
+            const auto memory_type = (nullptr == device_ptr) ? host_memory_type : TRITONSERVER_MEMORY_GPU;
             const auto memory_id = (nullptr == device_ptr) ? 0 : output_tensor->deviceId();
             const BatchOutput* batch_output = StateForModel()->FindBatchOutput(name);
             if (batch_output == nullptr)
             {
-                std::vector<int64_t> batchn_shape;
+                auto& batchn_shape = execute_scratch_.output_shape;
+                batchn_shape.clear();
                 TRITONSERVER_DataType dtype;
                 void* output_buffer;
-                std::vector<std::vector<char>> string_buffers;
-                std::vector<size_t> offsets;
-                RETURN_IF_ERROR(ReadOutputTensor(name, batchn_shape, dtype, output_tensor, &output_buffer, string_buffers, offsets));
+                auto& string_buffer = execute_scratch_.string_buffer;
+                auto& offsets = execute_scratch_.offsets;
+                RETURN_IF_ERROR(ReadOutputTensor(name, batchn_shape, dtype, output_tensor, &output_buffer, string_buffer, offsets));
 
                 if (output_tensor_pair.first != -1)
                 {
                     if (dtype == TRITONSERVER_TYPE_BYTES)
                     {
-                        auto content = string_buffers.back().data();
+                        auto content = string_buffer.data();
                         cuda_copy |= SetStringOutputBuffer(name, content, offsets.data(), &batchn_shape, requests,
                             request_count, responses);
                     }
@@ -856,29 +1237,26 @@ namespace triton::backend::acl
 
                 if (output_tensor_pair.second != -1)
                 {
-                    std::vector<TRITONBACKEND_State*> states;
                     if (dtype == TRITONSERVER_TYPE_BYTES)
                     {
-                        auto content = string_buffers.back().data();
+                        auto content = string_buffer.data();
                         cuda_copy |= SetStringStateBuffer(name, content, offsets.data(), &batchn_shape, requests,
                             request_count, responses);
                     }
                     else
                     {
-                        states = responder.ProcessStateTensor(name, dtype, batchn_shape, reinterpret_cast<char*>(output_buffer),
-                            memory_type, memory_id);
-                    }
-
-                    // Update the states
-                    for (auto& state : states)
-                    {
-                        RETURN_IF_ERROR(TRITONBACKEND_StateUpdate(state));
+                        // Update the states, state list is returned by responder only for state outputs
+                        for (auto& state : responder.ProcessStateTensor(name, dtype, batchn_shape, 
+                            reinterpret_cast<char*>(output_buffer), memory_type, memory_id))
+                        {
+                            RETURN_IF_ERROR(TRITONBACKEND_StateUpdate(state));
+                        }
                     }
                 }
             }
             else
             {
-                char* output_buffer = (memory_type == TRITONSERVER_MEMORY_CPU) ? (char*)host_ptr : (char*)device_ptr;
+                char* output_buffer = (memory_type != TRITONSERVER_MEMORY_GPU) ? (char*)host_ptr : (char*)device_ptr;
                 responder.ProcessBatchOutput(name, *batch_output, output_buffer, memory_type, memory_id);
             }
         }
@@ -895,20 +1273,202 @@ namespace triton::backend::acl
         return nullptr;
     }
 
+    void ModelInstanceState::PrepareSubBatch(SubBatchContext* sub_batch)
+    {
+        // create responses, error of each request is sent with its response
+        sub_batch->responses.clear();
+        sub_batch->responses.reserve(sub_batch->request_count);
+        for (size_t i = 0; i < sub_batch->request_count; i++)
+        {
+            TRITONBACKEND_Response* response;
+            auto err = TRITONBACKEND_ResponseNew(&response, sub_batch->requests[i]);
+            if (err == nullptr)
+            {
+                sub_batch->responses.emplace_back(response);
+            }
+            else
+            {
+                sub_batch->responses.emplace_back(nullptr);
+                LOG_MESSAGE(TRITONSERVER_LOG_ERROR, "Fail to create response");
+                TRITONSERVER_ErrorDelete(err);
+            }
+        }
+
+        // collect inputs of sub batch, collector keeps gathered buffers until sub batch finish
+        bool cuda_copy = false;
+        sub_batch->collector.emplace(sub_batch->requests, sub_batch->request_count, &sub_batch->responses, 
+            model_state_->TritonMemoryManager(), model_state_->EnablePinnedInput(), CudaStream(), nullptr, nullptr, 0, 
+            HostPolicyName().c_str());
+        RESPOND_ALL_AND_SET_TRUE_IF_ERROR(sub_batch->responses, sub_batch->request_count, 
+            sub_batch->all_response_failed, SetInputTensors(sub_batch->batch_size, sub_batch->requests, 
+            sub_batch->request_count, &sub_batch->responses, &sub_batch->collector.value(), sub_batch->input_names, 
+            sub_batch->input_tensors, sub_batch->backend_memorys, sub_batch->pinned_buffers, &cuda_copy));
+
+        if (!sub_batch->all_response_failed && sub_batch->input_names.size() != sub_batch->input_tensors.size())
+        {
+            RESPOND_ALL_AND_SET_TRUE_IF_ERROR(sub_batch->responses, sub_batch->request_count, 
+                sub_batch->all_response_failed, TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INTERNAL, 
+                std::string(Name() + " SetInputTensors get input names number is " + 
+                std::to_string(sub_batch->input_names.size()) + ", but input tensors number is " + 
+                std::to_string(sub_batch->input_tensors.size())).c_str()));
+        }
+
+        #ifdef TRITON_ENABLE_GPU
+        if (cuda_copy)
+        {
+            cudaStreamSynchronize(CudaStream());
+        }
+        #endif
+        return;
+    }
+
+    void ModelInstanceState::ExecuteSubBatch(SubBatchContext* sub_batch, uint64_t exec_start_ns)
+    {
+        #ifndef NDEBUG
+        const uint64_t alloc_count = ThreadAllocCount();
+        #endif
+
+        uint64_t compute_start_ns = 0;
+        SET_TIMESTAMP(compute_start_ns);
+
+        if (!sub_batch->all_response_failed)
+        {
+            RESPOND_ALL_AND_SET_TRUE_IF_ERROR(sub_batch->responses, sub_batch->request_count, 
+                sub_batch->all_response_failed, RunAclModel(sub_batch->input_names, sub_batch->input_tensors));
+        }
+
+        uint64_t compute_end_ns = 0;
+        SET_TIMESTAMP(compute_end_ns);
+
+        if (!sub_batch->all_response_failed)
+        {
+            RESPOND_ALL_AND_SET_TRUE_IF_ERROR(sub_batch->responses, sub_batch->request_count, 
+                sub_batch->all_response_failed, ReadOutputTensors(sub_batch->batch_size, sub_batch->requests, 
+                sub_batch->request_count, &sub_batch->responses));
+        }
+
+        uint64_t exec_end_ns = 0;
+        SET_TIMESTAMP(exec_end_ns);
+
+        // send responses of sub batch without waiting later sub batches
+        for (auto& response : sub_batch->responses)
+        {
+            if (response != nullptr)
+            {
+                LOG_IF_ERROR(TRITONBACKEND_ResponseSend(response, TRITONSERVER_RESPONSE_COMPLETE_FINAL, nullptr),
+                    "failed to send acl backend response");
+            }
+        }
+
+        for (uint32_t r = 0; r < sub_batch->request_count; ++r)
+        {
+            auto& request = sub_batch->requests[r];
+            LOG_IF_ERROR(TRITONBACKEND_ModelInstanceReportStatistics(TritonModelInstance(), request, 
+                (sub_batch->responses[r] != nullptr) /* success */, exec_start_ns, compute_start_ns, compute_end_ns, 
+                exec_end_ns), "failed reporting request statistics");
+
+            LOG_IF_ERROR(TRITONBACKEND_RequestRelease(request, TRITONSERVER_REQUEST_RELEASE_ALL),
+                "failed releasing request");
+        }
+
+        if (!sub_batch->all_response_failed)
+        {
+            LOG_IF_ERROR(TRITONBACKEND_ModelInstanceReportBatchStatistics(TritonModelInstance(), sub_batch->batch_size, 
+                exec_start_ns, compute_start_ns, compute_end_ns, exec_end_ns), 
+                "failed reporting batch request statistics");
+        }
+
+        // release gathered input buffers as soon as sub batch finish, containers are kept for next call
+        ReleaseInputTensors(sub_batch->input_tensors, sub_batch->backend_memorys, sub_batch->pinned_buffers);
+        sub_batch->collector.reset();
+        #ifndef NDEBUG
+        // read by instance thread after sub batch result is waited
+        pipeline_alloc_count_ += ThreadAllocCount() - alloc_count;
+        #endif
+        return;
+    }
+
+    void ModelInstanceState::ProcessRequestsPipelined(TRITONBACKEND_Request** requests, const uint32_t request_count,
+        const std::vector<size_t>& request_batch_sizes, uint64_t exec_start_ns)
+    {
+        // per request state is double buffered, one slot is prepared by instance thread while pipeline 
+        // worker executes the other, slot is reused after worker finished its previous sub batch
+        auto& sub_batches = scratch_.sub_batches;
+        while (sub_batches.size() < kPipelineSlots)
+            sub_batches.emplace_back(new SubBatchContext());
+        auto& results = scratch_.sub_batch_results;
+        results.resize(kPipelineSlots);
+
+        // split requests into sub batches, a request is never split
+        const size_t sub_batch_size = model_state_->PipelineSubBatchSize();
+        size_t sub_batch_count = 0;
+        uint32_t first = 0;
+        while (first < request_count)
+        {
+            uint32_t count = 0;
+            size_t batch_size = 0;
+            while (first + count < request_count && 
+                (0 == count || batch_size + request_batch_sizes[first + count] <= sub_batch_size))
+            {
+                batch_size += request_batch_sizes[first + count];
+                count++;
+            }
+
+            size_t slot = sub_batch_count % kPipelineSlots;
+            if (results[slot].valid())
+                results[slot].wait();
+            SubBatchContext* context = sub_batches[slot].get();
+            context->requests = requests + first;
+            context->request_count = count;
+            context->batch_size = batch_size;
+            context->all_response_failed = false;
+
+            // inputs of next sub batch are collected while pipeline worker runs current one
+            PrepareSubBatch(context);
+            results[slot] = pipeline_pool_->enqueue([this, context, exec_start_ns]() {
+                ExecuteSubBatch(context, exec_start_ns);
+            });
+            first += count;
+            sub_batch_count++;
+        }
+
+        // engine is reused by next call, wait all sub batches finish
+        for (auto& result : results)
+        {
+            if (result.valid())
+                result.wait();
+        }
+
+        LOG_VERBOSE_MESSAGE(std::string("TRITONBACKEND_ModelExecute: Running ") + 
+            Name() + " with " + std::to_string(request_count) + " requests in " + 
+            std::to_string(sub_batch_count) + " sub batches end");
+        return;
+    }
+
     void ModelInstanceState::ProcessRequests(TRITONBACKEND_Request** requests, const uint32_t request_count)
     {
-        LOG_MESSAGE(TRITONSERVER_LOG_VERBOSE, (std::string("TRITONBACKEND_ModelExecute: Running ") + 
-            Name() + " with " + std::to_string(request_count) + " requests begin").c_str());
+        LOG_VERBOSE_MESSAGE(std::string("TRITONBACKEND_ModelExecute: Running ") + 
+            Name() + " with " + std::to_string(request_count) + " requests begin");
 
         uint64_t exec_start_ns = 0;
         SET_TIMESTAMP(exec_start_ns);
 
+        // engine of changed model file is swapped in before this batch
+        CheckVersionSwap();
+
+        #ifndef NDEBUG
+        const size_t scratch_footprint = ScratchFootprint();
+        const uint64_t alloc_count = ThreadAllocCount();
+        #endif
+
         const int max_batch_size = model_state_->MaxBatchSize();
 
         // For each request collect the total batch size for this inference
         // execution. The batch-size, number of inputs, and size of each
         // input has already been checked so don't need to do that here.
         size_t total_batch_size = 0;
+        auto& request_batch_sizes = scratch_.request_batch_sizes;
+        request_batch_sizes.assign(request_count, 1);
         for (size_t i = 0; i < request_count; i++)
         {
             // If we get a nullptr request then something is badly wrong. Fail
@@ -931,6 +1491,7 @@ namespace triton::backend::acl
                     const int64_t* shape;
                     err = TRITONBACKEND_InputProperties(input, nullptr, nullptr, &shape, nullptr, nullptr, nullptr);
                     total_batch_size += shape[0];
+                    request_batch_sizes[i] = shape[0];
                 }
                 if (err != nullptr)
                 {
@@ -963,6 +1524,19 @@ namespace triton::backend::acl
             return;
         }
 
+        // Large batch is split into sub batches on request boundary, so
+        // responses of earlier sub batch are sent while later ones run.
+        const int sub_batch_size = model_state_->PipelineSubBatchSize();
+        if (nullptr != pipeline_pool_ && max_batch_size > 0 && request_count > 1 && 
+            total_batch_size > (size_t)sub_batch_size)
+        {
+            ProcessRequestsPipelined(requests, request_count, request_batch_sizes, exec_start_ns);
+            #ifndef NDEBUG
+            CheckScratchGrowth(scratch_footprint, ThreadAllocCount() - alloc_count);
+            #endif
+            return;
+        }
+
         // At this point we are committed to running inference with all
         // 'requests'. Create a response for each request. During input
         // processing if there is an error with any request that error will
@@ -974,7 +1548,8 @@ namespace triton::backend::acl
         // need the outputs for a request that has an error, we do need to
         // know the size of those outputs associated with the request so we
         // can skip them in the output tensors).
-        std::vector<TRITONBACKEND_Response*> responses;
+        auto& responses = scratch_.responses;
+        responses.clear();
         responses.reserve(request_count);
         bool all_response_failed = false;
 
@@ -994,21 +1569,25 @@ namespace triton::backend::acl
             }
         }
 
-        LOG_MESSAGE(TRITONSERVER_LOG_VERBOSE, (std::string("TRITONBACKEND_ModelExecute: Running ") + 
-            Name() + " with " + std::to_string(request_count) + " requests SetInputTensors").c_str());
+        LOG_VERBOSE_MESSAGE(std::string("TRITONBACKEND_ModelExecute: Running ") + 
+            Name() + " with " + std::to_string(request_count) + " requests SetInputTensors");
 
-        std::vector<std::shared_ptr<BackendMemory>> backend_memorys;
-        std::map<std::string, std::shared_ptr<AclTensor>> input_tensors;
-        std::vector<std::string> input_names;
+        auto& backend_memorys = scratch_.backend_memorys;
+        auto& pinned_buffers = scratch_.pinned_buffers;
+        auto& input_tensors = scratch_.input_tensors;
+        auto& input_names = scratch_.input_names;
         bool cuda_copy = false;
-        BackendInputCollector collector(requests, request_count, &responses, model_state_->TritonMemoryManager(), 
+        auto& collector = scratch_.collector;
+        collector.emplace(requests, request_count, &responses, model_state_->TritonMemoryManager(), 
             model_state_->EnablePinnedInput(), CudaStream(), nullptr, nullptr, 0, HostPolicyName().c_str());
         RESPOND_ALL_AND_SET_TRUE_IF_ERROR(responses, request_count, all_response_failed, 
-            SetInputTensors(total_batch_size, requests, request_count, &responses, &collector, 
-            input_names, input_tensors, backend_memorys, &cuda_copy));
+            SetInputTensors(total_batch_size, requests, request_count, &responses, &collector.value(), 
+            input_names, input_tensors, backend_memorys, pinned_buffers, &cuda_copy));
 
-        if (input_names.size() != input_tensors.size())
+        if (!all_response_failed && input_names.size() != input_tensors.size())
         {
+            ReleaseInputTensors(input_tensors, backend_memorys, pinned_buffers);
+            collector.reset();
             RequestsRespondWithError(requests, request_count, TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INTERNAL, 
                 std::string(Name() + " SetInputTensors get input names number is " + std::to_string(input_names.size()) + 
                 ", but input tensors number is " + std::to_string(input_tensors.size())).c_str()));
@@ -1023,8 +1602,8 @@ namespace triton::backend::acl
         }
         #endif
 
-        LOG_MESSAGE(TRITONSERVER_LOG_VERBOSE, (std::string("TRITONBACKEND_ModelExecute: Running ") + 
-            Name() + " with " + std::to_string(request_count) + " requests RunAclModel").c_str());
+        LOG_VERBOSE_MESSAGE(std::string("TRITONBACKEND_ModelExecute: Running ") + 
+            Name() + " with " + std::to_string(request_count) + " requests RunAclModel");
 
         uint64_t compute_start_ns = 0;
         SET_TIMESTAMP(compute_start_ns);
@@ -1038,8 +1617,8 @@ namespace triton::backend::acl
         uint64_t compute_end_ns = 0;
         SET_TIMESTAMP(compute_end_ns);
 
-        LOG_MESSAGE(TRITONSERVER_LOG_VERBOSE, (std::string("TRITONBACKEND_ModelExecute: Running ") + 
-            Name() + " with " + std::to_string(request_count) + " requests ReadOutputTensors").c_str());
+        LOG_VERBOSE_MESSAGE(std::string("TRITONBACKEND_ModelExecute: Running ") + 
+            Name() + " with " + std::to_string(request_count) + " requests ReadOutputTensors");
 
         if (!all_response_failed)
         {
@@ -1083,8 +1662,14 @@ namespace triton::backend::acl
                 "failed reporting batch request statistics");
         }
 
-        LOG_MESSAGE(TRITONSERVER_LOG_VERBOSE, (std::string("TRITONBACKEND_ModelExecute: Running ") + 
-            Name() + " with " + std::to_string(request_count) + " requests end").c_str());
+        ReleaseInputTensors(input_tensors, backend_memorys, pinned_buffers);
+        collector.reset();
+        #ifndef NDEBUG
+        CheckScratchGrowth(scratch_footprint, ThreadAllocCount() - alloc_count);
+        #endif
+
+        LOG_VERBOSE_MESSAGE(std::string("TRITONBACKEND_ModelExecute: Running ") + 
+            Name() + " with " + std::to_string(request_count) + " requests end");
         return;
     }
 
@@ -24,14 +24,21 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
+#include <optional>
 #include "triton/backend/backend_common.h"
 #include "triton/backend/backend_input_collector.h"
 #include "triton/backend/backend_memory.h"
 #include "triton/backend/backend_output_responder.h"
 #include "triton/backend/backend_model_instance.h"
 #include "acl_engine/acl_engine.h"
+#include "acl_engine/shard_engine.h"
+#include "acl_engine/thread_pool.h"
+#include "acl_engine/pinned_allocator.h"
+#include "acl_engine/numa_allocator.h"
+#include "acl_engine/engine_releaser.h"
 #include "model_state.h"
 #include "acl_utils.h"
+#include "acl_metrics.h"
 
 using namespace ACL_ENGINE;
 
@@ -42,21 +49,96 @@ namespace triton::backend::acl
     {
     public:
         static TRITONSERVER_Error* Create(ModelState* model_state, TRITONBACKEND_ModelInstance* triton_model_instance, ModelInstanceState** state);
-        virtual ~ModelInstanceState() = default;
+        virtual ~ModelInstanceState();
         // Get the state of the model that corresponds to this instance.
         ModelState* StateForModel() const { return model_state_; }
         void ProcessRequests(TRITONBACKEND_Request** requests, const uint32_t request_count);
 
+    private:
+        // requests of one pipelined sub batch, resources live until its responses are sent
+        typedef struct SubBatchContext
+        {
+            TRITONBACKEND_Request**                               requests = nullptr;
+            uint32_t                                              request_count = 0;
+            size_t                                                batch_size = 0;
+            bool                                                  all_response_failed = false;
+            std::vector<TRITONBACKEND_Response*>                  responses;
+            std::vector<std::shared_ptr<BackendMemory>>           backend_memorys;
+            std::vector<std::shared_ptr<void>>                    pinned_buffers;
+            std::map<std::string, std::shared_ptr<AclTensor>>     input_tensors;
+            std::vector<std::string>                              input_names;
+            // collector is built in place for each sub batch, it keeps gathered buffers until sub batch finish
+            std::optional<BackendInputCollector>                  collector;
+        } SubBatchContext;
+
+        // containers of request processing, cleared after each call but keep their capacity, 
+        // so steady state requests reuse them instead of allocating again. Each stage has its own
+        // scratch: request scratch is used by instance thread collecting inputs, execute scratch by 
+        // thread running engine and sending responses, pipeline worker when sub batches are pipelined
+        typedef struct RequestScratch
+        {
+            std::vector<TRITONBACKEND_Response*>                  responses;
+            std::vector<size_t>                                   request_batch_sizes;
+            std::vector<std::string>                              input_names;
+            // input tensors are kept by name, wrapper tensor is rebound to data of next call
+            std::map<std::string, std::shared_ptr<AclTensor>>     input_tensors;
+            std::vector<std::shared_ptr<BackendMemory>>           backend_memorys;
+            std::vector<std::shared_ptr<void>>                    pinned_buffers;
+            std::vector<int64_t>                                  input_shape;
+            std::vector<const char*>                              string_ptrs;
+            std::optional<BackendInputCollector>                  collector;
+            std::vector<std::unique_ptr<SubBatchContext>>         sub_batches;
+            std::vector<std::future<void>>                        sub_batch_results;
+        } RequestScratch;
+
+        typedef struct ExecuteScratch
+        {
+            std::map<std::string, AclTensor*>                     prepared_tensors;
+            std::map<std::string, AclTensor*>                     output_tensors;
+            std::vector<int64_t>                                  output_shape;
+            std::vector<char>                                     string_buffer;
+            std::vector<size_t>                                   offsets;
+            std::map<int, DeviceMemoryInfo>                       device_infos;
+            std::map<int, EngineMemoryStats>                      memory_stats;
+            std::map<int, NumaNodeStats>                          numa_stats;
+        } ExecuteScratch;
+
+        // handles of backend wide gauges refreshed by instance, labels are built once per device or pool
+        typedef struct DeviceGauges
+        {
+            TRITONSERVER_Metric*                                  total = nullptr;
+            TRITONSERVER_Metric*                                  used = nullptr;
+            TRITONSERVER_Metric*                                  allocated = nullptr;
+            TRITONSERVER_Metric*                                  cached = nullptr;
+            TRITONSERVER_Metric*                                  peak = nullptr;
+        } DeviceGauges;
+
+        typedef struct PoolGauges
+        {
+            TRITONSERVER_Metric*                                  in_use = nullptr;
+            TRITONSERVER_Metric*                                  cached = nullptr;
+        } PoolGauges;
+
     private:
         ModelInstanceState(ModelState* model_state, TRITONBACKEND_ModelInstance* triton_model_instance);
-        TRITONSERVER_Error* DetermineModelPath(const std::string& model_dir, std::string* model_path, std::string* config_path);
         TRITONSERVER_Error* CreateTensor(const char* input_name, const std::vector<int64_t> shape, TRITONSERVER_DataType triton_dtype, 
             int batchn_byte_size, TRITONSERVER_MemoryType mem_type, int mem_type_id, std::shared_ptr<AclTensor>& tensor,
             void* data = nullptr, bool clone_flag = false);
+        TRITONSERVER_Error* BindTensor(const char* input_name, const std::vector<int64_t>& shape, TRITONSERVER_DataType triton_dtype, 
+            int batchn_byte_size, TRITONSERVER_MemoryType mem_type, int mem_type_id, std::shared_ptr<AclTensor>& tensor, void* data);
         TRITONSERVER_Error* CreateStringTensor(const char* input_name, const std::vector<int64_t> shape, TRITONSERVER_DataType triton_dtype, 
             TRITONSERVER_MemoryType mem_type, int mem_type_id, std::shared_ptr<AclTensor>& tensor);
         TRITONSERVER_Error* RunAclModel(std::vector<std::string>& input_names, std::map<std::string, std::shared_ptr<AclTensor>>& input_tensors);
-        TRITONSERVER_Error* GetAclModelOutputs(std::vector<std::string>& output_names, std::map<std::string, AclTensor*>& output_tensors);
+        bool UpdateExecuteTimeoutCount(uint64_t timeout_count);
+        void UpdateMemoryMetrics();
+        void SetMemoryMetrics(InstanceMetrics* metrics, const EngineMemoryStats& memory_stats);
+        DeviceGauges& GetDeviceGauges(int device_id);
+        PoolGauges& GetPoolGauges(const char* pool, int node);
+        TRITONSERVER_Error* GetAclModelOutputs(const std::vector<std::string>& output_names, std::map<std::string, AclTensor*>& output_tensors);
+        size_t ScratchFootprint();
+        void CheckScratchGrowth(size_t last_footprint, uint64_t alloc_count);
+        void InitVersionSwap();
+        void CheckVersionSwap();
 
         // input tensors funcs
         void FillStringData(std::vector<const char*>* string_ptrs, size_t cnt);
@@ -70,7 +152,16 @@ namespace triton::backend::acl
             const uint32_t request_count, std::vector<TRITONBACKEND_Response*>* responses, 
             BackendInputCollector* collector, std::vector<std::string>& input_names, 
             std::map<std::string, std::shared_ptr<AclTensor>>& input_tensors, 
-            std::vector<std::shared_ptr<BackendMemory>>& backend_memorys, bool* cuda_copy);
+            std::vector<std::shared_ptr<BackendMemory>>& backend_memorys, std::vector<std::shared_ptr<void>>& pinned_buffers, 
+            bool* cuda_copy);
+        void ReleaseInputTensors(std::map<std::string, std::shared_ptr<AclTensor>>& input_tensors, 
+            std::vector<std::shared_ptr<BackendMemory>>& backend_memorys, std::vector<std::shared_ptr<void>>& pinned_buffers);
+
+        // pipelined sub batch funcs
+        void ProcessRequestsPipelined(TRITONBACKEND_Request** requests, const uint32_t request_count,
+            const std::vector<size_t>& request_batch_sizes, uint64_t exec_start_ns);
+        void PrepareSubBatch(SubBatchContext* sub_batch);
+        void ExecuteSubBatch(SubBatchContext* sub_batch, uint64_t exec_start_ns);
 
         // output tensors funcs
         bool SetStringBuffer(const std::string& name, const char* content, const size_t* offsets,
@@ -84,13 +175,36 @@ namespace triton::backend::acl
             std::vector<TRITONBACKEND_Response*>* responses);
         TRITONSERVER_Error* ReadOutputTensor(const std::string& name, std::vector<int64_t>& batchn_shape, 
             TRITONSERVER_DataType& dtype, AclTensor* output_tensor, void** output_buffer, 
-            std::vector<std::vector<char>>& string_buffers, std::vector<size_t>& offsets);
+            std::vector<char>& string_buffer, std::vector<size_t>& offsets);
         TRITONSERVER_Error* ReadOutputTensors(size_t total_batch_size, TRITONBACKEND_Request** requests, 
             const uint32_t request_count, std::vector<TRITONBACKEND_Response*>* responses);
 
     private:
         ModelState*                                         model_state_;
         std::shared_ptr<AscendCLEngine>                     acl_engine_;
+        std::shared_ptr<ShardEngine>                        shard_engine_;
+        std::unique_ptr<InstanceMetrics>                    metrics_;
+        // data parallel instance reports memory of other devices than metrics_ device in their own series
+        std::map<int, std::unique_ptr<InstanceMetrics>>     shard_metrics_;
+        // single worker runs execute and responses of sub batch while next sub batch inputs are collected
+        static constexpr size_t                             kPipelineSlots = 2;
+        std::unique_ptr<ThreadPool>                         pipeline_pool_;
+        uint64_t                                            execute_timeout_count_ = 0;
+        RequestScratch                                      scratch_;
+        ExecuteScratch                                      execute_scratch_;
+        // debug builds count calls which grow the scratch, stays unchanged once requests are in steady state,
+        // and allocations made by each call on instance thread and pipeline worker
+        uint64_t                                            scratch_grow_count_ = 0;
+        uint64_t                                            pipeline_alloc_count_ = 0;
+        // memory types inputs are collected to, fixed by instance kind
+        std::vector<std::pair<TRITONSERVER_MemoryType, int64_t>>    allowed_input_types_;
+        std::vector<std::pair<TRITONSERVER_MemoryType, int64_t>>    pinned_input_types_;
+        std::vector<std::pair<TRITONSERVER_MemoryType, int64_t>>    cpu_input_types_;
+        std::map<int, DeviceGauges>                         device_gauges_;
+        std::map<std::pair<std::string, int>, PoolGauges>   pool_gauges_;
+        // instance takes part in version swap of model state, and swap generation its engine is of
+        bool                                                swap_registered_ = false;
+        uint64_t                                            swap_generation_ = 0;
     };
 
 } // namespace triton::backend::acl
@@ -24,7 +24,13 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <fstream>
+#include <algorithm>
 #include "model_state.h"
+#include "acl_engine/pinned_allocator.h"
+#include "acl_engine/load_scheduler.h"
+#include "acl_engine/zstd_decoder.h"
+#include "acl_engine/capacity_planner.h"
+#include "acl_engine/engine_releaser.h"
 
 namespace triton::backend::acl
 {
@@ -134,6 +140,31 @@ namespace triton::backend::acl
         return nullptr;
     }
 
+    TRITONSERVER_Error* ModelState::ParseIntListParameter(triton::common::TritonJson::Value& params, const std::string& mkey, 
+        std::vector<int>& value)
+    {
+        std::string value_str;
+        RETURN_IF_ERROR(GetParameterValue(params, mkey, &value_str));
+        value.clear();
+        size_t start = 0;
+        while (start <= value_str.size())
+        {
+            size_t end = value_str.find(',', start);
+            if (std::string::npos == end)
+                end = value_str.size();
+            std::string item_str = value_str.substr(start, end - start);
+            if ("" != item_str)
+            {
+                int item = 0;
+                RETURN_IF_ERROR(ParseIntValue(item_str, &item));
+                value.push_back(item);
+            }
+            start = end + 1;
+        }
+
+        return nullptr;
+    }
+
     TRITONSERVER_Error* ModelState::ParseStrParameter(triton::common::TritonJson::Value& params, const std::string& mkey, std::string& value)
     {
         RETURN_IF_ERROR(GetParameterValue(params, mkey, &value));
@@ -287,15 +318,1017 @@ namespace triton::backend::acl
             acl_config_.config_file = config_file;
             LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("config_file is ") + 
                 config_file + " for model '" + Name() + "'").c_str());
+
+            // sched_priority, used by device scheduler with priority policy
+            int sched_priority = 0;
+            err = ParseIntParameter(params, "sched_priority", &sched_priority);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            acl_config_.sched_priority = sched_priority;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("sched_priority is ") + 
+                std::to_string(sched_priority) + " for model '" + Name() + "'").c_str());
+
+            // sched_weight, used by device scheduler with fair_share policy
+            int sched_weight = 1;
+            err = ParseIntParameter(params, "sched_weight", &sched_weight);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            if (0 >= sched_weight)
+            {
+                return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, 
+                    (std::string("sched_weight should be positive for model '") + Name() + "'").c_str());
+            }
+            acl_config_.sched_weight = sched_weight;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("sched_weight is ") + 
+                std::to_string(sched_weight) + " for model '" + Name() + "'").c_str());
+
+            // execute_timeout_ms, 0 means wait model execute forever
+            int execute_timeout_ms = 0;
+            err = ParseIntParameter(params, "execute_timeout_ms", &execute_timeout_ms);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            if (0 > execute_timeout_ms)
+            {
+                return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, 
+                    (std::string("execute_timeout_ms should not be negative for model '") + Name() + "'").c_str());
+            }
+            acl_config_.execute_timeout_ms = execute_timeout_ms;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("execute_timeout_ms is ") + 
+                std::to_string(execute_timeout_ms) + " for model '" + Name() + "'").c_str());
+
+            // sync_mode, how engine wait stream finish: blocking/spin/yield
+            std::string sync_mode = "blocking";
+            err = ParseStrParameter(params, "sync_mode", sync_mode);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            if ("blocking" != sync_mode && "spin" != sync_mode && "yield" != sync_mode)
+            {
+                return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, 
+                    (std::string("sync_mode should be blocking/spin/yield for model '") + Name() + "'").c_str());
+            }
+            acl_config_.sync_mode = sync_mode;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("sync_mode is ") + 
+                sync_mode + " for model '" + Name() + "'").c_str());
+
+            // sync_cpu_cores, such as "2,3", polling instance (each shard of data parallel instance) waits pinned to one of them
+            std::vector<int> sync_cpu_cores;
+            err = ParseIntListParameter(params, "sync_cpu_cores", sync_cpu_cores);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            sync_cpu_cores_ = sync_cpu_cores;
+            std::string cpu_cores_str;
+            for (auto cpu_core : sync_cpu_cores)
+                cpu_cores_str += ("" == cpu_cores_str ? "" : ",") + std::to_string(cpu_core);
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("sync_cpu_cores is '") + 
+                cpu_cores_str + "' for model '" + Name() + "'").c_str());
+
+            // enable_graph_capture
+            bool enable_graph_capture = false;
+            err = ParseBoolParameter(params, "enable_graph_capture", &enable_graph_capture);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            acl_config_.enable_graph_capture = enable_graph_capture;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("enable_graph_capture is ") + 
+                std::to_string(enable_graph_capture) + " for model '" + Name() + "'").c_str());
+
+            // host_numa_nodes, such as "0,0,1,1", numa node of each device id, host output buffers are bound to it
+            std::vector<int> host_numa_nodes;
+            err = ParseIntListParameter(params, "host_numa_nodes", host_numa_nodes);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            acl_config_.host_numa_nodes = host_numa_nodes;
+            std::string numa_nodes_str;
+            for (auto numa_node : host_numa_nodes)
+                numa_nodes_str += ("" == numa_nodes_str ? "" : ",") + std::to_string(numa_node);
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("host_numa_nodes is '") + 
+                numa_nodes_str + "' for model '" + Name() + "'").c_str());
+
+            // host_huge_pages, back host output buffers with 1GB/2MB huge pages if available
+            bool host_huge_pages = false;
+            err = ParseBoolParameter(params, "host_huge_pages", &host_huge_pages);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            acl_config_.host_huge_pages = host_huge_pages;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("host_huge_pages is ") + 
+                std::to_string(host_huge_pages) + " for model '" + Name() + "'").c_str());
+
+            // workspace_group, models of same group on a device share one work memory and never execute concurrently
+            std::string workspace_group = "";
+            err = ParseStrParameter(params, "workspace_group", workspace_group);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            acl_config_.workspace_group = workspace_group;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("workspace_group is '") + 
+                workspace_group + "' for model '" + Name() + "'").c_str());
+
+            // model_load_mode, mmap: om file is mapped while acl loads model, file: acl reads om file itself
+            std::string model_load_mode = "mmap";
+            err = ParseStrParameter(params, "model_load_mode", model_load_mode);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            if ("mmap" != model_load_mode && "file" != model_load_mode)
+            {
+                return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, 
+                    (std::string("model_load_mode should be mmap/file for model '") + Name() + "'").c_str());
+            }
+            acl_config_.model_load_mode = model_load_mode;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("model_load_mode is ") + 
+                model_load_mode + " for model '" + Name() + "'").c_str());
+
+            // model_map_populate, read in all pages of mapped om file before acl loads model
+            bool model_map_populate = false;
+            err = ParseBoolParameter(params, "model_map_populate", &model_map_populate);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            acl_config_.model_map_populate = model_map_populate;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("model_map_populate is ") + 
+                std::to_string(model_map_populate) + " for model '" + Name() + "'").c_str());
+
+            // model_prefault_threads, threads fault in pages of mapped om file in parallel
+            int model_prefault_threads = 0;
+            err = ParseIntParameter(params, "model_prefault_threads", &model_prefault_threads);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            if (0 > model_prefault_threads)
+            {
+                return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, 
+                    (std::string("model_prefault_threads should not be negative for model '") + Name() + "'").c_str());
+            }
+            acl_config_.model_prefault_threads = model_prefault_threads;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("model_prefault_threads is ") + 
+                std::to_string(model_prefault_threads) + " for model '" + Name() + "'").c_str());
+
+            // model_decompress_threads, threads decompress frames of .zst om file in parallel
+            int model_decompress_threads = 0;
+            err = ParseIntParameter(params, "model_decompress_threads", &model_decompress_threads);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            if (0 > model_decompress_threads)
+            {
+                return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, 
+                    (std::string("model_decompress_threads should not be negative for model '") + Name() + "'").c_str());
+            }
+            acl_config_.model_decompress_threads = model_decompress_threads;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("model_decompress_threads is ") + 
+                std::to_string(model_decompress_threads) + " for model '" + Name() + "'").c_str());
+
+            // data_parallel_device_ids, such as "0,1,2,3", instance split batch across these devices
+            std::vector<int> data_parallel_device_ids;
+            err = ParseIntListParameter(params, "data_parallel_device_ids", data_parallel_device_ids);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            data_parallel_device_ids_ = data_parallel_device_ids;
+            std::string device_ids_str;
+            for (auto device_id : data_parallel_device_ids)
+                device_ids_str += ("" == device_ids_str ? "" : ",") + std::to_string(device_id);
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("data_parallel_device_ids is '") + 
+                device_ids_str + "' for model '" + Name() + "'").c_str());
+
+            // pipeline_sub_batch_size, large batch is split into sub batches of this size on request boundary
+            int pipeline_sub_batch_size = 0;
+            err = ParseIntParameter(params, "pipeline_sub_batch_size", &pipeline_sub_batch_size);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            if (0 > pipeline_sub_batch_size)
+            {
+                return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, 
+                    (std::string("pipeline_sub_batch_size should not be negative for model '") + Name() + "'").c_str());
+            }
+            pipeline_sub_batch_size_ = pipeline_sub_batch_size;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("pipeline_sub_batch_size is ") + 
+                std::to_string(pipeline_sub_batch_size) + " for model '" + Name() + "'").c_str());
+
+            // parallel_instance_load, engines of all instances are loaded concurrently when first instance is created
+            bool parallel_instance_load = true;
+            err = ParseBoolParameter(params, "parallel_instance_load", &parallel_instance_load);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            parallel_instance_load_ = parallel_instance_load;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("parallel_instance_load is ") + 
+                std::to_string(parallel_instance_load) + " for model '" + Name() + "'").c_str());
+
+            // warmup, engine executes every compiled gear with synthetic inputs after model loaded
+            bool warmup = false;
+            err = ParseBoolParameter(params, "warmup", &warmup);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            acl_config_.warmup = warmup;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("warmup is ") + 
+                std::to_string(warmup) + " for model '" + Name() + "'").c_str());
+
+            // warmup_iterations, executes of each gear when warmup
+            int warmup_iterations = acl_config_.warmup_iterations;
+            err = ParseIntParameter(params, "warmup_iterations", &warmup_iterations);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            if (0 >= warmup_iterations)
+            {
+                return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, 
+                    (std::string("warmup_iterations should be positive for model '") + Name() + "'").c_str());
+            }
+            acl_config_.warmup_iterations = warmup_iterations;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("warmup_iterations is ") + 
+                std::to_string(warmup_iterations) + " for model '" + Name() + "'").c_str());
+
+            // share_device_context, engines of a device share one context, each engine has its own stream
+            bool share_device_context = true;
+            err = ParseBoolParameter(params, "share_device_context", &share_device_context);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            acl_config_.share_device_context = share_device_context;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("share_device_context is ") + 
+                std::to_string(share_device_context) + " for model '" + Name() + "'").c_str());
+
+            // version_swap, changed model file is loaded in background and all instances swap engines without unload
+            bool version_swap = false;
+            err = ParseBoolParameter(params, "version_swap", &version_swap);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            version_swap_ = version_swap;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("version_swap is ") + 
+                std::to_string(version_swap) + " for model '" + Name() + "'").c_str());
+
+            // version_swap_check_ms, interval instances check model file changed
+            int version_swap_check_ms = version_swap_check_ms_;
+            err = ParseIntParameter(params, "version_swap_check_ms", &version_swap_check_ms);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            if (0 >= version_swap_check_ms)
+            {
+                return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, 
+                    (std::string("version_swap_check_ms should be positive for model '") + Name() + "'").c_str());
+            }
+            version_swap_check_ms_ = version_swap_check_ms;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("version_swap_check_ms is ") + 
+                std::to_string(version_swap_check_ms) + " for model '" + Name() + "'").c_str());
+
+            // async_unload, engines of finalized or swapped out instances are unloaded on background thread
+            bool async_unload = true;
+            err = ParseBoolParameter(params, "async_unload", &async_unload);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            async_unload_ = async_unload;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("async_unload is ") + 
+                std::to_string(async_unload) + " for model '" + Name() + "'").c_str());
+
+            // device_placement, triton: engine runs on triton's device, check: refuse load early when model
+            // memory does not fit triton's devices, least_loaded: instance placed on device with most memory left
+            std::string device_placement = "triton";
+            err = ParseStrParameter(params, "device_placement", device_placement);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            if ("triton" != device_placement && "check" != device_placement && "least_loaded" != device_placement)
+            {
+                return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, 
+                    (std::string("device_placement should be triton/check/least_loaded for model '") + Name() + "'").c_str());
+            }
+            device_placement_ = device_placement;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("device_placement is ") + 
+                device_placement + " for model '" + Name() + "'").c_str());
+
+            // placement_device_ids, such as "0,1", devices least_loaded placement chooses from, default all devices
+            std::vector<int> placement_device_ids;
+            err = ParseIntListParameter(params, "placement_device_ids", placement_device_ids);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            placement_device_ids_ = placement_device_ids;
+            std::string placement_ids_str;
+            for (auto device_id : placement_device_ids)
+                placement_ids_str += ("" == placement_ids_str ? "" : ",") + std::to_string(device_id);
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("placement_device_ids is '") + 
+                placement_ids_str + "' for model '" + Name() + "'").c_str());
+
+            // placement_extra_mb, device memory of instance besides model memory, such as io buffers
+            int placement_extra_mb = 0;
+            err = ParseIntParameter(params, "placement_extra_mb", &placement_extra_mb);
+            if (err != nullptr)
+            {
+                if (TRITONSERVER_ERROR_NOT_FOUND != TRITONSERVER_ErrorCode(err))
+                    return err;
+                else
+                    TRITONSERVER_ErrorDelete(err);
+            }
+            if (0 > placement_extra_mb)
+            {
+                return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INVALID_ARG, 
+                    (std::string("placement_extra_mb should not be negative for model '") + Name() + "'").c_str());
+            }
+            placement_extra_bytes_ = (size_t)placement_extra_mb << 20;
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("placement_extra_mb is ") + 
+                std::to_string(placement_extra_mb) + " for model '" + Name() + "'").c_str());
         }
 
         return nullptr;
     }
 
+    TRITONSERVER_Error* ModelState::DetermineModelPath(const std::string& model_dir, std::string* model_path, 
+        std::string* config_path)
+    {
+        bool config_exists = true;
+        std::string config_file_path = JoinPath({model_dir, "model.txt"});
+        RETURN_IF_ERROR(FileExists(config_file_path, &config_exists));
+        if (not config_exists)
+        {
+            LOG_MESSAGE(TRITONSERVER_LOG_WARN, ("cannot find model config " + config_file_path).c_str());
+        }
+        else
+            *config_path = config_file_path;
+
+        // check mindspore lite model file exist
+        bool mindir_exists = false;
+        bool ms_exists = false;
+        std::string mindir_file_path = JoinPath({model_dir, "model.mindir"});
+        std::string ms_file_path = JoinPath({model_dir, "model.ms"});
+        RETURN_IF_ERROR(FileExists(mindir_file_path, &mindir_exists));
+        RETURN_IF_ERROR(FileExists(ms_file_path, &ms_exists));
+        // zstd compressed model file is used when uncompressed one not exists
+        if (not mindir_exists)
+        {
+            RETURN_IF_ERROR(FileExists(mindir_file_path + ".zst", &mindir_exists));
+            if (mindir_exists)
+                mindir_file_path += ".zst";
+        }
+        if (not ms_exists)
+        {
+            RETURN_IF_ERROR(FileExists(ms_file_path + ".zst", &ms_exists));
+            if (ms_exists)
+                ms_file_path += ".zst";
+        }
+        if (not mindir_exists && not ms_exists)
+        {
+            return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_NOT_FOUND, 
+                std::string("acl model should be named as 'model.mindir or model.ms', optionally with .zst suffix").c_str());
+        }
+        if (mindir_exists && ms_exists)
+        {
+            LOG_MESSAGE(TRITONSERVER_LOG_WARN, "model.mindir and model.ms both exists, model.mindir will be used");
+        }
+        *model_path = mindir_exists ? mindir_file_path : ms_file_path;
+
+        return nullptr;
+    }
+
+    bool ModelState::ExpectedInstanceDeviceIds(std::vector<int>* device_ids)
+    {
+        // triton normalizes gpus of KIND_GPU group, instances of other kinds are created on device 0
+        device_ids->clear();
+        triton::common::TritonJson::Value instance_groups;
+        if (!ModelConfig().Find("instance_group", &instance_groups))
+            return false;
+        for (size_t i = 0; i < instance_groups.ArraySize(); i++)
+        {
+            triton::common::TritonJson::Value instance_group;
+            if (nullptr != instance_groups.IndexAsObject(i, &instance_group))
+                return false;
+            int64_t count = 1;
+            LOG_IF_ERROR(instance_group.MemberAsInt("count", &count), "failed to get instance group count");
+            std::string kind;
+            LOG_IF_ERROR(instance_group.MemberAsString("kind", &kind), "failed to get instance group kind");
+            triton::common::TritonJson::Value gpus;
+            if (instance_group.Find("gpus", &gpus) && 0 < gpus.ArraySize())
+            {
+                // triton creates count instances on each gpu of group
+                for (size_t j = 0; j < gpus.ArraySize(); j++)
+                {
+                    int64_t gpu = 0;
+                    if (nullptr != gpus.IndexAsInt(j, &gpu))
+                        return false;
+                    for (int64_t k = 0; k < count; k++)
+                        device_ids->push_back(gpu);
+                }
+            }
+            else if ("KIND_GPU" == kind)
+                return false;
+            else
+            {
+                for (int64_t k = 0; k < count; k++)
+                    device_ids->push_back(0);
+            }
+        }
+        return true;
+    }
+
+    size_t ModelState::ExpectedInstanceCount()
+    {
+        // 0 means instance count is unknown
+        std::vector<int> device_ids;
+        if (!ExpectedInstanceDeviceIds(&device_ids))
+            return 0;
+        return device_ids.size();
+    }
+
+    void ModelState::InstanceLoaded()
+    {
+        std::lock_guard<std::mutex> lock(model_file_mutex_);
+        loaded_instance_count_++;
+        if (nullptr != model_file_ && 0 < expected_instance_count_ && loaded_instance_count_ >= expected_instance_count_)
+        {
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("all ") + std::to_string(loaded_instance_count_) + 
+                " instances loaded, release shared model file of model '" + Name() + "'").c_str());
+            model_file_.reset();
+            model_file_pinned_ = false;
+        }
+    }
+
+    void ModelState::ReleaseModelFile()
+    {
+        // model is ready once requests arrive, model file is not needed by instances any more
+        if (!model_file_pinned_)
+            return;
+        std::lock_guard<std::mutex> lock(model_file_mutex_);
+        model_file_.reset();
+        model_file_pinned_ = false;
+    }
+
+    ACL_ENGINE::EngineConfig ModelState::InstanceEngineConfig(int device_id)
+    {
+        ACL_ENGINE::EngineConfig engine_config = acl_config_;
+        // overwrite device id
+        if (-1 == engine_config.device_id)
+        {
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, ("overwrite device id to " + std::to_string(device_id)).c_str());
+            engine_config.device_id = device_id;
+        }
+        // model name used by device scheduler to account device time
+        engine_config.model_name = Name();
+        // polling instances are spread over configured host cores
+        if ("blocking" != engine_config.sync_mode)
+            engine_config.sync_cpu_core = NextSyncCpuCore();
+        // outputs are copied back to pinned buffers when backend pinned pool is enabled
+        engine_config.pinned_output = EnablePinnedOutput() && ACL_ENGINE::PinnedHostPool::Instance().enabled();
+        // overwrite config path
+        if ("" == engine_config.config_file && "" != config_path_)
+        {
+            LOG_MESSAGE(TRITONSERVER_LOG_INFO, ("overwrite acl config file to " + config_path_).c_str());
+            engine_config.config_file = config_path_;
+        }
+        // overwrite model type by model file postfix
+        // if model ends with ".mindir" then model_type set kmindir or else set kmindir_lite
+        std::string file_postfix = ".mindir";
+        if (model_path_.rfind(file_postfix) == (model_path_.length() - file_postfix.length()))
+            engine_config.model_type = "kmindir";
+        else
+            engine_config.model_type = "kmindir_lite";
+        return engine_config;
+    }
+
+    void ModelState::PrepareEngines()
+    {
+        engines_prepared_ = true;
+        // data parallel instances own shard engines, single instance gains nothing from loading ahead
+        std::vector<int> device_ids;
+        if (!parallel_instance_load_ || 0 != data_parallel_device_ids_.size() || 
+            !ExpectedInstanceDeviceIds(&device_ids) || 1 >= device_ids.size())
+            return;
+        // engines are loaded on planned devices, which instances take in same order
+        {
+            std::lock_guard<std::mutex> lock(placement_mutex_);
+            if (placed_device_ids_.size() == device_ids.size())
+                device_ids = placed_device_ids_;
+        }
+
+        LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("load ") + std::to_string(device_ids.size()) + 
+            " instance engines of model '" + Name() + "' concurrently").c_str());
+        prepare_pool_.reset(new ACL_ENGINE::ThreadPool(device_ids.size()));
+        std::vector<std::string> model_files = {model_path_};
+        for (auto device_id : device_ids)
+        {
+            // configs are built in instance order, so polling instances get sync cores in same order as before
+            ACL_ENGINE::EngineConfig engine_config = InstanceEngineConfig(device_id);
+            auto result = prepare_pool_->enqueue([engine_config, model_files]() {
+                std::shared_ptr<ACL_ENGINE::AscendCLEngine> engine(new ACL_ENGINE::AscendCLEngine(engine_config, model_files));
+                return engine;
+            });
+            prepared_engines_[engine_config.device_id].push_back(std::move(result));
+        }
+    }
+
+    std::shared_ptr<ACL_ENGINE::AscendCLEngine> ModelState::TakePreparedEngine(int device_id)
+    {
+        std::future<std::shared_ptr<ACL_ENGINE::AscendCLEngine>> result;
+        std::unique_ptr<ACL_ENGINE::ThreadPool> finished_pool;
+        {
+            std::lock_guard<std::mutex> lock(prepared_engines_mutex_);
+            if (!engines_prepared_)
+                PrepareEngines();
+            auto iter = prepared_engines_.find(EngineDeviceId(device_id));
+            if (prepared_engines_.end() == iter || 0 == iter->second.size())
+                return nullptr;
+            result = std::move(iter->second.front());
+            iter->second.pop_front();
+            if (0 == iter->second.size())
+                prepared_engines_.erase(iter);
+            // last prepared engine is taken, loading threads are joined after it is ready
+            if (0 == prepared_engines_.size())
+                finished_pool = std::move(prepare_pool_);
+        }
+
+        // wait engine of this instance only, engines of other devices keep loading in background
+        std::shared_ptr<ACL_ENGINE::AscendCLEngine> engine;
+        if (result.valid())
+            engine = result.get();
+        finished_pool.reset();
+        if (nullptr == engine || false == engine->status())
+        {
+            LOG_MESSAGE(TRITONSERVER_LOG_WARN, (std::string("prepared engine of model '") + Name() + 
+                "' on device " + std::to_string(EngineDeviceId(device_id)) + " load fail, instance will load it by itself").c_str());
+            return nullptr;
+        }
+        return engine;
+    }
+
+    bool ModelState::RegisterSwapInstance(const void* instance, const std::shared_ptr<ACL_ENGINE::AscendCLEngine>& engine, 
+        uint64_t* generation)
+    {
+        std::lock_guard<std::mutex> lock(swap_mutex_);
+        if (!swap_file_stamped_)
+        {
+            if (0 != ACL_ENGINE::statFileStamp(model_path_, model_file_stamp_))
+            {
+                LOG_MESSAGE(TRITONSERVER_LOG_WARN, (std::string("stat model file ") + model_path_ + 
+                    " fail, version swap is disabled for model '" + Name() + "'").c_str());
+                return false;
+            }
+            pending_file_stamp_ = model_file_stamp_;
+            swap_file_stamped_ = true;
+            engine->getInputTensorInfos(swap_input_infos_);
+            engine->getOutputTensorInfos(swap_output_infos_);
+            swap_pool_.reset(new ACL_ENGINE::ThreadPool(1));
+        }
+        swap_instances_[instance] = engine->getEngineConfig();
+        *generation = committed_generation_;
+        return true;
+    }
+
+    void ModelState::UnregisterSwapInstance(const void* instance)
+    {
+        std::vector<std::shared_ptr<ACL_ENGINE::AscendCLEngine>> released;
+        {
+            std::lock_guard<std::mutex> lock(swap_mutex_);
+            swap_instances_.erase(instance);
+            auto iter = swap_engines_.find(instance);
+            if (swap_engines_.end() != iter)
+            {
+                released.push_back(std::move(iter->second));
+                swap_engines_.erase(iter);
+            }
+            iter = loading_engines_.find(instance);
+            if (loading_engines_.end() != iter)
+            {
+                released.push_back(std::move(iter->second));
+                loading_engines_.erase(iter);
+            }
+            // generation waits for remaining instances only
+            if (0 != swap_pending_.erase(instance) && 0 == swap_pending_.size())
+                FinishSwapGeneration(released);
+        }
+        for (auto& engine : released)
+            ReleaseSwapEngine(std::move(engine));
+    }
+
+    void ModelState::CheckModelFile()
+    {
+        std::lock_guard<std::mutex> lock(swap_mutex_);
+        // one generation loads at a time, file changed meanwhile is picked up after it finishes
+        if (!swap_file_stamped_ || swap_loading_)
+            return;
+        uint64_t now_ns = 0;
+        SET_TIMESTAMP(now_ns);
+        if (now_ns - last_swap_check_ns_ < (uint64_t)version_swap_check_ms_ * 1000000)
+            return;
+        last_swap_check_ns_ = now_ns;
+        ACL_ENGINE::FileStamp stamp;
+        if (0 != ACL_ENGINE::statFileStamp(model_path_, stamp) || stamp == model_file_stamp_)
+            return;
+        // file may still be copied, load it after it stays unchanged for one check interval
+        if (stamp != pending_file_stamp_)
+        {
+            pending_file_stamp_ = stamp;
+            return;
+        }
+
+        // new engines are loaded with same config as engines of instances, which keep serving until all are ready
+        model_file_stamp_ = stamp;
+        swap_generation_++;
+        swap_loading_ = true;
+        swap_failed_ = false;
+        LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("model file ") + model_path_ + " changed, load it for " + 
+            std::to_string(swap_instances_.size()) + " instances of model '" + Name() + "' in background").c_str());
+        for (auto& item : swap_instances_)
+        {
+            const void* instance = item.first;
+            ACL_ENGINE::EngineConfig engine_config = item.second;
+            uint64_t generation = swap_generation_;
+            swap_pending_.insert(instance);
+            swap_pool_->enqueue([this, instance, engine_config, generation]() {
+                LoadSwapEngine(instance, engine_config, generation);
+            });
+        }
+        if (0 == swap_pending_.size())
+            swap_loading_ = false;
+    }
+
+    void ModelState::LoadSwapEngine(const void* instance, const ACL_ENGINE::EngineConfig& engine_config, uint64_t generation)
+    {
+        std::vector<std::string> model_files = {model_path_};
+        std::shared_ptr<ACL_ENGINE::AscendCLEngine> engine(new ACL_ENGINE::AscendCLEngine(engine_config, model_files));
+        bool loaded = (nullptr != engine && engine->status());
+        std::vector<std::shared_ptr<ACL_ENGINE::AscendCLEngine>> released;
+        {
+            std::lock_guard<std::mutex> lock(swap_mutex_);
+            // instance is gone while its engine loads
+            if (generation != swap_generation_ || 0 == swap_pending_.erase(instance))
+            {
+                released.push_back(std::move(engine));
+            }
+            else if (!loaded || !MatchSwapSignature(engine))
+            {
+                LOG_MESSAGE(TRITONSERVER_LOG_ERROR, (std::string("changed model file ") + model_path_ + 
+                    (loaded ? " has other inputs or outputs" : " load fail") + " on device " + 
+                    std::to_string(engine_config.device_id) + ", model '" + Name() + "' keeps current version").c_str());
+                swap_failed_ = true;
+                released.push_back(std::move(engine));
+            }
+            else
+            {
+                loading_engines_[instance] = std::move(engine);
+            }
+            if (generation == swap_generation_ && swap_loading_ && 0 == swap_pending_.size())
+                FinishSwapGeneration(released);
+        }
+        for (auto& released_engine : released)
+            ReleaseSwapEngine(std::move(released_engine));
+    }
+
+    void ModelState::FinishSwapGeneration(std::vector<std::shared_ptr<ACL_ENGINE::AscendCLEngine>>& released)
+    {
+        swap_loading_ = false;
+        if (swap_failed_ || 0 == loading_engines_.size())
+        {
+            for (auto& item : loading_engines_)
+                released.push_back(std::move(item.second));
+            loading_engines_.clear();
+            return;
+        }
+        // engines of older generation not taken by idle instances are replaced
+        for (auto& item : loading_engines_)
+        {
+            auto& swap_engine = swap_engines_[item.first];
+            if (nullptr != swap_engine)
+                released.push_back(std::move(swap_engine));
+            swap_engine = std::move(item.second);
+        }
+        loading_engines_.clear();
+        committed_generation_ = swap_generation_;
+        LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("changed model file ") + model_path_ + 
+            " is loaded for all instances of model '" + Name() + "', swap generation " + 
+            std::to_string(committed_generation_) + " is committed").c_str());
+    }
+
+    bool ModelState::MatchSwapSignature(const std::shared_ptr<ACL_ENGINE::AscendCLEngine>& engine)
+    {
+        std::vector<ACL_ENGINE::EngineTensorInfo> input_infos;
+        std::vector<ACL_ENGINE::EngineTensorInfo> output_infos;
+        if (0 != engine->getInputTensorInfos(input_infos) || 0 != engine->getOutputTensorInfos(output_infos))
+            return false;
+        auto match = [](const std::vector<ACL_ENGINE::EngineTensorInfo>& lhs, 
+            const std::vector<ACL_ENGINE::EngineTensorInfo>& rhs) {
+            if (lhs.size() != rhs.size())
+                return false;
+            for (size_t index = 0; index < lhs.size(); index++)
+            {
+                if (lhs[index].name != rhs[index].name || lhs[index].type != rhs[index].type || 
+                    lhs[index].shape != rhs[index].shape)
+                    return false;
+            }
+            return true;
+        };
+        return match(swap_input_infos_, input_infos) && match(swap_output_infos_, output_infos);
+    }
+
+    std::shared_ptr<ACL_ENGINE::AscendCLEngine> ModelState::TakeSwapEngine(const void* instance, uint64_t* generation)
+    {
+        std::lock_guard<std::mutex> lock(swap_mutex_);
+        if (committed_generation_ == *generation)
+            return nullptr;
+        *generation = committed_generation_;
+        std::shared_ptr<ACL_ENGINE::AscendCLEngine> engine;
+        auto iter = swap_engines_.find(instance);
+        if (swap_engines_.end() != iter)
+        {
+            engine = std::move(iter->second);
+            swap_engines_.erase(iter);
+        }
+        return engine;
+    }
+
+    void ModelState::ReleaseSwapEngine(std::shared_ptr<ACL_ENGINE::AscendCLEngine> engine)
+    {
+        if (nullptr == engine)
+            return;
+        // engine unload runs on releaser thread unless unload is synchronous
+        if (async_unload_)
+            ACL_ENGINE::EngineReleaser::Instance().release(std::move(engine));
+    }
+
+    TRITONSERVER_Error* ModelState::PlanPlacement(const std::vector<int>& triton_device_ids)
+    {
+        auto& planner = ACL_ENGINE::CapacityPlanner::Instance();
+        // model memory is queried once, from shared mapping when model file is mapped
+        if (!memory_queried_)
+        {
+            std::shared_ptr<ACL_ENGINE::FileInputStream> model_file;
+            {
+                std::lock_guard<std::mutex> lock(model_file_mutex_);
+                model_file = model_file_;
+            }
+            const char* model_data = (nullptr != model_file) ? model_file->getFileData() : nullptr;
+            size_t data_len = (nullptr != model_file) ? model_file->getFileSize() : 0;
+            if (0 != planner.queryModelMemory(model_data, data_len, model_path_, memory_requirement_))
+            {
+                return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INTERNAL, 
+                    (std::string("query device memory of model '") + Name() + "' from " + model_path_ + " fail").c_str());
+            }
+            memory_requirement_.extra_bytes = placement_extra_bytes_;
+            memory_requirement_.workspace_group = acl_config_.workspace_group;
+            memory_queried_ = true;
+        }
+
+        // least_loaded chooses among eligible devices, check keeps instances on devices triton gives
+        bool least_loaded = ("least_loaded" == device_placement_);
+        std::vector<int> device_ids;
+        if (least_loaded && -1 != acl_config_.device_id)
+            device_ids.push_back(acl_config_.device_id);
+        else if (least_loaded && 0 != placement_device_ids_.size())
+            device_ids = placement_device_ids_;
+        else if (least_loaded && 0 != planner.getDeviceIds(device_ids))
+            return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_INTERNAL, "get device ids for instance placement fail");
+        else if (!least_loaded)
+        {
+            for (auto device_id : triton_device_ids)
+                device_ids.push_back(EngineDeviceId(device_id));
+        }
+
+        std::vector<int> instance_device_ids;
+        std::vector<size_t> instance_bytes;
+        std::string report;
+        if (0 != planner.planInstances(memory_requirement_, device_ids, triton_device_ids.size(), least_loaded, 
+            instance_device_ids, instance_bytes, report))
+        {
+            return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_UNAVAILABLE, (std::string("not enough device memory for ") + 
+                std::to_string(triton_device_ids.size()) + " instances of model '" + Name() + "', " + report).c_str());
+        }
+        LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("placement of model '") + Name() + "': " + report).c_str());
+        for (size_t index = 0; index < instance_device_ids.size(); index++)
+        {
+            planned_placements_.push_back(std::make_pair(instance_device_ids[index], instance_bytes[index]));
+            placed_device_ids_.push_back(instance_device_ids[index]);
+        }
+        return nullptr;
+    }
+
+    TRITONSERVER_Error* ModelState::PlaceInstance(int device_id, int* engine_device_id, size_t* planned_bytes)
+    {
+        *engine_device_id = EngineDeviceId(device_id);
+        *planned_bytes = 0;
+        if ("triton" == device_placement_ || 0 != data_parallel_device_ids_.size())
+            return nullptr;
+
+        std::lock_guard<std::mutex> lock(placement_mutex_);
+        // instance count unknown ahead or more instances than planned, plan this instance alone
+        if (0 == planned_placements_.size())
+            RETURN_IF_ERROR(PlanPlacement({device_id}));
+        auto iter = planned_placements_.begin();
+        if ("check" == device_placement_)
+        {
+            iter = std::find_if(planned_placements_.begin(), planned_placements_.end(), 
+                [&](const std::pair<int, size_t>& placement) { return placement.first == *engine_device_id; });
+            if (planned_placements_.end() == iter)
+            {
+                RETURN_IF_ERROR(PlanPlacement({device_id}));
+                iter = std::find_if(planned_placements_.begin(), planned_placements_.end(), 
+                    [&](const std::pair<int, size_t>& placement) { return placement.first == *engine_device_id; });
+            }
+            if (planned_placements_.end() == iter)
+            {
+                // plan of this instance went to another device, give its bytes back before fail
+                if (0 != planned_placements_.size())
+                {
+                    ReleasePlacement(planned_placements_.back().first, planned_placements_.back().second);
+                    planned_placements_.pop_back();
+                    placed_device_ids_.pop_back();
+                }
+                return TRITONSERVER_ErrorNew(TRITONSERVER_ERROR_UNAVAILABLE, (std::string("device ") + 
+                    std::to_string(*engine_device_id) + " has not enough memory for an instance of model '" + 
+                    Name() + "'").c_str());
+            }
+        }
+        *engine_device_id = iter->first;
+        *planned_bytes = iter->second;
+        planned_placements_.erase(iter);
+        LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("instance of model '") + Name() + "' on triton device " + 
+            std::to_string(device_id) + " is placed on device " + std::to_string(*engine_device_id)).c_str());
+        return nullptr;
+    }
+
+    void ModelState::ReleasePlacement(int engine_device_id, size_t planned_bytes)
+    {
+        if (0 < planned_bytes)
+            ACL_ENGINE::CapacityPlanner::Instance().releasePlanned(engine_device_id, planned_bytes);
+    }
+
+    int ModelState::NextSyncCpuCore()
+    {
+        if (0 == sync_cpu_cores_.size())
+            return -1;
+        return sync_cpu_cores_[sync_cpu_core_index_++ % sync_cpu_cores_.size()];
+    }
+
     ModelState::ModelState(TRITONBACKEND_Model* triton_model) : BackendModel(triton_model)
     {
         THROW_IF_BACKEND_MODEL_ERROR(ValidateModelConfig());
         THROW_IF_BACKEND_MODEL_ERROR(ParseParameters());
+
+        // get acl model and config file path
+        auto model_dir = JoinPath({RepositoryPath(), std::to_string(Version())});
+        THROW_IF_BACKEND_MODEL_ERROR(DetermineModelPath(model_dir, &model_path_, &config_path_));
+
+        // model file is mapped once and shared by engines of all instances until they are loaded,
+        // so it is read only once from model repository, compressed file is also decompressed only once
+        if ("mmap" == acl_config_.model_load_mode || ACL_ENGINE::isZstdFile(model_path_))
+        {
+            // with io throttled by load scheduler, file is read in while holding io slot
+            ACL_ENGINE::ModelReadGuard read_guard(model_path_);
+            ACL_ENGINE::FileMapConfig map_config;
+            map_config.populate = acl_config_.model_map_populate || 
+                (ACL_ENGINE::ModelLoadScheduler::Instance().throttleIo() && 0 >= acl_config_.model_prefault_threads);
+            map_config.prefault_threads = acl_config_.model_prefault_threads;
+            map_config.decompress_threads = acl_config_.model_decompress_threads;
+            model_file_ = ACL_ENGINE::MappedFileCache::Instance().acquire(model_path_, map_config);
+            if (nullptr == model_file_)
+            {
+                LOG_MESSAGE(TRITONSERVER_LOG_WARN, (std::string("map model file ") + model_path_ + 
+                    " fail, instances will load it by themselves").c_str());
+            }
+            else
+            {
+                LOG_MESSAGE(TRITONSERVER_LOG_INFO, (std::string("model file ") + model_path_ + " of " + 
+                    std::to_string(model_file_->getFileSize()) + " bytes mapped, io queue " + 
+                    std::to_string(read_guard.queueTimeNs() / 1000) + "us, read " + 
+                    std::to_string(read_guard.elapsedNs() / 1000) + "us").c_str());
+            }
+            model_file_pinned_ = (nullptr != model_file_);
+            expected_instance_count_ = ExpectedInstanceCount();
+        }
+
+        // instances are planned by device memory before any of them loads, so model which can not fit
+        // is refused here, instances are planned one by one when their count is unknown ahead
+        if ("triton" != device_placement_ && 0 != data_parallel_device_ids_.size())
+        {
+            LOG_MESSAGE(TRITONSERVER_LOG_WARN, (std::string("device_placement is ignored by data parallel model '") + 
+                Name() + "'").c_str());
+        }
+        else if ("triton" != device_placement_)
+        {
+            std::vector<int> device_ids;
+            std::lock_guard<std::mutex> lock(placement_mutex_);
+            if (ExpectedInstanceDeviceIds(&device_ids) && 0 != device_ids.size())
+                THROW_IF_BACKEND_MODEL_ERROR(PlanPlacement(device_ids));
+        }
+    }
+
+    ModelState::~ModelState()
+    {
+        // loads of swap worker finish before engines they may store are released
+        swap_pool_.reset();
+        for (auto& item : loading_engines_)
+            ReleaseSwapEngine(std::move(item.second));
+        for (auto& item : swap_engines_)
+            ReleaseSwapEngine(std::move(item.second));
+        // instances never created keep nothing planned
+        for (auto& placement : planned_placements_)
+            ReleasePlacement(placement.first, placement.second);
+        planned_placements_.clear();
     }
 
     TRITONSERVER_Error* ModelState::AutoCompleteConfig()
@@ -26,7 +26,16 @@
 #pragma once
 #include "triton/backend/backend_common.h"
 #include "triton/backend/backend_model.h"
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <set>
+#include <future>
 #include "acl_engine/engine_type.h"
+#include "acl_engine/file_stream.h"
+#include "acl_engine/acl_engine.h"
+#include "acl_engine/thread_pool.h"
+#include "acl_engine/capacity_planner.h"
 
 namespace triton::backend::acl
 {
@@ -35,7 +44,7 @@ namespace triton::backend::acl
     {
     public:
         static TRITONSERVER_Error* Create(TRITONBACKEND_Model* triton_model, ModelState** state);
-        virtual ~ModelState() = default;
+        virtual ~ModelState();
         const std::vector<std::string>& InputNames() const { return input_names_; }
         const std::vector<std::string>& OutputNames() const { return output_names_; }
         const std::vector<TRITONSERVER_DataType>& InputDataTypes() const { return input_data_types_; }
@@ -43,6 +52,35 @@ namespace triton::backend::acl
         const std::vector<std::string>& InputFormats() const { return input_formats_; }
         const std::map<std::string, std::pair<int64_t, int64_t>>& ModelOutputs() { return model_outputs_; }
         const ACL_ENGINE::EngineConfig AclEngineConfig() { return acl_config_; }
+        const std::vector<int>& DataParallelDeviceIds() const { return data_parallel_device_ids_; }
+        int PipelineSubBatchSize() const { return pipeline_sub_batch_size_; }
+        int NextSyncCpuCore();
+        const std::string& ModelPath() const { return model_path_; }
+        const std::string& ModelConfigPath() const { return config_path_; }
+        // shared model file is released after last expected instance loaded or on first execute
+        void InstanceLoaded();
+        void ReleaseModelFile();
+        // engine config of instance created on triton device, device id of model config takes precedence
+        ACL_ENGINE::EngineConfig InstanceEngineConfig(int device_id);
+        int EngineDeviceId(int device_id) const { return (-1 == acl_config_.device_id) ? device_id : acl_config_.device_id; }
+        // engines of all expected instances are loaded concurrently when first instance takes its engine,
+        // return nullptr if engines are not prepared for device or prepared engine load fail
+        std::shared_ptr<ACL_ENGINE::AscendCLEngine> TakePreparedEngine(int device_id);
+        bool VersionSwap() const { return version_swap_; }
+        // instances taking part in version swap, changed model file is loaded for all registered instances
+        // and swap generation is committed only after every engine is loaded with same inputs and outputs,
+        // instances adopt committed engine before their next execute so they all switch to new version together
+        bool RegisterSwapInstance(const void* instance, const std::shared_ptr<ACL_ENGINE::AscendCLEngine>& engine, 
+            uint64_t* generation);
+        void UnregisterSwapInstance(const void* instance);
+        void CheckModelFile();
+        // engine of committed generation newer than instance's, nullptr if there is none
+        std::shared_ptr<ACL_ENGINE::AscendCLEngine> TakeSwapEngine(const void* instance, uint64_t* generation);
+        bool AsyncUnload() const { return async_unload_; }
+        // device engine of instance runs on, planned by device memory unless placement is triton,
+        // planned memory is released once instance engine is loaded
+        TRITONSERVER_Error* PlaceInstance(int device_id, int* engine_device_id, size_t* planned_bytes);
+        void ReleasePlacement(int engine_device_id, size_t planned_bytes);
 
     private:
         ModelState(TRITONBACKEND_Model* triton_model);
@@ -55,7 +93,20 @@ namespace triton::backend::acl
         TRITONSERVER_Error* ParseIntParameter(triton::common::TritonJson::Value& params, const std::string& mkey, int* value);
         TRITONSERVER_Error* ParseStrParameter(triton::common::TritonJson::Value& params, const std::string& mkey, std::string& value);
         TRITONSERVER_Error* ParseDoubleParameter(triton::common::TritonJson::Value& params, const std::string& mkey, double* value);
+        TRITONSERVER_Error* ParseIntListParameter(triton::common::TritonJson::Value& params, const std::string& mkey, std::vector<int>& value);
         TRITONSERVER_Error* ParseParameters();
+        TRITONSERVER_Error* DetermineModelPath(const std::string& model_dir, std::string* model_path, std::string* config_path);
+        size_t ExpectedInstanceCount();
+        bool ExpectedInstanceDeviceIds(std::vector<int>* device_ids);
+        void PrepareEngines();
+        // plan instances created on triton devices, called with placement mutex held
+        TRITONSERVER_Error* PlanPlacement(const std::vector<int>& triton_device_ids);
+        // called on swap worker, engine of changed model file for one instance of swap generation
+        void LoadSwapEngine(const void* instance, const ACL_ENGINE::EngineConfig& engine_config, uint64_t generation);
+        bool MatchSwapSignature(const std::shared_ptr<ACL_ENGINE::AscendCLEngine>& engine);
+        // called with swap mutex held once no instance of generation is loading, commit or drop its engines
+        void FinishSwapGeneration(std::vector<std::shared_ptr<ACL_ENGINE::AscendCLEngine>>& released);
+        void ReleaseSwapEngine(std::shared_ptr<ACL_ENGINE::AscendCLEngine> engine);
 
         // model_outputs is a map that contains unique outputs that the model must
         // provide. In the model configuration, the output in the state configuration
@@ -75,6 +126,62 @@ namespace triton::backend::acl
 
         // acl engine config
         ACL_ENGINE::EngineConfig                             acl_config_;
+        // devices one instance shards its batch across, empty means single device
+        std::vector<int>                                     data_parallel_device_ids_;
+        // max batch size of one pipelined sub batch, 0 means run whole batch at once
+        int                                                  pipeline_sub_batch_size_ = 0;
+        // host cores polling instances pinned to, assigned to instances in turn
+        std::vector<int>                                     sync_cpu_cores_;
+        std::atomic<size_t>                                  sync_cpu_core_index_{0};
+        // acl model and config file of current version
+        std::string                                          model_path_;
+        std::string                                          config_path_;
+        // mapped model file pinned while instances are loading, engines get same mapping from file cache
+        std::shared_ptr<ACL_ENGINE::FileInputStream>         model_file_;
+        std::mutex                                           model_file_mutex_;
+        std::atomic<bool>                                    model_file_pinned_{false};
+        size_t                                               expected_instance_count_ = 0;
+        size_t                                               loaded_instance_count_ = 0;
+        // engines loading ahead for instances, keyed by engine device id and taken in instance creating order
+        bool                                                 parallel_instance_load_ = true;
+        bool                                                 engines_prepared_ = false;
+        std::mutex                                           prepared_engines_mutex_;
+        std::map<int, std::deque<std::future<std::shared_ptr<ACL_ENGINE::AscendCLEngine>>>> prepared_engines_;
+        std::unique_ptr<ACL_ENGINE::ThreadPool>              prepare_pool_;
+        // changed model file is loaded for instances in background and swapped in
+        bool                                                 version_swap_ = false;
+        int                                                  version_swap_check_ms_ = 5000;
+        bool                                                 async_unload_ = true;
+        std::mutex                                           swap_mutex_;
+        bool                                                 swap_file_stamped_ = false;
+        ACL_ENGINE::FileStamp                                model_file_stamp_;
+        ACL_ENGINE::FileStamp                                pending_file_stamp_;
+        uint64_t                                             last_swap_check_ns_ = 0;
+        // inputs and outputs of serving engines, new engine with other signature is refused
+        std::vector<ACL_ENGINE::EngineTensorInfo>            swap_input_infos_;
+        std::vector<ACL_ENGINE::EngineTensorInfo>            swap_output_infos_;
+        std::map<const void*, ACL_ENGINE::EngineConfig>      swap_instances_;
+        // generation being loaded with instances still loading, and engines loaded for it so far,
+        // committed engines wait for their instances to take them
+        uint64_t                                             swap_generation_ = 0;
+        uint64_t                                             committed_generation_ = 0;
+        bool                                                 swap_loading_ = false;
+        bool                                                 swap_failed_ = false;
+        std::set<const void*>                                swap_pending_;
+        std::map<const void*, std::shared_ptr<ACL_ENGINE::AscendCLEngine>> loading_engines_;
+        std::map<const void*, std::shared_ptr<ACL_ENGINE::AscendCLEngine>> swap_engines_;
+        // instance placement by device memory of model
+        std::string                                          device_placement_ = "triton";
+        std::vector<int>                                     placement_device_ids_;
+        size_t                                               placement_extra_bytes_ = 0;
+        bool                                                 memory_queried_ = false;
+        ACL_ENGINE::ModelMemoryRequirement                   memory_requirement_;
+        std::mutex                                           placement_mutex_;
+        // planned devices in instance order, and placements not taken by instances yet
+        std::vector<int>                                     placed_device_ids_;
+        std::deque<std::pair<int, size_t>>                   planned_placements_;
+        // swap worker is joined first on destroy, its loads use members above
+        std::unique_ptr<ACL_ENGINE::ThreadPool>              swap_pool_;
     };
 
 } // namespace triton::backend::acl
\ No newline at end of file